@@ -0,0 +1,276 @@
+#include "CorpusGenerator.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+const char* kWords[] = {"value", "count", "total", "index", "limit", "result", "buffer", "offset",
+                        "weight", "score",  "delta", "step",  "level", "width",  "height", "depth",
+                        "cursor", "accum",  "sum",   "prod",  "lower", "upper",  "pivot",  "carry"};
+const int kWordCount = sizeof(kWords) / sizeof(kWords[0]);
+
+const char* kVerbs[] = {"compute", "update", "reduce", "scan", "merge", "split", "apply", "check",
+                        "build",   "count",  "fold",   "walk", "find",  "sort",  "clamp", "mix"};
+const int kVerbCount = sizeof(kVerbs) / sizeof(kVerbs[0]);
+
+const int kVariables = 6;  // slots per function, parameters first
+
+std::string slot(int n) {
+    return "@" + std::to_string(n);
+}
+}  // namespace
+
+CorpusGenerator::CorpusGenerator(const GeneratorOptions& options) : opts(options), random(options.seed) {
+    opts.functions = std::max(1, opts.functions);
+    opts.statements = std::max(1, opts.statements);
+}
+
+const char* CorpusGenerator::kindName(VariantKind kind) {
+    switch (kind) {
+        case VariantKind::Original: return "original";
+        case VariantKind::Renamed: return "renamed";
+        case VariantKind::Reordered: return "reordered";
+        case VariantKind::Inserted: return "inserted";
+        case VariantKind::Independent: return "independent";
+    }
+    return "";
+}
+
+int CorpusGenerator::pick(int bound) {
+    return static_cast<int>(random() % static_cast<std::uint64_t>(bound));
+}
+
+std::string CorpusGenerator::expression(int variables, int depth) {
+    static const char* kOperators[] = {" + ", " - ", " * ", " / ", " % "};
+    int choice = pick(depth > 1 ? 2 : 4);
+    if (choice == 0) {
+        return std::to_string(1 + pick(16));
+    }
+    if (choice == 1) {
+        return slot(pick(variables));
+    }
+    std::string left = expression(variables, depth + 1);
+    std::string right = expression(variables, depth + 1);
+    std::string text = left + kOperators[pick(choice == 2 ? 3 : 5)] + right;
+    return choice == 3 ? "(" + text + ")" : text;
+}
+
+CorpusGenerator::Node CorpusGenerator::simple(std::string head) {
+    Node node;
+    node.head = std::move(head);
+    return node;
+}
+
+CorpusGenerator::Node CorpusGenerator::statement(int variables, int depth) {
+    static const char* kCompare[] = {" < ", " > ", " <= ", " != ", " == "};
+    Node node;
+    int choice = depth >= 2 ? pick(4) : pick(9);
+    std::string target = slot(pick(variables));
+
+    auto fill = [&](std::vector<Node>& body) {
+        int count = 1 + pick(3);
+        for (int i = 0; i < count; i++) {
+            body.push_back(statement(variables, depth + 1));
+        }
+    };
+
+    switch (choice) {
+        case 0:
+        case 1:
+            node.head = target + " = " + expression(variables, 0) + ";";
+            break;
+        case 2:
+            node.head = target + (pick(2) ? " += " : " -= ") + expression(variables, 1) + ";";
+            break;
+        case 3:
+            node.head = target + (pick(2) ? "++;" : "--;");
+            break;
+        case 4:
+        case 5:
+            node.kind = Node::If;
+            node.head = "if (" + target + kCompare[pick(5)] + expression(variables, 1) + ")";
+            fill(node.body);
+            if (pick(2)) {
+                fill(node.other);
+            }
+            break;
+        case 6: {
+            node.kind = Node::For;
+            std::string counter = slot(pick(variables));
+            node.head = "for (" + counter + " = 0; " + counter + " < " + target + "; " + counter + "++)";
+            fill(node.body);
+            break;
+        }
+        case 7:
+            node.kind = Node::While;
+            node.head = "while (" + target + " > " + std::to_string(pick(8)) + ")";
+            fill(node.body);
+            node.body.push_back(simple(target + " = " + target + " / 2;"));
+            break;
+        default: {
+            node.kind = Node::Switch;
+            node.head = "switch (" + target + " % 4)";
+            int cases = 2 + pick(3);
+            for (int k = 0; k < cases; k++) {
+                Node label;
+                label.head = k + 1 == cases ? "default:" : "case " + std::to_string(k) + ":";
+                label.body.push_back(statement(variables, depth + 2));
+                label.body.push_back(simple("break;"));
+                node.other.push_back(label);
+            }
+            break;
+        }
+    }
+    return node;
+}
+
+CorpusGenerator::Program CorpusGenerator::program() {
+    Program result;
+    for (int f = 0; f < opts.functions; f++) {
+        Function function;
+        function.name = f;
+        function.params = 1 + pick(3);
+        for (int v = function.params; v < kVariables; v++) {
+            function.body.push_back(simple("int " + slot(v) + " = " + std::to_string(pick(10)) + ";"));
+        }
+        for (int s = 0; s < opts.statements; s++) {
+            function.body.push_back(statement(kVariables, 0));
+        }
+        function.body.push_back(simple("return " + slot(pick(kVariables)) + ";"));
+        result.functions.push_back(std::move(function));
+    }
+    return result;
+}
+
+void CorpusGenerator::reorder(Program& program) {
+    std::shuffle(program.functions.begin(), program.functions.end(), random);
+    // Swap neighboring straight-line statements, leaving declarations first
+    // and the return last
+    for (Function& function : program.functions) {
+        std::size_t first = static_cast<std::size_t>(kVariables - function.params);
+        for (std::size_t i = first; i + 2 < function.body.size(); i++) {
+            if (function.body[i].kind == Node::Simple && function.body[i + 1].kind == Node::Simple && pick(2)) {
+                std::swap(function.body[i], function.body[i + 1]);
+                i++;
+            }
+        }
+    }
+}
+
+void CorpusGenerator::insert(Program& program) {
+    for (Function& function : program.functions) {
+        int extra = std::max(1, opts.statements / 4);
+        for (int k = 0; k < extra; k++) {
+            std::size_t first = static_cast<std::size_t>(kVariables - function.params);
+            std::size_t at = first + pick(static_cast<int>(function.body.size() - first));
+            Node node;
+            node.head = slot(pick(kVariables)) + " = " + expression(kVariables, 0) + ";";
+            function.body.insert(function.body.begin() + at, node);
+        }
+    }
+}
+
+void CorpusGenerator::renderNode(const Node& node, const std::vector<std::string>& names, int indent,
+                                 std::string& out) {
+    std::string pad(indent * 4, ' ');
+    std::string head;
+    for (std::size_t i = 0; i < node.head.size(); i++) {
+        if (node.head[i] == '@') {
+            head += names[node.head[++i] - '0'];
+        } else {
+            head += node.head[i];
+        }
+    }
+
+    out += pad + head;
+    if (node.kind == Node::Simple) {
+        out += "\n";
+        for (const Node& child : node.body) {  // switch labels
+            renderNode(child, names, indent + 1, out);
+        }
+        return;
+    }
+    out += " {\n";
+    for (const Node& child : node.kind == Node::Switch ? node.other : node.body) {
+        renderNode(child, names, indent + 1, out);
+    }
+    out += pad + "}";
+    if (node.kind == Node::If && !node.other.empty()) {
+        out += " else {\n";
+        for (const Node& child : node.other) {
+            renderNode(child, names, indent + 1, out);
+        }
+        out += pad + "}";
+    }
+    out += "\n";
+}
+
+std::string CorpusGenerator::render(const Program& program, int style) {
+    // Style 0 uses plain words; other styles permute and decorate them
+    std::vector<int> words(kWordCount), verbs(kVerbCount);
+    for (int i = 0; i < kWordCount; i++) {
+        words[i] = i;
+    }
+    for (int i = 0; i < kVerbCount; i++) {
+        verbs[i] = i;
+    }
+    if (style > 0) {
+        std::mt19937_64 shuffle(opts.seed * 31 + style);
+        std::shuffle(words.begin(), words.end(), shuffle);
+        std::shuffle(verbs.begin(), verbs.end(), shuffle);
+    }
+    std::string suffix = style > 0 ? "_" + std::to_string(style) : "";
+
+    std::string out = "#include <cstdio>\n\n";
+    for (const Function& function : program.functions) {
+        std::vector<std::string> names;
+        for (int v = 0; v < kVariables; v++) {
+            names.push_back(std::string(kWords[words[(function.name * 5 + v) % kWordCount]]) + suffix);
+        }
+        std::string name = std::string(kVerbs[verbs[function.name % kVerbCount]]) + "_" +
+                           kWords[words[function.name % kWordCount]] + suffix;
+
+        out += "int " + name + "(";
+        for (int p = 0; p < function.params; p++) {
+            out += (p ? ", int " : "int ") + names[p];
+        }
+        out += ") {\n";
+        for (const Node& node : function.body) {
+            renderNode(node, names, 1, out);
+        }
+        out += "}\n\n";
+    }
+    return out;
+}
+
+std::vector<GeneratedFile> CorpusGenerator::generate() {
+    std::vector<GeneratedFile> files;
+    auto name = [&](const char* kind) {
+        return "gen" + std::to_string(files.size()) + "_" + kind + ".cpp";
+    };
+
+    int style = 1;
+    for (int o = 0; o < opts.originals; o++) {
+        Program original = program();
+        int id = static_cast<int>(files.size());
+        files.push_back({name("original"), render(original, 0), VariantKind::Original, -1});
+
+        for (int v = 0; v < opts.renamed; v++) {
+            files.push_back({name("renamed"), render(original, style++), VariantKind::Renamed, id});
+        }
+        for (int v = 0; v < opts.reordered; v++) {
+            Program variant = original;
+            reorder(variant);
+            files.push_back({name("reordered"), render(variant, 0), VariantKind::Reordered, id});
+        }
+        for (int v = 0; v < opts.inserted; v++) {
+            Program variant = original;
+            insert(variant);
+            files.push_back({name("inserted"), render(variant, 0), VariantKind::Inserted, id});
+        }
+    }
+    for (int i = 0; i < opts.independent; i++) {
+        files.push_back({name("independent"), render(program(), 0), VariantKind::Independent, -1});
+    }
+    return files;
+}
@@ -0,0 +1,75 @@
+#ifndef CORPUSGENERATOR_H
+#define CORPUSGENERATOR_H
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+struct GeneratorOptions {
+    std::uint64_t seed = 1;
+    int originals = 20;    // independent programs that get variants
+    int renamed = 1;       // variants per original with every identifier renamed
+    int reordered = 1;     // ... with functions and independent statements reordered
+    int inserted = 1;      // ... with extra statements inserted
+    int independent = 20;  // further programs without variants
+    int functions = 6;     // per program
+    int statements = 12;   // top-level statements per function
+};
+
+enum class VariantKind { Original, Renamed, Reordered, Inserted, Independent };
+
+struct GeneratedFile {
+    std::string name;
+    std::string code;
+    VariantKind kind;
+    int original;  // index of the file it derives from; -1 for originals and independents
+};
+
+// Synthetic C++ corpus of known ground truth: random programs of loops,
+// branches, switches and arithmetic, plus plagiarized variants of some of
+// them. Output depends only on the options.
+class CorpusGenerator {
+   public:
+    explicit CorpusGenerator(const GeneratorOptions& options = GeneratorOptions());
+
+    std::vector<GeneratedFile> generate();
+
+    static const char* kindName(VariantKind kind);
+
+   private:
+    // Statement tree; "@n" in text stands for variable slot n of the function
+    struct Node {
+        std::string head;
+        std::vector<Node> body;
+        std::vector<Node> other;  // else branch or switch cases
+        enum Kind { Simple, If, For, While, Switch } kind = Simple;
+    };
+
+    struct Function {
+        int name;  // slot in the program's function names
+        int params;
+        std::vector<Node> body;
+    };
+
+    struct Program {
+        std::vector<Function> functions;
+    };
+
+    GeneratorOptions opts;
+    std::mt19937_64 random;
+
+    int pick(int bound);
+    static Node simple(std::string head);  // plain statement
+    std::string expression(int variables, int depth);
+    Node statement(int variables, int depth);
+    Program program();
+    void reorder(Program& program);
+    void insert(Program& program);
+
+    // Source text with variable and function names drawn from `style`
+    std::string render(const Program& program, int style);
+    void renderNode(const Node& node, const std::vector<std::string>& names, int indent, std::string& out);
+};
+
+#endif
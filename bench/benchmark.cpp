@@ -0,0 +1,258 @@
+#include "../include/CFGBuilder.h"
+#include "../include/Normalizer.h"
+#include "../include/Scorer.h"
+#include "../include/SemanticHasher.h"
+#include "../include/StructuralMatcher.h"
+#include "../include/Utils/Json.h"
+#include "CorpusGenerator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/resource.h>
+
+// Per-stage timings of the checker over a synthetic corpus, as JSON:
+//
+//   benchmark [--seed N] [--originals N] [--renamed N] [--reordered N]
+//             [--inserted N] [--independent N] [--functions N]
+//             [--statements N] [--pairs N] [--out FILE] [--write-corpus DIR]
+//
+// Build from the repository root together with the sources, e.g.
+//   g++ -std=c++17 -O2 -pthread -Iinclude src/*.cpp src/Utils/*.cpp bench/*.cpp -o benchmark
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+double microseconds(Clock::time_point start, Clock::time_point end) {
+    return std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+// Latencies of one stage, in microseconds
+struct Stage {
+    std::string name;
+    std::string unit;  // what one sample processed
+    std::vector<double> samples;
+    std::size_t items = 0;  // calls, bytes, ... counted by `per`
+    std::string per;
+
+    double percentile(double p) const {
+        if (samples.empty()) {
+            return 0.0;
+        }
+        std::vector<double> sorted = samples;
+        std::size_t rank = static_cast<std::size_t>(p * (sorted.size() - 1) + 0.5);
+        std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+        return sorted[rank];
+    }
+
+    double total() const {
+        double sum = 0.0;
+        for (double sample : samples) {
+            sum += sample;
+        }
+        return sum;
+    }
+
+    std::string json() const {
+        double seconds = total() / 1e6;
+        std::ostringstream out;
+        out << "{\"name\":" << Json::quote(name) << ",\"unit\":" << Json::quote(unit)
+            << ",\"samples\":" << samples.size() << ",\"total_seconds\":" << Json::number(seconds)
+            << ",\"throughput_per_second\":" << Json::number(seconds > 0 ? samples.size() / seconds : 0.0)
+            << ",\"mean_us\":" << Json::number(samples.empty() ? 0.0 : total() / samples.size())
+            << ",\"p50_us\":" << Json::number(percentile(0.50))
+            << ",\"p99_us\":" << Json::number(percentile(0.99));
+        if (!per.empty()) {
+            out << ",\"" << per << "\":" << items << ",\"" << per
+                << "_per_second\":" << Json::number(seconds > 0 ? items / seconds : 0.0);
+        }
+        out << "}";
+        return out.str();
+    }
+};
+
+// Peak resident set size; ru_maxrss is in bytes on macOS and in
+// kilobytes elsewhere
+std::size_t peakRss() {
+    rusage usage = {};
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return static_cast<std::size_t>(usage.ru_maxrss);
+#else
+    return static_cast<std::size_t>(usage.ru_maxrss) * 1024;
+#endif
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    GeneratorOptions options;
+    std::size_t max_pairs = 2000;
+    std::string out_path, corpus_dir;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (!has_value) {
+            std::cerr << "Error: Unknown or incomplete option '" << arg << "'" << std::endl;
+            return 1;
+        }
+        std::string value = argv[++i];
+        if (arg == "--seed") {
+            options.seed = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--originals") {
+            options.originals = std::atoi(value.c_str());
+        } else if (arg == "--renamed") {
+            options.renamed = std::atoi(value.c_str());
+        } else if (arg == "--reordered") {
+            options.reordered = std::atoi(value.c_str());
+        } else if (arg == "--inserted") {
+            options.inserted = std::atoi(value.c_str());
+        } else if (arg == "--independent") {
+            options.independent = std::atoi(value.c_str());
+        } else if (arg == "--functions") {
+            options.functions = std::atoi(value.c_str());
+        } else if (arg == "--statements") {
+            options.statements = std::atoi(value.c_str());
+        } else if (arg == "--pairs") {
+            max_pairs = static_cast<std::size_t>(std::atol(value.c_str()));
+        } else if (arg == "--out") {
+            out_path = value;
+        } else if (arg == "--write-corpus") {
+            corpus_dir = value;
+        } else {
+            std::cerr << "Error: Unknown or incomplete option '" << arg << "'" << std::endl;
+            return 1;
+        }
+    }
+
+    auto generate_start = Clock::now();
+    CorpusGenerator generator(options);
+    std::vector<GeneratedFile> files = generator.generate();
+    double generate_us = microseconds(generate_start, Clock::now());
+
+    if (!corpus_dir.empty()) {
+        std::filesystem::create_directories(corpus_dir);
+        for (const GeneratedFile& file : files) {
+            std::ofstream(std::filesystem::path(corpus_dir) / file.name) << file.code;
+        }
+    }
+
+    Stage normalize{"Normalizer::process", "file", {}, 0, "bytes"};
+    Stage build{"CFGBuilder::build", "file", {}, 0, "tokens"};
+    Stage structural{"StructuralMatcher::compare", "pair", {}, 0, "blocks"};
+    Stage semantic{"SemanticHasher::compareBlocks", "pair (all matched blocks)", {}, 0, "calls"};
+    Stage score{"Scorer::calculate", "pair", {}, 0, ""};
+
+    Normalizer normalizer;
+    CFGBuilder builder;
+    std::vector<CFGBuilder::CFG> cfgs;
+    for (const GeneratedFile& file : files) {
+        auto start = Clock::now();
+        std::vector<Token> tokens = normalizer.process(file.code);
+        auto middle = Clock::now();
+        cfgs.push_back(builder.build(std::move(tokens)));
+        auto end = Clock::now();
+
+        normalize.samples.push_back(microseconds(start, middle));
+        normalize.items += file.code.size();
+        build.samples.push_back(microseconds(middle, end));
+        build.items += cfgs.back().tokens.size();
+    }
+
+    // Every variant against its original, alternating with as many
+    // unrelated pairs, so that --pairs keeps both kinds
+    std::vector<std::pair<int, int>> variants, unrelated, pairs;
+    std::vector<int> unrelated_pool;
+    for (std::size_t i = 0; i < files.size(); i++) {
+        if (files[i].original >= 0) {
+            variants.emplace_back(files[i].original, static_cast<int>(i));
+        } else {
+            unrelated_pool.push_back(static_cast<int>(i));
+        }
+    }
+    for (std::size_t k = 0; unrelated_pool.size() > 1 && unrelated.size() < variants.size(); k++) {
+        int a = unrelated_pool[k % unrelated_pool.size()];
+        int b = unrelated_pool[(k / unrelated_pool.size() + k + 1) % unrelated_pool.size()];
+        if (a != b) {
+            unrelated.emplace_back(a, b);
+        }
+    }
+    for (std::size_t k = 0; k < std::max(variants.size(), unrelated.size()) && pairs.size() < max_pairs; k++) {
+        if (k < variants.size()) {
+            pairs.push_back(variants[k]);
+        }
+        if (k < unrelated.size() && pairs.size() < max_pairs) {
+            pairs.push_back(unrelated[k]);
+        }
+    }
+
+    StructuralMatcher matcher;
+    SemanticHasher hasher;
+    Scorer scorer;
+    std::map<std::string, std::pair<double, int>> quality;  // kind -> (sum, count)
+    double checksum = 0.0;
+    for (const auto& pair : pairs) {
+        const CFGBuilder::CFG& cfg1 = cfgs[pair.first];
+        const CFGBuilder::CFG& cfg2 = cfgs[pair.second];
+
+        auto start = Clock::now();
+        MatchResult match = matcher.compare(cfg1, cfg2);
+        auto end = Clock::now();
+        structural.samples.push_back(microseconds(start, end));
+        structural.items += cfg1.blocks.size() + cfg2.blocks.size();
+
+        start = Clock::now();
+        for (const auto& blocks : match.node_matches) {
+            checksum += hasher.compareBlocks(cfg1.blocks[blocks.first], cfg2.blocks[blocks.second]);
+        }
+        end = Clock::now();
+        semantic.samples.push_back(microseconds(start, end));
+        semantic.items += match.node_matches.size();
+
+        start = Clock::now();
+        Scorer::Score result = scorer.calculate(cfg1, cfg2);
+        end = Clock::now();
+        score.samples.push_back(microseconds(start, end));
+
+        const GeneratedFile& second = files[pair.second];
+        std::string kind = second.original == pair.first ? CorpusGenerator::kindName(second.kind) : "unrelated";
+        quality[kind].first += result.overall;
+        quality[kind].second++;
+    }
+
+    std::ostringstream report;
+    report << "{\"corpus\":{\"files\":" << files.size() << ",\"pairs\":" << pairs.size()
+           << ",\"seed\":" << options.seed << ",\"functions\":" << options.functions
+           << ",\"statements\":" << options.statements
+           << ",\"generate_seconds\":" << Json::number(generate_us / 1e6) << "},\"stages\":[";
+    const Stage* stages[] = {&normalize, &build, &structural, &semantic, &score};
+    for (std::size_t s = 0; s < 5; s++) {
+        report << (s ? "," : "") << stages[s]->json();
+    }
+    // Mean overall score per variant kind: detection quality next to speed
+    report << "],\"mean_score\":{";
+    bool first = true;
+    for (const auto& kind : quality) {
+        report << (first ? "" : ",") << Json::quote(kind.first) << ":"
+               << Json::number(kind.second.first / kind.second.second);
+        first = false;
+    }
+    report << "},\"peak_rss_bytes\":" << peakRss() << ",\"checksum\":" << Json::number(checksum) << "}\n";
+
+    if (out_path.empty()) {
+        std::cout << report.str();
+    } else if (!(std::ofstream(out_path) << report.str())) {
+        std::cerr << "Error: Cannot write '" << out_path << "'" << std::endl;
+        return 1;
+    }
+    return 0;
+}
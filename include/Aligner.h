@@ -0,0 +1,64 @@
+#ifndef ALIGNER_H
+#define ALIGNER_H
+
+#include <cstdint>
+#include <vector>
+
+#include "CFGBuilder.h"
+#include "Normalizer.h"
+#include "Utils/LineIndex.h"
+
+// Token ranges of two files that line up. Lines are 1-based and inclusive,
+// and stay 0 until mapLines() fills them in.
+struct AlignedRegion {
+    std::uint32_t first1, length1;
+    std::uint32_t first2, length2;
+    int score;  // tile length, or the Smith-Waterman score
+    std::uint32_t line_begin1 = 0, line_end1 = 0;
+    std::uint32_t line_begin2 = 0, line_end2 = 0;
+};
+
+struct AlignmentOptions {
+    int min_tile = 12;       // shortest run reported by tile()
+    int match = 2;           // Smith-Waterman scoring
+    int mismatch = -1;
+    int gap = -2;
+    int min_score = 24;      // weakest local alignment reported
+};
+
+// Local alignment of two normalized token streams, for showing where two
+// files agree rather than how much. As in the Fingerprinter, all
+// identifiers compare equal: VAR_n ids depend on first appearance in the
+// whole file.
+class Aligner {
+   public:
+    explicit Aligner(const AlignmentOptions& options = AlignmentOptions());
+
+    // Greedy String Tiling with Running-Karp-Rabin matching: maximal common
+    // runs of at least min_tile tokens, longest first, no token in two
+    // tiles. Close to linear for typical inputs. Tiles are returned in
+    // order of their position in the first stream.
+    std::vector<AlignedRegion> tile(TokenSpan tokens1, TokenSpan tokens2) const;
+
+    // Best-scoring Smith-Waterman local alignment (linear gaps), or an
+    // empty vector if it scores below min_score. O(n * m) time, evaluated
+    // by anti-diagonals so that every cell of a diagonal is independent;
+    // O(min(n, m)) memory.
+    std::vector<AlignedRegion> localAlignment(TokenSpan tokens1, TokenSpan tokens2) const;
+
+    // Fill in line numbers from the token spans of each stream and the line
+    // index of its source
+    static void mapLines(std::vector<AlignedRegion>& regions, Span<SourceSpan> spans1,
+                         const LineIndex& lines1, Span<SourceSpan> spans2, const LineIndex& lines2);
+
+    // Fraction of both streams covered by the regions
+    static double coverage(const std::vector<AlignedRegion>& regions, std::size_t size1,
+                           std::size_t size2);
+
+    const AlignmentOptions& options() const { return opts; }
+
+   private:
+    AlignmentOptions opts;
+};
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef ASSIGNMENTSOLVER_H
+#define ASSIGNMENTSOLVER_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+#include "Utils/Span.h"
+
+// Candidate pairing between row `row` and column `col` with a positive weight
+struct AssignmentEdge {
+    int row;
+    int col;
+    double weight;
+};
+
+// Limits used to pick an algorithm and bound its running time
+struct AssignmentBudget {
+    // Largest n^3 (n = max(rows, cols)) solved exactly with the Hungarian method
+    double max_dense_work = 3.0e7;
+    // Candidates kept per row when the sparse auction is used (0 = all)
+    int candidates_per_row = 16;
+    // Upper bound on auction bids; unassigned rows stay unmatched afterwards
+    std::size_t max_auction_bids = 2000000;
+};
+
+// Maximum-weight bipartite matching. Rows and columns may stay unmatched;
+// only edges from the candidate list can be used.
+class AssignmentSolver {
+   public:
+    enum class Algorithm {
+        Auto,       // pick by budget: Hungarian when small, auction otherwise
+        Hungarian,  // exact, O(n^3) on a dense matrix
+        Auction,    // epsilon-optimal, works on the sparse candidate list
+        Greedy,     // first-fit per row, order dependent
+    };
+
+    // Returns (row, col) pairs sorted by row. Working storage comes from
+    // `memory` (e.g. an Arena); only the result uses the default heap.
+    static std::vector<std::pair<int, int>> solve(
+        int rows, int cols, Span<AssignmentEdge> edges, Algorithm algorithm = Algorithm::Auto,
+        const AssignmentBudget& budget = AssignmentBudget(),
+        std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+
+    // Algorithm that Auto resolves to for a problem of this size
+    static Algorithm choose(int rows, int cols, const AssignmentBudget& budget);
+
+   private:
+    static std::vector<std::pair<int, int>> hungarian(int rows, int cols, Span<AssignmentEdge> edges,
+                                                      std::pmr::memory_resource* memory);
+    static std::vector<std::pair<int, int>> auction(int rows, int cols, Span<AssignmentEdge> edges,
+                                                    const AssignmentBudget& budget,
+                                                    std::pmr::memory_resource* memory);
+    static std::vector<std::pair<int, int>> greedy(int rows, int cols, Span<AssignmentEdge> edges,
+                                                   std::pmr::memory_resource* memory);
+};
+
+#endif
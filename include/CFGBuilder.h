@@ -1,28 +1,113 @@
 #ifndef CFGBUILDER_H
 #define CFGBUILDER_H
 
-#include <map>
+#include <array>
+#include <cstdint>
 #include <vector>
 
 #include "Normalizer.h"
+#include "Utils/Span.h"
 
+using TokenSpan = Span<Token>;
+
+// Dense token histogram: one bin per predefined symbol plus one shared bin
+// for all normalized variables
+const int kHistogramBins = 96;
+const int kVarBin = Sym::PredefinedCount;
+static_assert(kVarBin < kHistogramBins, "histogram too small for the symbol table");
+
+// Control-flow keywords present in a block
+enum ControlFlowBits : std::uint32_t {
+    CF_IF = 1u << 0,
+    CF_ELSE = 1u << 1,
+    CF_WHILE = 1u << 2,
+    CF_FOR = 1u << 3,
+    CF_RETURN = 1u << 4,
+    CF_SWITCH = 1u << 5,
+    CF_DO = 1u << 6,
+    CF_JUMP = 1u << 7,  // break or continue
+};
+
+// Per-block features computed once by CFGBuilder so that block comparison
+// never has to walk the tokens again
+struct BlockFeatures {
+    std::array<std::uint16_t, kHistogramBins> histogram{};  // saturating counts
+    std::uint32_t token_count = 0;                         // sum of histogram
+    std::uint32_t control_flow = 0;                        // ControlFlowBits
+    std::uint64_t semantic_signature = 0;   // see SemanticHasher; 0 = not signed
+    std::uint64_t operation_signature = 0;  // 0 = no operations
+};
+
+// A block does not own its tokens or edges: both are ranges into the
+// arrays of the CFG it belongs to
 struct BasicBlock {
-    int id;
-    std::vector<Token> tokens;
-    std::vector<int> successors;
+    int id = 0;                     // index in CFG::blocks
+    std::uint32_t first_token = 0;  // range in CFG::tokens
+    std::uint32_t token_count = 0;
+    std::uint32_t first_edge = 0;   // range in CFG::edges
+    std::uint32_t edge_count = 0;
+    BlockFeatures features;
 };
 
 class CFGBuilder {
    public:
+    // Flat layout: one token array shared by all blocks, contiguous blocks
+    // whose id is their index, and successors in CSR form
     struct CFG {
+        std::vector<Token> tokens;
         std::vector<BasicBlock> blocks;
-        std::map<int, BasicBlock> block_map;
+        std::vector<int> edges;  // successor block ids, grouped by block
+        std::vector<SourceSpan> spans;  // source of each token; empty when unknown
+
+        TokenSpan tokensOf(const BasicBlock& block) const {
+            return TokenSpan(tokens.data() + block.first_token, block.token_count);
+        }
+        Span<int> successorsOf(const BasicBlock& block) const {
+            return Span<int>(edges.data() + block.first_edge, block.edge_count);
+        }
+        // Source bytes from the block's first token to its last; empty
+        // without spans
+        SourceSpan sourceOf(const BasicBlock& block) const {
+            if (spans.empty() || block.token_count == 0) {
+                return SourceSpan();
+            }
+            const SourceSpan& first = spans[block.first_token];
+            const SourceSpan& last = spans[block.first_token + block.token_count - 1];
+            return {first.offset, last.offset + last.length - first.offset};
+        }
     };
 
+    // Structured CFG: a block is a maximal run of straight-line tokens and
+    // ends at a branch (if/while/for/switch/do-while condition), a jump
+    // (break, continue, return) or before a branch target. Edges are real
+    // control flow: then/else and join edges, loop back edges, switch case
+    // edges, break to the loop or switch exit, continue to the loop head.
+    // Blocks keep source order; a condition ends the block it is in, so
+    // straight-line code before it shares its block.
     CFG build(const std::vector<Token>& tokens);
+    CFG build(std::vector<Token>&& tokens);  // takes over the token array
+    // With the spans Normalizer recorded for the tokens
+    CFG build(std::vector<Token>&& tokens, std::vector<SourceSpan>&& spans);
+
+    // One function definition of a file and its own CFG
+    struct FunctionCFG {
+        std::uint32_t first_token;  // range in the file's token stream, header
+        std::uint32_t token_count;  // through closing brace
+        CFG cfg;
+    };
+
+    // Split the stream into function definitions (free functions, methods
+    // in class bodies and namespaces, constructors with initializer lists)
+    // and build a CFG for each, in source order. Declarations and other
+    // code outside function bodies are left out; a stream without any
+    // function body yields a single unit covering all of it.
+    std::vector<FunctionCFG> buildFunctions(TokenSpan tokens);
+
+    // Fill block.features from the block's tokens (build() already does this)
+    static void computeFeatures(BasicBlock& block, TokenSpan tokens);
 
    private:
-    void buildSuccessors(CFG& cfg);
+    class Parser;
 };
 
 #endif
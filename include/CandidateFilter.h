@@ -0,0 +1,54 @@
+#ifndef CANDIDATEFILTER_H
+#define CANDIDATEFILTER_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "CFGBuilder.h"
+
+// Settings of the MinHash/LSH pre-filter. A threshold of 0 disables it.
+struct CandidateOptions {
+    double threshold = 0.0;  // estimated similarity a pair needs to be scored
+    double recall = 0.95;    // chance that a pair at the threshold is kept
+    int num_hashes = 128;    // sketch length
+    int bands = 0;           // LSH bands; 0 = derive from threshold and recall
+    int shingle = 5;         // tokens per k-gram
+
+    bool enabled() const { return threshold > 0.0; }
+};
+
+// Cheap pre-filter for all-pairs checking. Every file is summarized by a
+// MinHash sketch of its normalized token k-grams and block signatures;
+// banded LSH over the sketches then yields the pairs worth a full score.
+// Raising recall (or lowering the threshold) trades throughput for fewer
+// missed pairs.
+class CandidateFilter {
+   public:
+    using Sketch = std::vector<std::uint32_t>;
+
+    explicit CandidateFilter(const CandidateOptions& options = CandidateOptions());
+
+    Sketch sketch(const CFGBuilder::CFG& cfg) const;
+
+    // Fraction of equal sketch slots, an estimate of the Jaccard similarity
+    // of the two feature sets
+    static double estimate(const Sketch& a, const Sketch& b);
+
+    // Pairs (i < j) that share at least one LSH band and whose estimate
+    // reaches the threshold, sorted
+    std::vector<std::pair<int, int>> candidates(const std::vector<Sketch>& sketches) const;
+
+    int bands() const { return band_count; }
+    int rows() const { return rows_per_band; }
+
+    // Probability that banding keeps a pair of true similarity s
+    double keepProbability(double s) const;
+
+   private:
+    CandidateOptions options;
+    int band_count = 1;
+    int rows_per_band = 1;
+};
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef CORPUS_H
+#define CORPUS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "CFGBuilder.h"
+#include "CandidateFilter.h"
+#include "Scorer.h"
+
+class PersistentIndex;
+
+struct CorpusEntry {
+    std::string path;
+    CFGBuilder::CFG cfg;
+    std::uint64_t content_hash = 0;
+    int previous_id = -1;  // entry in the previous index when reused unchanged
+};
+
+// What the last load() / scoreAllPairs() did
+struct CorpusStats {
+    std::size_t files_analyzed = 0;
+    std::size_t files_reused = 0;
+    std::size_t pairs_scored = 0;
+    std::size_t pairs_reused = 0;
+    std::size_t pairs_pruned = 0;  // skipped by the candidate filter
+};
+
+struct PairResult {
+    int first;
+    int second;
+    Scorer::Score score;
+};
+
+// All-pairs checking over a set of files. Every file goes through the
+// Normalizer and CFGBuilder exactly once; pairs are then scored in parallel.
+class Corpus {
+   public:
+    // Expand a directory (recursively, C/C++ sources only) or a list file
+    // (one path per line) into the files to check
+    static std::vector<std::string> collectFiles(const std::string& source);
+
+    // Analyze every file once. Unreadable or empty files are skipped with a
+    // warning on stderr. Files whose content hash matches an entry of
+    // `previous` take their tokens and CFG from the index instead.
+    void load(const std::vector<std::string>& files, unsigned threads = 0,
+              const PersistentIndex* previous = nullptr);
+
+    // Take every entry of a prebuilt index without reading any source file
+    void load(const PersistentIndex& index, unsigned threads = 0);
+
+    // Append one analyzed file; returns its entry id
+    int add(CorpusEntry entry);
+
+    // Score every pair (or, with the candidate filter enabled, every
+    // candidate pair) and return those with overall >= min_score, ranked
+    // from most to least similar. Pairs of two unchanged files reuse the
+    // score stored in `previous` when its threshold and weights allow it.
+    std::vector<PairResult> scoreAllPairs(unsigned threads = 0, double min_score = 0.0,
+                                          const PersistentIndex* previous = nullptr);
+
+    // Set weights passed on to each Scorer
+    void setWeights(double structural_weight, double semantic_weight,
+                    double fingerprint_weight = 0.0);
+
+    // Only score pairs that pass the MinHash/LSH pre-filter
+    void setCandidateFilter(const CandidateOptions& options) { candidate_options = options; }
+
+    double structuralWeight() const { return structural_weight; }
+    double semanticWeight() const { return semantic_weight; }
+    double fingerprintWeight() const { return fingerprint_weight; }
+
+    const CandidateOptions& candidateOptions() const { return candidate_options; }
+    const std::vector<CorpusEntry>& entries() const { return files; }
+    const CorpusStats& stats() const { return last_stats; }
+
+   private:
+    std::vector<CorpusEntry> files;
+    CorpusStats last_stats;
+    double structural_weight = 0.4;
+    double semantic_weight = 0.6;
+    double fingerprint_weight = 0.0;
+    CandidateOptions candidate_options;
+};
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef CORPUSINDEX_H
+#define CORPUSINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "CFGBuilder.h"
+#include "CandidateFilter.h"
+#include "Corpus.h"
+#include "Fingerprinter.h"
+#include "Scorer.h"
+#include "WLKernel.h"
+#include "Utils/ThreadPool.h"
+
+struct QueryOptions {
+    std::size_t top_k = 10;       // results returned
+    std::size_t screened = 200;   // entries that get a full score; 0 = all
+    double min_score = 0.0;       // overall score a result needs
+};
+
+// One entry of the corpus close to the query
+struct Neighbor {
+    int entry;
+    double screen;  // screening estimate that got it scored
+    Scorer::Score score;
+};
+
+// What one query did
+struct QueryStats {
+    std::size_t entries = 0;  // corpus size at the time
+    std::size_t scored = 0;   // entries that went through Scorer::calculate
+};
+
+// Nearest-neighbor queries against a corpus that stays in memory: files
+// are analyzed (or taken from a PersistentIndex) once, and so are their
+// screening signatures, a WL vector of the CFG and a MinHash sketch of the
+// token stream. A query analyzes one new file, ranks every entry by the
+// cheap signatures, scores the best `screened` of them in full on the
+// index's thread pool and returns the top_k by overall score.
+class CorpusIndex {
+   public:
+    // threads == 0 uses the hardware concurrency
+    explicit CorpusIndex(unsigned threads = 0);
+
+    // Warm start from an index file written by save() or by corpus mode.
+    // Returns false (and sets error()) when it cannot be opened.
+    bool open(const std::string& path);
+
+    // Cold start: analyze the files (see Corpus::load)
+    void build(const std::vector<std::string>& files);
+
+    // Analyze and add one file; returns its entry id, or -1 for empty code
+    int add(const std::string& path, std::string_view code);
+    // Add a file the caller analyzed
+    int add(CorpusEntry entry);
+
+    // Write the entries for a later open(); no pair scores are stored
+    bool save(const std::string& path);
+
+    // Closest entries to `code`, best first. Queries may run concurrently
+    // with each other, not with build(), open() or add(); each waits only
+    // for its own work on the shared pool.
+    std::vector<Neighbor> query(std::string_view code, const QueryOptions& options = QueryOptions(),
+                                QueryStats* stats = nullptr) const;
+    std::vector<Neighbor> query(const CFGBuilder::CFG& cfg, const QueryOptions& options = QueryOptions(),
+                                QueryStats* stats = nullptr) const;
+
+    // Set weights passed on to each Scorer
+    void setWeights(double structural_weight, double semantic_weight,
+                    double fingerprint_weight = 0.0);
+
+    // Entry id of the latest file added under `path`, or -1
+    int find(const std::string& path) const;
+
+    std::size_t size() const { return corpus.entries().size(); }
+    const CorpusEntry& entry(int id) const { return corpus.entries()[id]; }
+    const std::string& error() const { return error_message; }
+
+   private:
+    Corpus corpus;
+    std::vector<WLVector> structure;  // per entry
+    std::vector<CandidateFilter::Sketch> sketches;
+    std::vector<std::pmr::vector<std::uint64_t>> fingerprints;  // only with a fingerprint weight
+    std::unordered_map<std::string, int> by_path;
+    WLKernel kernel;
+    CandidateFilter filter;
+    Fingerprinter fingerprinter;
+    std::unique_ptr<ThreadPool> pool;
+    unsigned thread_count;
+    std::string error_message;
+
+    // Signatures of entries added since the last call
+    void sign();
+
+    // Fingerprint hash sets of the entries that lack one, or none when
+    // the fingerprint overlap has no weight
+    void hashFingerprints();
+};
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef FINGERPRINTINDEX_H
+#define FINGERPRINTINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "Fingerprinter.h"
+
+// A document sharing fingerprints with a query
+struct FingerprintMatch {
+    int document;
+    std::size_t shared;  // distinct hashes in common
+    double overlap;      // Jaccard of the two hash sets
+};
+
+// Inverted index from fingerprint hash to the documents containing it. A
+// query only walks the postings of its own hashes, so its cost depends on
+// the query and on how common its fingerprints are, not on corpus size.
+class FingerprintIndex {
+   public:
+    // Add a document and return its id (ids count up from 0)
+    int add(const std::vector<Fingerprint>& fingerprints);
+
+    // Documents sharing at least min_shared hashes with the query, most
+    // overlapping first. Hashes found in more than max_postings documents
+    // are skipped as boilerplate (0 = no limit).
+    std::vector<FingerprintMatch> query(const std::vector<Fingerprint>& fingerprints,
+                                        std::size_t min_shared = 1,
+                                        std::size_t max_postings = 0) const;
+
+    std::size_t size() const { return set_sizes.size(); }
+    std::size_t hashCount() const { return postings.size(); }
+
+   private:
+    std::unordered_map<std::uint64_t, std::vector<int>> postings;
+    std::vector<std::size_t> set_sizes;  // distinct hashes per document
+};
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef FINGERPRINTER_H
+#define FINGERPRINTER_H
+
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+#include "CFGBuilder.h"
+#include "Normalizer.h"
+
+// A selected k-gram hash and the index of its first token
+struct Fingerprint {
+    std::uint64_t hash;
+    std::uint32_t position;
+};
+
+struct FingerprintOptions {
+    int k = 8;       // tokens per k-gram; shorter matches are noise
+    int window = 4;  // k-grams per winnowing window
+};
+
+// Winnowing over the normalized token stream: Karp-Rabin hashes of every
+// k-gram, of which the minimum of each window of consecutive hashes is kept.
+// Any run of at least k + window - 1 shared tokens yields a shared
+// fingerprint, wherever it sits in either file and however the blocks
+// around it were split or reordered.
+class Fingerprinter {
+   public:
+    explicit Fingerprinter(const FingerprintOptions& options = FingerprintOptions());
+
+    // Fingerprints in token order
+    std::vector<Fingerprint> fingerprint(TokenSpan tokens) const;
+
+    // Same over the token stream the CFG was built from
+    std::vector<Fingerprint> fingerprint(const CFGBuilder::CFG& cfg) const;
+
+    // Sorted distinct hashes, the form overlap() compares
+    static std::vector<std::uint64_t> hashSet(const std::vector<Fingerprint>& fingerprints);
+
+    // Hash set of `tokens` directly, with all storage taken from `memory`
+    std::pmr::vector<std::uint64_t> hashSet(
+        TokenSpan tokens, std::pmr::memory_resource* memory = std::pmr::get_default_resource()) const;
+
+    // Shared / total distinct hashes (Jaccard) of two hash sets; 1.0 for
+    // two empty sets
+    static double overlap(Span<std::uint64_t> set1, Span<std::uint64_t> set2);
+
+    // Number of hashes the two sets share
+    static std::size_t sharedCount(Span<std::uint64_t> set1, Span<std::uint64_t> set2);
+
+    const FingerprintOptions& options() const { return opts; }
+
+   private:
+    FingerprintOptions opts;
+
+    // Call emit(hash, position) for every selected k-gram, in token order
+    template <typename Emit>
+    void winnow(TokenSpan tokens, std::pmr::memory_resource* memory, Emit emit) const;
+};
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef HISTOGRAMKERNEL_H
+#define HISTOGRAMKERNEL_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "CFGBuilder.h"
+
+// Shared token counts, sum over bins of min(a, b), of one block histogram
+// against a run of others: the numerator of the weighted Jaccard the
+// matcher scores every candidate block pair by. Rows are laid out
+// back to back, kHistogramBins counts each, as in a BlockTable.
+//
+// The widest implementation the CPU supports is picked at first use:
+// AVX2 or SSE4.1 on x86 (checked at run time, so the build needs no
+// -mavx2), NEON on 64-bit ARM, and plain loops everywhere else. All give
+// the same counts.
+class HistogramKernel {
+   public:
+    enum class Level { Scalar, SSE41, AVX2, NEON };
+
+    // out[k] = sum_bin min(query[bin], rows[k * kHistogramBins + bin])
+    static void intersections(const std::uint16_t* query, const std::uint16_t* rows, std::size_t count,
+                              std::uint32_t* out);
+
+    // The implementation in use, the best this CPU supports and whether it
+    // supports `level`
+    static Level active();
+    static Level best();
+    static bool supported(Level level);
+
+    // Switch implementations, for tests and benchmarks; false, leaving the
+    // current one, if the CPU lacks `level`
+    static bool use(Level level);
+
+    static const char* name(Level level);
+};
+
+#endif
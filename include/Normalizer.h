@@ -2,28 +2,65 @@
 #define NORMALIZER_H
 
 #include <cctype>
-#include <map>    // Add this line
-#include <regex>  // Add this line
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory_resource>
 #include <string>
-#include <unordered_set>  // Add this line
+#include <string_view>
 #include <vector>
 
+#include "SymbolTable.h"
+
+enum class TokenKind : std::uint8_t { Keyword, Identifier, Symbol, Literal };
+
+// Compact token: the kind plus a symbol id whose text lives in SymbolTable.
+// Identifiers carry their normalized VAR_n id; string and character
+// literals collapse to a single Literal placeholder.
 struct Token {
-    std::string type;
-    std::string value;
+    TokenKind kind;
+    SymbolId symbol;
+
+    bool operator==(const Token& other) const {
+        return kind == other.kind && symbol == other.symbol;
+    }
+    bool operator!=(const Token& other) const { return !(*this == other); }
+};
+
+static_assert(sizeof(Token) == 8, "Token should stay two words wide");
 
-    bool operator==(const Token& other) const { return type == other.type && value == other.value; }
+// Bytes a token was lexed from. Kept in an array parallel to the tokens
+// rather than in Token itself; a literal spans its quotes and contents.
+struct SourceSpan {
+    std::uint32_t offset = 0;
+    std::uint32_t length = 0;
 };
 
+// Single-pass lexer: strips comments and literals, recognizes multi-character
+// operators and renames identifiers to VAR_n in order of first appearance
 class Normalizer {
    public:
-    std::vector<Token> process(const std::string& code);
+    std::vector<Token> process(std::string_view code);
+
+    // Lex a stream chunk by chunk without holding the whole input in memory
+    std::vector<Token> process(std::istream& input, std::size_t chunk_size = 64 * 1024);
+
+    // Same, also filling spans[i] with the source bytes of token i
+    std::vector<Token> process(std::string_view code, std::vector<SourceSpan>& spans);
+    std::vector<Token> process(std::istream& input, std::vector<SourceSpan>& spans,
+                               std::size_t chunk_size = 64 * 1024);
+
+    // Take the lexer's working state (identifier table, carried lexemes)
+    // from `memory`, e.g. an Arena reset between files; nullptr = heap.
+    // The returned tokens always live on the heap.
+    void setArena(std::pmr::memory_resource* memory);
 
    private:
-    void removeComments(std::string& code);
-    void normalizeVariables(std::vector<Token>& tokens);
-    std::vector<Token> tokenize(const std::string& code);
-    bool isKeyword(const std::string& word);
+    class Lexer;
+
+    std::pmr::memory_resource* scratch = std::pmr::get_default_resource();
+
+    static std::vector<Token> lexStream(Lexer& lexer, std::istream& input, std::size_t chunk_size);
 };
 
 #endif
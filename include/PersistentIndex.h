@@ -0,0 +1,87 @@
+#ifndef PERSISTENTINDEX_H
+#define PERSISTENTINDEX_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "CFGBuilder.h"
+#include "Corpus.h"
+#include "Scorer.h"
+#include "Utils/SourceFile.h"
+
+// On-disk analysis results of a previous corpus run: per file its content
+// hash, normalized token stream and CFG with block features and signatures,
+// plus the pair scores that were reported. The file is a versioned header
+// followed by fixed-size, 8-byte aligned record arrays, and is read through
+// a memory mapping.
+class PersistentIndex {
+   public:
+    // Bump whenever the record layout, the symbol table, the analysis
+    // that produces tokens and CFGs or the stored pair scores change
+    static const std::uint32_t kVersion = 6;
+
+    // Map an index file. Returns false (and sets error()) when the file is
+    // missing, damaged or was written by an incompatible version.
+    bool open(const std::string& path);
+
+    // Write the analysis of `corpus` and the reported `pairs`, which must be
+    // every pair with overall >= min_score
+    static bool write(const std::string& path, const Corpus& corpus,
+                      const std::vector<PairResult>& pairs, double min_score,
+                      std::string& error);
+
+    std::size_t size() const;
+
+    // Entry id for a path, or -1
+    int find(const std::string& path) const;
+
+    std::string path(int id) const;
+    std::uint64_t contentHash(int id) const;
+    std::vector<Token> loadTokens(int id) const;
+    CFGBuilder::CFG loadCFG(int id) const;
+
+    // Stored score of a pair of entry ids. Pairs that are not stored scored
+    // below pairThreshold().
+    bool findPair(int a, int b, Scorer::Score& score) const;
+    double pairThreshold() const { return threshold; }
+    double structuralWeight() const { return structural_weight; }
+    double semanticWeight() const { return semantic_weight; }
+    double fingerprintWeight() const { return fingerprint_weight; }
+    // Pre-filter of the run that wrote the index; only its candidates were scored
+    const CandidateOptions& candidateOptions() const { return candidate_options; }
+
+    const std::string& error() const { return error_message; }
+
+   private:
+    // On-disk records, defined in PersistentIndex.cpp
+    struct Header;
+    struct FileRecord;
+    struct BlockRecord;
+    struct TokenRecord;
+    struct PairRecord;
+
+    SourceFile file;
+    std::string error_message;
+    double threshold = 0.0;
+    double structural_weight = 0.0;
+    double semantic_weight = 0.0;
+    double fingerprint_weight = 0.0;
+    CandidateOptions candidate_options;
+
+    // Views into the mapping, set by open()
+    const FileRecord* files = nullptr;
+    const BlockRecord* blocks = nullptr;
+    const TokenRecord* tokens = nullptr;
+    const std::int32_t* edges = nullptr;
+    const PairRecord* pairs = nullptr;
+    const char* strings = nullptr;
+    std::uint32_t file_count = 0;
+    std::uint64_t pair_count = 0;
+
+    std::unordered_map<std::string, int> by_path;
+    std::unordered_map<std::uint64_t, std::uint64_t> by_pair;  // (a << 32 | b) -> record
+};
+
+#endif
@@ -1,15 +1,26 @@
 #ifndef SCORER_H
 #define SCORER_H
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+
 #include "CFGBuilder.h"
+#include "Fingerprinter.h"
 #include "SemanticHasher.h"
 #include "StructuralMatcher.h"
+#include "WLKernel.h"
+#include "Utils/Arena.h"
+#include "Utils/Span.h"
 
 class Scorer {
    public:
     struct Score {
         double structural;
         double semantic;
+        double fingerprint;  // winnowing fingerprint overlap of the token streams
         double overall;
         int matched_blocks;
         int total_blocks;
@@ -18,17 +29,136 @@ class Scorer {
     // Calculate comprehensive similarity score between two CFGs
     Score calculate(const CFGBuilder::CFG& cfg1, const CFGBuilder::CFG& cfg2);
 
-    // Set weights for combining structural and semantic scores
-    void setWeights(double structural_weight, double semantic_weight);
+    // Score the pair only as far as it can still reach `threshold`. Cheap
+    // upper bounds (block counts, shared tokens and signatures per control
+    // flow class) go first, then the exact structural and semantic scores
+    // bound the rest. Returns true with the same score as calculate() when
+    // the pair reaches the threshold; otherwise false, and result.overall
+    // holds a bound below the threshold rather than the score. The
+    // fingerprint overlap is only computed, and otherwise left 0, when it
+    // has a weight.
+    bool calculateAbove(const CFGBuilder::CFG& cfg1, const CFGBuilder::CFG& cfg2, double threshold,
+                        Score& result);
+
+    // The same with the fingerprint hash sets of both files
+    // (Fingerprinter::hashSet of their tokens) computed beforehand, as
+    // when every file is paired with many others
+    bool calculateAbove(const CFGBuilder::CFG& cfg1, const CFGBuilder::CFG& cfg2,
+                        Span<std::uint64_t> fingerprints1, Span<std::uint64_t> fingerprints2, double threshold,
+                        Score& result);
+
+    using BatchCallback = std::function<void(std::size_t candidate, const Score& score)>;
+
+    // Score one query against many candidates, as when an upload is checked
+    // against a set of references. The query's bound summary and
+    // fingerprints are prepared once, and candidates' blocks are laid out
+    // structure-of-arrays a chunk at a time for the block scan. `callback`
+    // gets every candidate that reaches `threshold` as soon as it is
+    // scored, in order, with the same score as calculateAbove().
+    // `fingerprints` holds the candidates' hash sets when the caller keeps
+    // them; empty = hash their tokens here if the weight needs them.
+    void calculateBatch(const CFGBuilder::CFG& query, Span<const CFGBuilder::CFG*> candidates, double threshold,
+                        const BatchCallback& callback, Span<Span<std::uint64_t>> fingerprints = {});
+
+    // Function i of the first file paired with function j of the second
+    struct FunctionMatch {
+        int function1;
+        int function2;
+        double similarity;  // overall score of the pair
+    };
+
+    struct FunctionScore {
+        Score score;  // pair scores weighted by the token counts of both functions
+        std::vector<FunctionMatch> matches;  // by function1
+        int rows = 0;                        // functions in the first file
+        int cols = 0;
+        std::vector<double> matrix;  // overall score of every pair, row-major
+    };
+
+    // Score every function of one file against every function of the other,
+    // then pair them one-to-one by maximum-weight assignment (weight =
+    // score times combined size). Unpaired functions count as 0, so each
+    // file's code outside the matches lowers the aggregate. Matching work
+    // is bounded by function sizes rather than file sizes. With screening
+    // on, pairs screened out stay 0 in the matrix.
+    FunctionScore calculateFunctions(const std::vector<CFGBuilder::FunctionCFG>& functions1,
+                                     const std::vector<CFGBuilder::FunctionCFG>& functions2);
+
+    // Set weights for combining structural, semantic and fingerprint scores
+    void setWeights(double structural_weight, double semantic_weight,
+                    double fingerprint_weight = 0.0);
+
+    // Fully score only the `candidates` functions of each file whose WL
+    // vectors are closest to a function of the other (default 8); 0 =
+    // score every pair
+    void setFunctionScreening(int candidates);
+
+    // Take all per-pair working storage from `arena`, which is reset at the
+    // start of every calculate(); nullptr = heap
+    void setArena(Arena* arena);
 
    private:
     double structural_weight = 0.4;  // Default weights
     double semantic_weight = 0.6;
+    double fingerprint_weight = 0.0;  // reported but not blended in by default
 
     StructuralMatcher matcher;
     SemanticHasher hasher;
+    Fingerprinter fingerprinter;
+    Arena* arena = nullptr;
+    WLKernel kernel;
+    int function_candidates = 8;
+
+    // Most blocks a matching can pair, and of those the most with equal
+    // semantic and with equal operation signatures
+    struct PairingBound {
+        int blocks = 0;
+        int semantic = 0;
+        int operations = 0;
+    };
+
+    // One CFG's non-empty blocks per control flow class: their number,
+    // summed histogram and sorted signatures
+    struct ClassSummary {
+        std::uint32_t control_flow = 0;
+        std::uint32_t blocks = 0;
+        std::array<std::uint32_t, kHistogramBins> histogram{};
+        std::size_t semantic_begin = 0;   // into BoundSide::semantic
+        std::size_t operation_begin = 0;  // into BoundSide::operations
+    };
+
+    struct BoundSide {
+        std::pmr::vector<ClassSummary> classes;  // by control flow
+        std::pmr::vector<std::uint64_t> semantic;
+        std::pmr::vector<std::uint64_t> operations;  // nonzero only
+
+        explicit BoundSide(std::pmr::memory_resource* memory);
+    };
+
+    // What scorePair() takes precomputed rather than deriving from the CFGs
+    struct PairInputs {
+        const BoundSide* bound1 = nullptr;  // cfg1's bound summary
+        const Span<std::uint64_t>* fingerprints1 = nullptr;  // hash sets
+        const Span<std::uint64_t>* fingerprints2 = nullptr;
+        const BlockTable* table = nullptr;  // holding cfg2 as CFG `entry`
+        std::size_t entry = 0;
+        bool report_fingerprint = false;  // compute the overlap even without a weight
+    };
+
+    static BoundSide boundSide(const CFGBuilder::CFG& cfg, std::pmr::memory_resource* memory);
+    static PairingBound pairingBound(const BoundSide& side1, const BoundSide& side2);
+
+    // Highest semantic similarity `matched` pairs out of `total_blocks`
+    // can have under `bound`
+    static double semanticBound(int matched, int total_blocks, const PairingBound& bound);
+
+    // calculateAbove(), with whatever `inputs` gives taken from there
+    bool scorePair(const CFGBuilder::CFG& cfg1, const CFGBuilder::CFG& cfg2, double threshold,
+                   const PairInputs& inputs, Score& result);
 
-    // Calculate semantic similarity between matched blocks
+    // Semantic similarity of the matched blocks, scaled by the share of
+    // blocks matched so that a few equal blocks cannot carry two unrelated
+    // files
     double calculateSemanticSimilarity(const CFGBuilder::CFG& cfg1, const CFGBuilder::CFG& cfg2,
                                        const std::vector<std::pair<int, int>>& matches);
 };
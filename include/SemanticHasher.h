@@ -1,8 +1,8 @@
 #ifndef SEMANTICHASHER_H
 #define SEMANTICHASHER_H
 
+#include <cstdint>
 #include <string>
-#include <unordered_set>
 #include <vector>
 
 #include "CFGBuilder.h"
@@ -12,21 +12,20 @@ class SemanticHasher {
     // Hash a basic block's semantic content
     std::string hashBlock(const BasicBlock& block);
 
-    // Compare two blocks semantically
+    // Compare two blocks semantically by the signatures stored in their
+    // features; blocks must have been signed (CFGBuilder does this)
     double compareBlocks(const BasicBlock& block1, const BasicBlock& block2);
 
-   private:
-    // Extract semantic patterns from tokens
-    std::string extractSemanticPattern(const std::vector<Token>& tokens);
+    // 64-bit signature of the semantic pattern (variables abstracted away);
+    // never 0
+    static std::uint64_t semanticSignature(TokenSpan tokens);
 
-    // Normalize operations (e.g., += becomes ADD_ASSIGN)
-    std::string normalizeOperation(const std::vector<Token>& tokens);
+    // 64-bit signature of the sequence of operation classes (arithmetic,
+    // comparison, control, ...); 0 when the tokens contain no operation
+    static std::uint64_t operationSignature(TokenSpan tokens);
 
-    // Check if tokens represent similar operations
-    bool areOperationsSimilar(const std::string& op1, const std::string& op2);
-
-    // Simple hash function
-    std::size_t simpleHash(const std::string& str);
+    // Store both signatures of the block's tokens in block.features
+    static void signBlock(BasicBlock& block, TokenSpan tokens);
 };
 
 #endif
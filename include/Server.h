@@ -0,0 +1,94 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "CorpusIndex.h"
+#include "Utils/Json.h"
+#include "Utils/ThreadPool.h"
+
+struct ServerOptions {
+    std::string socket_path;  // Unix domain socket; TCP when empty
+    int port = 0;             // localhost TCP port; 0 = any free port
+    unsigned threads = 0;     // requests answered at once; 0 = hardware concurrency
+    std::size_t max_request = 64u << 20;  // longest request line in bytes
+};
+
+// Long-running checker that keeps a CorpusIndex in memory. Clients send
+// one JSON object per line and get one JSON object per line back:
+//
+//   {"op":"compare","code1":"...","code2":"..."}   (or "path1"/"path2")
+//   {"op":"query","code":"...","top":10,"screen":200,"min_score":0.5}
+//   {"op":"add","path":"...","code":"..."}         (code read from path if absent)
+//   {"op":"metrics","format":"prometheus"}        (JSON counters without format)
+//   {"op":"ping"}  {"op":"shutdown"}
+//
+// Replies carry "ok":true and the results, or "ok":false and an "error".
+// Files named by path that are already in the index with unchanged content
+// reuse its CFG. One thread reads every connection and hands complete
+// requests to a thread pool, so idle connections hold no worker; queries
+// run concurrently, additions exclusively.
+class Server {
+   public:
+    Server(CorpusIndex& index, const ServerOptions& options = ServerOptions());
+    ~Server();
+
+    Server(const Server&) = delete;
+    Server& operator=(const Server&) = delete;
+
+    // Bind and listen. Returns false and sets error() on failure. A stale
+    // socket file at socket_path is replaced.
+    bool listen();
+
+    // Accept connections until stop() or a shutdown request
+    void run();
+
+    // Ask run() to return; safe from any thread
+    void stop();
+
+    // Reply to one request line, without the newline
+    std::string handle(std::string_view request);
+
+    // TCP port actually bound (after listen())
+    int port() const { return bound_port; }
+    const std::string& error() const { return error_message; }
+
+   private:
+    CorpusIndex& index;
+    ServerOptions opts;
+    int listen_fd = -1;
+    int bound_port = 0;
+    std::atomic<bool> stopping{false};
+    std::shared_mutex index_mutex;
+    std::string error_message;
+    std::unique_ptr<ThreadPool> pool;
+    int wake_fds[2] = {-1, -1};  // pipe that ends run()'s poll early
+
+    // One client. run() reads it while no task is answering its requests,
+    // which keeps replies in request order.
+    struct Connection {
+        int fd = -1;
+        std::string buffer;  // start of a request line still arriving
+        std::atomic<bool> busy{false};
+        std::atomic<bool> closing{false};  // close once not busy
+    };
+
+    // Read what arrived on `connection` and hand its complete lines to
+    // the pool
+    void receive(Connection& connection);
+    // Reply to `lines` in order on the pool; `too_long` ends the
+    // connection after them
+    void answer(Connection& connection, const std::vector<std::string>& lines, bool too_long);
+    void wake();
+    std::string compare(const Json::Object& request);
+    std::string query(const Json::Object& request);
+    std::string add(const Json::Object& request);
+};
+
+#endif
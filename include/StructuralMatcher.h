@@ -1,31 +1,79 @@
 #ifndef STRUCTURALMATCHER_H
 #define STRUCTURALMATCHER_H
 
+#include "AssignmentSolver.h"
 #include "CFGBuilder.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
 #include <vector>
-#include <map>
 
 struct MatchResult {
     double similarity;
     std::vector<std::pair<int, int>> node_matches;
+    // Source of each matched block pair, parallel to node_matches; filled
+    // only when both CFGs carry token spans
+    std::vector<std::pair<SourceSpan, SourceSpan>> match_sources;
     int matched_nodes;
     int total_nodes;
 };
 
+// Blocks of a run of CFGs, structure-of-arrays. Each CFG's non-empty
+// blocks are stored in the order the matcher scans them, by control flow
+// and then size, with their histograms in one contiguous array.
+struct BlockTable {
+    std::pmr::vector<std::uint32_t> control_flow;
+    std::pmr::vector<std::uint32_t> token_count;
+    std::pmr::vector<int> block;                 // index within its CFG
+    std::pmr::vector<std::uint16_t> histograms;  // kHistogramBins per row
+    std::pmr::vector<std::size_t> offsets;       // CFG k owns rows offsets[k] .. offsets[k + 1]
+
+    explicit BlockTable(std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+
+    // Append the blocks of `cfg` as the next CFG
+    void add(const CFGBuilder::CFG& cfg);
+    void clear();
+
+    std::size_t cfgs() const { return offsets.size() - 1; }
+    const std::uint16_t* histogram(std::size_t row) const { return histograms.data() + row * kHistogramBins; }
+};
+
 class StructuralMatcher {
 public:
     // Compare two CFGs and return structural similarity
     MatchResult compare(const CFGBuilder::CFG& cfg1, const CFGBuilder::CFG& cfg2);
     
+    // Same, with cfg2 already laid out as CFG `entry` of `table`; lets one
+    // query be matched against many CFGs laid out together
+    MatchResult compare(const CFGBuilder::CFG& cfg1, const CFGBuilder::CFG& cfg2, const BlockTable& table,
+                        std::size_t entry);
+    
+    // Choose the block assignment algorithm (Auto picks by budget)
+    void setAssignment(AssignmentSolver::Algorithm algorithm,
+                       const AssignmentBudget& budget = AssignmentBudget());
+    
+    // Take working storage from `memory` (e.g. an Arena); nullptr = heap
+    void setArena(std::pmr::memory_resource* memory);
+    
 private:
-    // Find matching nodes between two CFGs
-    std::vector<std::pair<int, int>> findNodeMatches(const CFGBuilder::CFG& cfg1, const CFGBuilder::CFG& cfg2);
+    AssignmentSolver::Algorithm algorithm = AssignmentSolver::Algorithm::Auto;
+    AssignmentBudget budget;
+    std::pmr::memory_resource* scratch = std::pmr::get_default_resource();
     
-    // Calculate similarity between two basic blocks
-    double calculateBlockSimilarity(const BasicBlock& block1, const BasicBlock& block2);
+    // Minimum block similarity for two blocks to be matchable
+    static constexpr double kMatchThreshold = 0.5;
+    
+    // Block pairs that can reach kMatchThreshold, with their similarity
+    std::pmr::vector<AssignmentEdge> findCandidates(const CFGBuilder::CFG& cfg1, const CFGBuilder::CFG& cfg2,
+                                                    const BlockTable& table, std::size_t entry);
+    
+    // Find matching nodes between two CFGs
+    std::vector<std::pair<int, int>> findNodeMatches(const CFGBuilder::CFG& cfg1, const CFGBuilder::CFG& cfg2,
+                                                     const BlockTable& table, std::size_t entry);
     
-    // Check if control flow patterns match
-    bool controlFlowMatches(const BasicBlock& block1, const BasicBlock& block2);
+    // Weighted Jaccard of two token histograms from their shared count
+    // and totals
+    static double weightedJaccard(std::uint32_t intersection, std::uint32_t size1, std::uint32_t size2);
     
     // Calculate edge similarity
     double calculateEdgeSimilarity(const CFGBuilder::CFG& cfg1, const CFGBuilder::CFG& cfg2, 
@@ -0,0 +1,139 @@
+#ifndef SYMBOLTABLE_H
+#define SYMBOLTABLE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+using SymbolId = std::uint32_t;
+
+// Predefined symbols. Ids are stable: keywords first, then single-character
+// punctuation, then multi-character operators.
+namespace Sym {
+enum : SymbolId {
+    // Keywords
+    Int,
+    Float,
+    Double,
+    Char,
+    If,
+    Else,
+    While,
+    For,
+    Return,
+    Class,
+    Void,
+    Public,
+    Private,
+    Const,
+    Static,
+    Struct,
+    Bool,
+    True,
+    False,
+    Switch,
+    Case,
+    Default,
+    Break,
+    Continue,
+    Do,
+
+    // Single-character punctuation
+    Exclaim,
+    Quote,
+    Hash,
+    Dollar,
+    Percent,
+    Amp,
+    Apostrophe,
+    LParen,
+    RParen,
+    Star,
+    Plus,
+    Comma,
+    Minus,
+    Dot,
+    Slash,
+    Colon,
+    Semi,
+    Less,
+    Assign,
+    Greater,
+    Question,
+    At,
+    LBracket,
+    Backslash,
+    RBracket,
+    Caret,
+    Backtick,
+    LBrace,
+    Pipe,
+    RBrace,
+    Tilde,
+
+    // Multi-character operators
+    PlusAssign,
+    MinusAssign,
+    StarAssign,
+    SlashAssign,
+    PercentAssign,
+    AmpAssign,
+    PipeAssign,
+    CaretAssign,
+    Equal,
+    NotEqual,
+    LessEqual,
+    GreaterEqual,
+    AndAnd,
+    OrOr,
+    PlusPlus,
+    MinusMinus,
+    Arrow,
+    ColonColon,
+    ShiftLeft,
+    ShiftRight,
+    ShiftLeftAssign,
+    ShiftRightAssign,
+    ArrowStar,
+    DotStar,
+    Ellipsis,
+
+    // Placeholders for stripped literals
+    StringLiteral,
+    CharLiteral,
+
+    // Any byte that is neither punctuation nor part of an identifier
+    Unknown,
+
+    PredefinedCount,
+
+    FirstKeyword = Int,
+    LastKeyword = Do,
+};
+}  // namespace Sym
+
+// Side table that maps symbol ids back to text. Normalized variables
+// (VAR_1, VAR_2, ...) live in their own id range above the predefined ones,
+// so every id is stable across runs and threads without a shared interner.
+class SymbolTable {
+   public:
+    static const SymbolId kFirstVariable = 1024;
+    static const SymbolId kNoSymbol = 0xFFFFFFFFu;
+
+    // Keyword id for a word, or kNoSymbol
+    static SymbolId keyword(std::string_view word);
+
+    // Id of a punctuation character or operator spelling, or kNoSymbol
+    static SymbolId punctuation(std::string_view spelling);
+
+    // Id of the n-th normalized variable (1-based, i.e. VAR_n)
+    static SymbolId variable(std::uint32_t ordinal) { return kFirstVariable + ordinal - 1; }
+
+    static bool isKeyword(SymbolId id) { return id <= Sym::LastKeyword; }
+    static bool isVariable(SymbolId id) { return id >= kFirstVariable && id != kNoSymbol; }
+
+    // Text of a symbol ("if", "+=", "VAR_3")
+    static std::string spelling(SymbolId id);
+};
+
+#endif
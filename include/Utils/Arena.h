@@ -0,0 +1,54 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <memory_resource>
+
+// Bump allocator for short-lived analysis state (one file, one pair).
+// Allocation moves a pointer and deallocation does nothing; reset() releases
+// everything at once. After a reset the arena keeps one chunk as large as
+// everything handed out so far, so a long-lived arena stops calling the
+// system allocator once it has seen its largest workload.
+//
+// Not thread-safe: give every worker its own arena.
+class Arena : public std::pmr::memory_resource {
+   public:
+    explicit Arena(std::size_t initial_size = 64 * 1024);
+    ~Arena() override;
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // Release every allocation made since the last reset
+    void reset();
+
+    // Bytes handed out since the last reset
+    std::size_t used() const { return allocated; }
+
+    // Bytes held in chunks
+    std::size_t capacity() const { return reserved; }
+
+   private:
+    struct Chunk {
+        Chunk* next;
+        std::size_t size;  // usable bytes after the header
+    };
+
+    Chunk* chunks = nullptr;  // newest first
+    char* cursor = nullptr;
+    char* limit = nullptr;
+    std::size_t allocated = 0;
+    std::size_t reserved = 0;
+    std::size_t next_size;
+
+    void addChunk(std::size_t min_size);
+    void freeChunks();
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void*, std::size_t, std::size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+#endif
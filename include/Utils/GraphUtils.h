@@ -35,7 +35,9 @@ public:
 // Graph algorithms
 class GraphAlgorithms {
 public:
-    // Calculate simple graph similarity (node count based)
+    // Similarity of two graphs given as node labels (e.g. WLKernel labels):
+    // multiset Jaccard, so equal-sized graphs with different labels no
+    // longer count as identical
     static double calculateSimilarity(const std::vector<int>& graph1_structure, 
                                     const std::vector<int>& graph2_structure);
     
@@ -0,0 +1,28 @@
+#ifndef JSON_H
+#define JSON_H
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Just enough JSON for line protocols and reports: flat objects whose
+// members are strings, numbers, booleans or null
+class Json {
+   public:
+    // Member name -> decoded string, or the literal text of a number,
+    // boolean or null
+    using Object = std::unordered_map<std::string, std::string>;
+
+    // Parse one object. Returns false and sets `error` on malformed input
+    // and on nested objects or arrays.
+    static bool parseObject(std::string_view text, Object& object, std::string& error);
+
+    // `text` as a quoted JSON string
+    static std::string quote(std::string_view text);
+
+    // Shortest form that reads back as the same double; null for NaN and
+    // infinities, which JSON cannot represent
+    static std::string number(double value);
+};
+
+#endif
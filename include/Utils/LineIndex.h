@@ -0,0 +1,26 @@
+#ifndef LINEINDEX_H
+#define LINEINDEX_H
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Line and column of byte offsets in one text, from the offsets of its line
+// starts. Lookups are a binary search, so reports can map any number of
+// token spans back to lines without re-reading the file.
+class LineIndex {
+   public:
+    LineIndex() = default;
+    explicit LineIndex(std::string_view text);
+
+    // 1-based line and column of the byte at `offset`
+    std::uint32_t line(std::uint32_t offset) const;
+    std::uint32_t column(std::uint32_t offset) const;
+
+    std::uint32_t lineCount() const { return static_cast<std::uint32_t>(starts.size()); }
+
+   private:
+    std::vector<std::uint32_t> starts;  // offset of the first byte of each line
+};
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Stage timings and counters of the analysis pipeline. The METRIC_TIME and
+// METRIC_COUNT hooks compile to nothing unless the whole build defines
+// SIMILARITY_METRICS, so a normal build pays nothing for them; the
+// reporting functions exist either way and report zeros when disabled.
+//
+// Every thread records into its own counters without synchronization;
+// totals() sums the live threads and those that have exited. Stages nest:
+// score time includes the match, semantic and fingerprint time of the
+// same pair.
+class Metrics {
+   public:
+    enum Stage {
+        Normalize,
+        BuildCFG,
+        BuildFunctions,
+        Match,
+        Semantic,
+        Fingerprint,
+        Score,
+        kStageCount
+    };
+
+    enum Counter {
+        Files,             // token streams produced by the Normalizer
+        Tokens,
+        Blocks,            // basic blocks built
+        Edges,
+        Functions,         // function CFGs split off by buildFunctions
+        PairsScored,       // Scorer::calculate calls
+        PairsAbandoned,    // of those, ruled out below the threshold early
+        BlockCandidates,   // block pairs the matcher had to weigh
+        BlockComparisons,  // SemanticHasher::compareBlocks calls
+        Allocations,       // operator new calls
+        AllocatedBytes,
+        kCounterCount
+    };
+
+    struct Totals {
+        std::uint64_t counters[kCounterCount];
+        std::uint64_t stage_nanoseconds[kStageCount];
+        std::uint64_t stage_calls[kStageCount];
+    };
+
+    static constexpr bool enabled() {
+#ifdef SIMILARITY_METRICS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    static void count(Counter counter, std::uint64_t amount);
+    static void time(Stage stage, std::uint64_t nanoseconds);
+
+    // Everything recorded since start-up or the last reset()
+    static Totals totals();
+    static void reset();
+
+    static std::string json();
+    static std::string prometheus();
+
+    static const char* name(Stage stage);
+    static const char* name(Counter counter);
+
+    // Adds the lifetime of the scope to a stage
+    class Timer {
+       public:
+        explicit Timer(Stage stage) : stage(stage), start(std::chrono::steady_clock::now()) {}
+        ~Timer() {
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            time(stage, static_cast<std::uint64_t>(
+                            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+        }
+        Timer(const Timer&) = delete;
+        Timer& operator=(const Timer&) = delete;
+
+       private:
+        Stage stage;
+        std::chrono::steady_clock::time_point start;
+    };
+};
+
+#define METRIC_CONCAT_(a, b) a##b
+#define METRIC_CONCAT(a, b) METRIC_CONCAT_(a, b)
+
+#ifdef SIMILARITY_METRICS
+#define METRIC_TIME(stage) Metrics::Timer METRIC_CONCAT(metric_timer_, __LINE__)(Metrics::stage)
+#define METRIC_COUNT(counter, amount) Metrics::count(Metrics::counter, static_cast<std::uint64_t>(amount))
+#else
+#define METRIC_TIME(stage) static_cast<void>(0)
+#define METRIC_COUNT(counter, amount) static_cast<void>(0)
+#endif
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef SOURCEFILE_H
+#define SOURCEFILE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Read-only contents of a source file. Regular files are memory-mapped so
+// the text is never copied onto the heap; pipes, stdin ("-") and anything
+// that cannot be mapped are read into a buffer instead.
+class SourceFile {
+   public:
+    SourceFile() = default;
+    ~SourceFile();
+
+    SourceFile(SourceFile&& other) noexcept;
+    SourceFile& operator=(SourceFile&& other) noexcept;
+    SourceFile(const SourceFile&) = delete;
+    SourceFile& operator=(const SourceFile&) = delete;
+
+    // Load `path`; returns false and sets error() when it cannot be read
+    bool open(const std::string& path);
+
+    // Release the mapping or buffer
+    void close();
+
+    std::string_view view() const { return std::string_view(data, length); }
+    std::size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+    bool isMapped() const { return mapped; }
+    const std::string& error() const { return error_message; }
+
+   private:
+    const char* data = nullptr;
+    std::size_t length = 0;
+    bool mapped = false;
+    std::string buffer;
+    std::string error_message;
+
+    bool readAll(int fd);
+};
+
+#endif
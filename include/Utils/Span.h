@@ -0,0 +1,36 @@
+#ifndef SPAN_H
+#define SPAN_H
+
+#include <cstddef>
+#include <vector>
+
+// Read-only view of a contiguous range, valid while the storage it points
+// into is alive and unmodified
+template <typename T>
+class Span {
+   public:
+    Span() = default;
+    Span(const T* data, std::size_t size) : first(data), count(size) {}
+    template <typename Allocator>
+    Span(const std::vector<T, Allocator>& values) : first(values.data()), count(values.size()) {}
+
+    const T* begin() const { return first; }
+    const T* end() const { return first + count; }
+    const T* data() const { return first; }
+    const T& operator[](std::size_t index) const { return first[index]; }
+    const T& front() const { return first[0]; }
+    const T& back() const { return first[count - 1]; }
+
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    Span subspan(std::size_t offset, std::size_t length) const { return Span(first + offset, length); }
+
+    std::vector<T> toVector() const { return std::vector<T>(begin(), end()); }
+
+   private:
+    const T* first = nullptr;
+    std::size_t count = 0;
+};
+
+#endif
@@ -1,7 +1,9 @@
 #ifndef STRINGUTILS_H
 #define STRINGUTILS_H
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 
 class StringUtils {
@@ -17,12 +19,26 @@ class StringUtils {
 
     // String similarity functions
     static double calculateJaccardSimilarity(const std::string& str1, const std::string& str2);
+    // Bit-parallel edit distance (Myers/Hyyro), O(ceil(m / 64) * n) time
+    // and O(m / 64) memory for lengths m <= n
     static int calculateLevenshteinDistance(const std::string& str1, const std::string& str2);
+    static int calculateLevenshteinDistance(const std::vector<std::uint32_t>& seq1,
+                                            const std::vector<std::uint32_t>& seq2);
+    // Edit distance when it is at most max_distance, else max_distance + 1.
+    // Only the diagonal band of that width is computed, and the search stops
+    // as soon as a whole row of the band exceeds the bound.
+    static int calculateLevenshteinDistance(const std::string& str1, const std::string& str2,
+                                            int max_distance);
+    static int calculateLevenshteinDistance(const std::vector<std::uint32_t>& seq1,
+                                            const std::vector<std::uint32_t>& seq2,
+                                            int max_distance);
     static double calculateCosineSimilarity(const std::string& str1, const std::string& str2);
 
     // Hash functions
     static std::string calculateHash(const std::string& input);
     static std::size_t simpleHash(const std::string& str);
+    // Fast 64-bit hash of raw file contents (stable across runs and platforms)
+    static std::uint64_t contentHash(std::string_view data);
 
     // File operations
     static std::string readFile(const std::string& filename);
@@ -0,0 +1,72 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing thread pool. Every worker owns a deque: it pops its own work
+// from the back and, once empty, steals from the front of the other workers.
+class ThreadPool {
+   public:
+    using Task = std::function<void()>;
+
+    // threads == 0 uses the hardware concurrency
+    explicit ThreadPool(unsigned threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Queue a task. Tasks submitted from a worker go to that worker's deque.
+    void submit(Task task);
+
+    // Block until every submitted task has finished, helping to run them.
+    // Rethrows the first exception thrown by a task. Waits for every
+    // caller's tasks, so it must not be called from inside a task.
+    void wait();
+
+    // Run fn(begin, end) over [0, count) in chunks of at most `grain` items
+    // and wait for completion. Completion and exceptions are per call, so
+    // concurrent callers, and calls from inside a task, wait only for
+    // their own chunks; rethrows the first exception thrown by fn.
+    void parallelFor(std::size_t count, std::size_t grain,
+                     const std::function<void(std::size_t, std::size_t)>& fn);
+
+    // Number of workers, counted by their queues, which are all in place
+    // before the first worker starts and may call this
+    unsigned size() const { return static_cast<unsigned>(queues.size()); }
+
+   private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex state_mutex;
+    std::condition_variable work_available;
+    std::condition_variable work_done;
+    std::size_t queued = 0;   // tasks sitting in a deque
+    std::size_t pending = 0;  // tasks submitted but not yet finished
+    bool stopping = false;
+    std::exception_ptr first_error;
+
+    std::atomic<unsigned> next_queue{0};
+
+    void workerLoop(unsigned index);
+    bool tryPop(unsigned index, Task& task);
+    bool trySteal(unsigned index, Task& task);
+    void runTask(Task& task);
+};
+
+#endif
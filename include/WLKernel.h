@@ -0,0 +1,57 @@
+#ifndef WLKERNEL_H
+#define WLKERNEL_H
+
+#include <cstdint>
+#include <vector>
+
+#include "CFGBuilder.h"
+
+struct WLOptions {
+    int iterations = 3;  // relabeling rounds; round h sees paths of length h
+    int bits = 20;       // feature space of 2^bits buckets
+};
+
+// One nonzero bucket of a feature vector
+struct WLFeature {
+    std::uint32_t index;
+    float weight;
+};
+
+// Sparse feature vector, sorted by bucket index
+struct WLVector {
+    std::vector<WLFeature> features;
+    double norm = 0.0;  // Euclidean
+};
+
+// Weisfeiler-Lehman subtree kernel over CFGs. Every block starts with its
+// semantic signature as label; each round relabels a block with a hash of
+// its label and the sorted labels of its successors and predecessors. The
+// labels of all rounds are counted into a fixed space of hashed buckets, so
+// two CFGs compare by a sparse dot product in time linear in their sizes,
+// independent of how their blocks would be matched. Meant for screening:
+// pairs that score low here need not go through StructuralMatcher.
+class WLKernel {
+   public:
+    explicit WLKernel(const WLOptions& options = WLOptions());
+
+    WLVector vectorize(const CFGBuilder::CFG& cfg) const;
+
+    // Block labels after the given round (0 = seeds), in block order
+    std::vector<std::uint64_t> labels(const CFGBuilder::CFG& cfg, int round) const;
+
+    static double dot(const WLVector& vector1, const WLVector& vector2);
+
+    // Normalized dot product; 1.0 for two empty vectors, 0.0 for one
+    static double cosine(const WLVector& vector1, const WLVector& vector2);
+
+    const WLOptions& options() const { return opts; }
+
+   private:
+    WLOptions opts;
+
+    // Call emit(round, labels) for the seeds and after every round
+    template <typename Emit>
+    void relabel(const CFGBuilder::CFG& cfg, int rounds, Emit emit) const;
+};
+
+#endif
@@ -1,32 +1,39 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
+#include "include/Aligner.h"
 #include "include/CFGBuilder.h"
+#include "include/Corpus.h"
+#include "include/CorpusIndex.h"
 #include "include/Normalizer.h"
+#include "include/PersistentIndex.h"
 #include "include/Scorer.h"
+#include "include/Server.h"
+#include "include/Utils/LineIndex.h"
+#include "include/Utils/Metrics.h"
+#include "include/Utils/SourceFile.h"
 
-std::string readFile(const std::string& filename) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
+std::string_view readFile(const std::string& filename, SourceFile& file) {
+    if (!file.open(filename)) {
         std::cerr << "Error: Cannot open file '" << filename << "'" << std::endl;
         std::cerr << "   Make sure the file exists in the current directory." << std::endl;
-        return "";
+        return std::string_view();
     }
 
-    std::string content;
-    std::string line;
-    while (std::getline(file, line)) {
-        content += line + "\n";
-    }
-    file.close();
-
-    if (content.empty()) {
+    if (file.empty()) {
         std::cerr << "Warning: File '" << filename << "' is empty." << std::endl;
     }
 
-    return content;
+    return file.view();
 }
 
 void printHeader() {
@@ -36,7 +43,8 @@ void printHeader() {
     std::cout << "==============================================" << std::endl;
 }
 
-void printResults(const Scorer::Score& score, const std::string& file1, const std::string& file2) {
+void printResults(const Scorer::Score& score, const std::vector<AlignedRegion>& regions,
+                  double aligned, const std::string& file1, const std::string& file2) {
     std::cout << "\nANALYSIS RESULTS:" << std::endl;
     std::cout << "----------------------------------------------" << std::endl;
     std::cout << "Files Compared: " << file1 << " <-> " << file2 << std::endl;
@@ -45,10 +53,38 @@ void printResults(const Scorer::Score& score, const std::string& file1, const st
     std::cout << std::fixed << std::setprecision(1);
     std::cout << "Structural Similarity: " << score.structural * 100 << "%" << std::endl;
     std::cout << "Semantic Similarity:   " << score.semantic * 100 << "%" << std::endl;
+    std::cout << "Fingerprint Overlap:   " << score.fingerprint * 100 << "%" << std::endl;
     std::cout << "Overall Similarity:    " << score.overall * 100 << "%" << std::endl;
     std::cout << "Matched Blocks:        " << score.matched_blocks << "/" << score.total_blocks
               << std::endl;
+    std::cout << "Aligned Tokens:        " << aligned * 100 << "% in " << regions.size()
+              << " regions" << std::endl;
 
+    if (!regions.empty()) {
+        // Longest regions, listed in file order
+        const std::size_t kShown = 10;
+        std::vector<AlignedRegion> shown = regions;
+        std::stable_sort(shown.begin(), shown.end(), [](const AlignedRegion& a, const AlignedRegion& b) {
+            return a.length1 > b.length1;
+        });
+        shown.resize(std::min(shown.size(), kShown));
+        std::sort(shown.begin(), shown.end(), [](const AlignedRegion& a, const AlignedRegion& b) {
+            return a.first1 < b.first1;
+        });
+
+        std::cout << "\nMATCHED REGIONS:" << std::endl;
+        for (const AlignedRegion& region : shown) {
+            std::cout << "   lines " << region.line_begin1 << "-" << region.line_end1 << " <-> lines "
+                      << region.line_begin2 << "-" << region.line_end2 << "  (" << region.length1
+                      << " tokens)" << std::endl;
+        }
+        if (regions.size() > shown.size()) {
+            std::cout << "   ... " << regions.size() - shown.size() << " shorter regions" << std::endl;
+        }
+    }
+}
+
+void printVerdict(const Scorer::Score& score) {
     std::cout << "\nVERDICT:" << std::endl;
     if (score.overall >= 0.90) {
         std::cout << "VERY HIGH SIMILARITY (>=90%) - Very likely plagiarism!" << std::endl;
@@ -65,19 +101,394 @@ void printResults(const Scorer::Score& score, const std::string& file1, const st
     std::cout << "----------------------------------------------" << std::endl;
 }
 
+// Line range of a function, from the token spans of its file
+std::pair<std::uint32_t, std::uint32_t> functionLines(const CFGBuilder::CFG& file,
+                                                      const CFGBuilder::FunctionCFG& function,
+                                                      const LineIndex& lines) {
+    if (file.spans.size() < function.first_token + function.token_count || function.token_count == 0) {
+        return {0, 0};
+    }
+    const SourceSpan& first = file.spans[function.first_token];
+    const SourceSpan& last = file.spans[function.first_token + function.token_count - 1];
+    return {lines.line(first.offset), lines.line(last.offset + last.length - 1)};
+}
+
+void printFunctionMatches(const Scorer::FunctionScore& functions, const CFGBuilder::CFG& cfg1,
+                          const std::vector<CFGBuilder::FunctionCFG>& functions1, const LineIndex& lines1,
+                          const CFGBuilder::CFG& cfg2,
+                          const std::vector<CFGBuilder::FunctionCFG>& functions2, const LineIndex& lines2) {
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "\nFunction Similarity:   " << functions.score.overall * 100 << "% ("
+              << functions.matches.size() << " pairs of " << functions.rows << " and " << functions.cols
+              << " functions)" << std::endl;
+    if (functions.matches.empty()) {
+        return;
+    }
+
+    // Closest pairs first
+    const std::size_t kShown = 10;
+    std::vector<Scorer::FunctionMatch> shown = functions.matches;
+    std::stable_sort(shown.begin(), shown.end(), [](const Scorer::FunctionMatch& a, const Scorer::FunctionMatch& b) {
+        return a.similarity > b.similarity;
+    });
+    shown.resize(std::min(shown.size(), kShown));
+
+    std::cout << "FUNCTION MATCHES:" << std::endl;
+    for (const Scorer::FunctionMatch& match : shown) {
+        auto range1 = functionLines(cfg1, functions1[match.function1], lines1);
+        auto range2 = functionLines(cfg2, functions2[match.function2], lines2);
+        std::cout << "   " << std::setw(5) << match.similarity * 100 << "%  lines " << range1.first << "-"
+                  << range1.second << " <-> lines " << range2.first << "-" << range2.second << std::endl;
+    }
+}
+
+void printRankedPairs(const Corpus& corpus, const std::vector<PairResult>& pairs,
+                      std::size_t top) {
+    std::size_t n = corpus.entries().size();
+
+    std::cout << "\nRANKED PAIRS:" << std::endl;
+    std::cout << "----------------------------------------------" << std::endl;
+    std::cout << "Files: " << n << "   Pairs: " << n * (n - 1) / 2
+              << "   Reported: " << std::min(top, pairs.size()) << std::endl;
+    std::cout << "----------------------------------------------" << std::endl;
+
+    std::cout << std::fixed << std::setprecision(1);
+    for (std::size_t rank = 0; rank < pairs.size() && rank < top; rank++) {
+        const PairResult& pair = pairs[rank];
+        std::cout << std::setw(5) << rank + 1 << ". " << std::setw(5)
+                  << pair.score.overall * 100 << "%  " << corpus.entries()[pair.first].path
+                  << " <-> " << corpus.entries()[pair.second].path << "  (structural "
+                  << pair.score.structural * 100 << "%, semantic " << pair.score.semantic * 100 << "%";
+        // Pair scoring only hashes fingerprints when they are weighted
+        if (corpus.fingerprintWeight() > 0.0) {
+            std::cout << ", fingerprint " << pair.score.fingerprint * 100 << "%";
+        }
+        std::cout << ")" << std::endl;
+    }
+
+    std::cout << "----------------------------------------------" << std::endl;
+}
+
+int runCorpus(int argc, char* argv[]) {
+    std::string source;
+    unsigned threads = 0;
+    std::size_t top = static_cast<std::size_t>(-1);
+    double min_score = 0.0;
+    std::string index_path;
+    CandidateOptions candidates;
+    double fingerprint_weight = 0.0;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+
+        if (arg == "--corpus" && has_value) {
+            source = argv[++i];
+        } else if (arg == "--threads" && has_value) {
+            threads = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (arg == "--top" && has_value) {
+            top = static_cast<std::size_t>(std::atol(argv[++i]));
+        } else if (arg == "--min-score" && has_value) {
+            min_score = std::atof(argv[++i]) / 100.0;
+        } else if (arg == "--index" && has_value) {
+            index_path = argv[++i];
+        } else if (arg == "--fingerprint-weight" && has_value) {
+            fingerprint_weight = std::atof(argv[++i]) / 100.0;
+        } else if (arg == "--lsh-threshold" && has_value) {
+            candidates.threshold = std::atof(argv[++i]) / 100.0;
+        } else if (arg == "--lsh-recall" && has_value) {
+            candidates.recall = std::atof(argv[++i]) / 100.0;
+        } else {
+            std::cout << "\nError: Unknown or incomplete option '" << arg << "'" << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<std::string> paths = Corpus::collectFiles(source);
+    std::cout << "\nAnalyzing corpus: " << source << " (" << paths.size() << " files)"
+              << std::endl;
+
+    try {
+        Corpus corpus;
+        // Fingerprint overlap takes its share; structural and semantic keep 40:60
+        corpus.setWeights(0.4 * (1.0 - fingerprint_weight), 0.6 * (1.0 - fingerprint_weight),
+                          fingerprint_weight);
+        corpus.setCandidateFilter(candidates);
+
+        // Results of the previous run, if any; a missing index is not an error
+        PersistentIndex previous;
+        bool have_previous = false;
+        if (!index_path.empty()) {
+            have_previous = previous.open(index_path);
+            if (!have_previous && std::filesystem::exists(index_path)) {
+                std::cerr << "Warning: Ignoring index '" << index_path << "': " << previous.error()
+                          << std::endl;
+            }
+        }
+        const PersistentIndex* baseline = have_previous ? &previous : nullptr;
+
+        std::cout << "Processing tokens..." << std::endl;
+        corpus.load(paths, threads, baseline);
+
+        if (corpus.entries().size() < 2) {
+            std::cout << "\nError: Corpus mode needs at least two readable files." << std::endl;
+            return 1;
+        }
+
+        std::cout << "Calculating similarity..." << std::endl;
+        auto pairs = corpus.scoreAllPairs(threads, min_score, baseline);
+
+        printRankedPairs(corpus, pairs, top);
+
+        const CorpusStats& stats = corpus.stats();
+        std::cout << "Files analyzed: " << stats.files_analyzed << "   reused: " << stats.files_reused
+                  << "   Pairs scored: " << stats.pairs_scored << "   reused: " << stats.pairs_reused
+                  << "   pruned: " << stats.pairs_pruned << std::endl;
+
+        if (!index_path.empty()) {
+            std::string error;
+            if (!PersistentIndex::write(index_path, corpus, pairs, min_score, error)) {
+                std::cerr << "Warning: Could not update index: " << error << std::endl;
+            }
+        }
+
+    } catch (const std::exception& e) {
+        std::cerr << "\nError during analysis: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+// A readable index is used as is; otherwise the corpus is analyzed and,
+// with an index path, saved for the next run
+bool loadIndex(CorpusIndex& index, const std::string& index_path, const std::string& source) {
+    if (!index_path.empty() && index.open(index_path)) {
+        return true;
+    }
+    if (source.empty()) {
+        std::cout << "\nError: No usable index and no --corpus to build one from";
+        if (!index.error().empty()) {
+            std::cout << " (" << index.error() << ")";
+        }
+        std::cout << "." << std::endl;
+        return false;
+    }
+    std::vector<std::string> paths = Corpus::collectFiles(source);
+    std::cout << "\nAnalyzing corpus: " << source << " (" << paths.size() << " files)" << std::endl;
+    index.build(paths);
+    if (!index_path.empty() && !index.save(index_path)) {
+        std::cerr << "Warning: Could not write index: " << index.error() << std::endl;
+    }
+    return true;
+}
+
+int runQuery(int argc, char* argv[]) {
+    std::string query_path, source, index_path;
+    unsigned threads = 0;
+    QueryOptions options;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+
+        if (arg == "--query" && has_value) {
+            query_path = argv[++i];
+        } else if (arg == "--corpus" && has_value) {
+            source = argv[++i];
+        } else if (arg == "--index" && has_value) {
+            index_path = argv[++i];
+        } else if (arg == "--threads" && has_value) {
+            threads = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (arg == "--top" && has_value) {
+            options.top_k = static_cast<std::size_t>(std::atol(argv[++i]));
+        } else if (arg == "--screen" && has_value) {
+            options.screened = static_cast<std::size_t>(std::atol(argv[++i]));
+        } else if (arg == "--min-score" && has_value) {
+            options.min_score = std::atof(argv[++i]) / 100.0;
+        } else {
+            std::cout << "\nError: Unknown or incomplete option '" << arg << "'" << std::endl;
+            return 1;
+        }
+    }
+
+    SourceFile query_source;
+    std::string_view code = readFile(query_path, query_source);
+    if (code.empty()) {
+        std::cout << "\nError: The query file is empty or couldn't be read." << std::endl;
+        return 1;
+    }
+
+    try {
+        CorpusIndex index(threads);
+        if (!loadIndex(index, index_path, source)) {
+            return 1;
+        }
+
+        QueryStats stats;
+        auto neighbors = index.query(code, options, &stats);
+
+        std::cout << "\nNEAREST FILES:" << std::endl;
+        std::cout << "----------------------------------------------" << std::endl;
+        std::cout << "Query: " << query_path << "   Corpus: " << stats.entries
+                  << " files   Scored: " << stats.scored << std::endl;
+        std::cout << "----------------------------------------------" << std::endl;
+        std::cout << std::fixed << std::setprecision(1);
+        for (std::size_t rank = 0; rank < neighbors.size(); rank++) {
+            const Neighbor& neighbor = neighbors[rank];
+            std::cout << std::setw(5) << rank + 1 << ". " << std::setw(5) << neighbor.score.overall * 100
+                      << "%  " << index.entry(neighbor.entry).path << "  (structural "
+                      << neighbor.score.structural * 100 << "%, semantic " << neighbor.score.semantic * 100
+                      << "%)" << std::endl;
+        }
+        std::cout << "----------------------------------------------" << std::endl;
+
+    } catch (const std::exception& e) {
+        std::cerr << "\nError during analysis: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+int runServe(int argc, char* argv[]) {
+    std::string source, index_path;
+    ServerOptions options;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+
+        if (arg == "--serve") {
+            continue;
+        } else if (arg == "--socket" && has_value) {
+            options.socket_path = argv[++i];
+        } else if (arg == "--port" && has_value) {
+            options.port = std::atoi(argv[++i]);
+        } else if (arg == "--corpus" && has_value) {
+            source = argv[++i];
+        } else if (arg == "--index" && has_value) {
+            index_path = argv[++i];
+        } else if (arg == "--threads" && has_value) {
+            options.threads = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else {
+            std::cout << "\nError: Unknown or incomplete option '" << arg << "'" << std::endl;
+            return 1;
+        }
+    }
+    if (options.socket_path.empty() && options.port == 0) {
+        std::cout << "\nError: Server mode needs --socket PATH or --port N." << std::endl;
+        return 1;
+    }
+
+    try {
+        // Starting empty is fine: files can be added over the socket, and
+        // the index is written on shutdown
+        CorpusIndex index(options.threads);
+        bool have_index = !index_path.empty() && std::filesystem::exists(index_path);
+        if ((have_index || !source.empty()) && !loadIndex(index, index_path, source)) {
+            return 1;
+        }
+
+        Server server(index, options);
+        if (!server.listen()) {
+            std::cout << "\nError: Cannot listen: " << server.error() << std::endl;
+            return 1;
+        }
+        std::cout << "\nServing " << index.size() << " files on "
+                  << (options.socket_path.empty() ? "127.0.0.1:" + std::to_string(server.port())
+                                                  : options.socket_path)
+                  << std::endl;
+        server.run();
+
+        if (!index_path.empty() && !index.save(index_path)) {
+            std::cerr << "Warning: Could not write index: " << index.error() << std::endl;
+        }
+
+    } catch (const std::exception& e) {
+        std::cerr << "\nError during analysis: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
 void printUsage(const std::string& program_name) {
     std::cout << "\nUSAGE:" << std::endl;
-    std::cout << "   " << program_name << " <file1.cpp> <file2.cpp>" << std::endl;
+    std::cout << "   " << program_name << " <file1.cpp> <file2.cpp>   (use - for stdin)" << std::endl;
+    std::cout << "   " << program_name
+              << " --corpus <directory|list.txt> [--threads N] [--top K] [--min-score PERCENT]"
+              << " [--index FILE]" << std::endl;
+    std::cout << "        [--fingerprint-weight PERCENT] [--lsh-threshold PERCENT] [--lsh-recall PERCENT]"
+              << std::endl;
+    std::cout << "   " << program_name
+              << " --query <file.cpp> --index FILE [--corpus <directory|list.txt>] [--top K] [--screen N]"
+              << " [--min-score PERCENT] [--threads N]" << std::endl;
+    std::cout << "   " << program_name
+              << " --serve (--socket PATH | --port N) [--index FILE] [--corpus <directory|list.txt>]"
+              << " [--threads N]" << std::endl;
+    std::cout << "\n   Any mode: [--metrics FILE|-] [--metrics-format json|prometheus]"
+              << " (needs a build with -DSIMILARITY_METRICS)" << std::endl;
     std::cout << "\nEXAMPLES:" << std::endl;
     std::cout << "   " << program_name << " student1.cpp student2.cpp" << std::endl;
     std::cout << "   " << program_name << " assignment1.cpp assignment2.cpp" << std::endl;
+    std::cout << "   " << program_name << " --corpus submissions/ --top 20 --min-score 75"
+              << std::endl;
+    std::cout << "   " << program_name << " --corpus archive.txt --lsh-threshold 30 --lsh-recall 99"
+              << std::endl;
+    std::cout << "   " << program_name << " --query upload.cpp --index archive.idx --corpus archive/ --top 10"
+              << std::endl;
+    std::cout << "   " << program_name << " --serve --socket /tmp/checker.sock --index archive.idx" << std::endl;
     std::cout << "\nNOTE: Place your .cpp files in the same directory as this program."
               << std::endl;
 }
 
+// Destination of --metrics, written when the process exits
+std::string metrics_path;
+std::string metrics_format = "json";
+
+void writeMetrics() {
+    std::string report = metrics_format == "prometheus" ? Metrics::prometheus() : Metrics::json() + "\n";
+    if (metrics_path == "-") {
+        std::cout << report << std::flush;
+    } else if (!(std::ofstream(metrics_path) << report)) {
+        std::cerr << "Warning: Could not write metrics to '" << metrics_path << "'" << std::endl;
+    }
+}
+
 int main(int argc, char* argv[]) {
     printHeader();
 
+    // --metrics applies to every mode; the modes never see it
+    std::vector<char*> args;
+    for (int i = 0; i < argc; i++) {
+        std::string arg = argv[i];
+        if ((arg == "--metrics" || arg == "--metrics-format") && i + 1 < argc) {
+            (arg == "--metrics" ? metrics_path : metrics_format) = argv[++i];
+        } else {
+            args.push_back(argv[i]);
+        }
+    }
+    if (!metrics_path.empty()) {
+        if (!Metrics::enabled()) {
+            std::cerr << "Warning: Built without SIMILARITY_METRICS; metrics will be empty" << std::endl;
+        }
+        std::atexit(writeMetrics);
+    }
+    argc = static_cast<int>(args.size());
+    args.push_back(nullptr);
+    argv = args.data();
+
+    if (argc >= 3 && std::string(argv[1]) == "--corpus") {
+        return runCorpus(argc, argv);
+    }
+    if (argc >= 3 && std::string(argv[1]) == "--query") {
+        return runQuery(argc, argv);
+    }
+    if (argc >= 3 && std::string(argv[1]) == "--serve") {
+        return runServe(argc, argv);
+    }
+
     if (argc != 3) {
         std::cout << "\nError: Incorrect number of arguments." << std::endl;
         printUsage(argv[0]);
@@ -91,9 +502,10 @@ int main(int argc, char* argv[]) {
     std::cout << "   File 1: " << file1 << std::endl;
     std::cout << "   File 2: " << file2 << std::endl;
 
-    // Read the code files
-    std::string code1 = readFile(file1);
-    std::string code2 = readFile(file2);
+    // Map the code files; the views stay valid while source1/source2 live
+    SourceFile source1, source2;
+    std::string_view code1 = readFile(file1, source1);
+    std::string_view code2 = readFile(file2, source2);
 
     if (code1.empty() && code2.empty()) {
         std::cout << "\nBoth files are empty - 100% similarity" << std::endl;
@@ -117,20 +529,35 @@ int main(int argc, char* argv[]) {
         scorer.setWeights(0.4, 0.6);
 
         // Process first file
-        auto tokens1 = normalizer.process(code1);
-        auto cfg1 = cfgBuilder.build(tokens1);
+        std::vector<SourceSpan> spans1, spans2;
+        auto tokens1 = normalizer.process(code1, spans1);
+        auto cfg1 = cfgBuilder.build(std::move(tokens1), std::move(spans1));
 
         // Process second file
-        auto tokens2 = normalizer.process(code2);
-        auto cfg2 = cfgBuilder.build(tokens2);
+        auto tokens2 = normalizer.process(code2, spans2);
+        auto cfg2 = cfgBuilder.build(std::move(tokens2), std::move(spans2));
 
         std::cout << "Calculating similarity..." << std::endl;
 
         // Calculate similarity
         auto score = scorer.calculate(cfg1, cfg2);
 
+        // Shared token runs as evidence for the score
+        Aligner aligner;
+        auto regions = aligner.tile(cfg1.tokens, cfg2.tokens);
+        double aligned = Aligner::coverage(regions, cfg1.tokens.size(), cfg2.tokens.size());
+        LineIndex lines1(code1), lines2(code2);
+        Aligner::mapLines(regions, cfg1.spans, lines1, cfg2.spans, lines2);
+
+        // Function against function, paired one-to-one
+        auto functions1 = cfgBuilder.buildFunctions(cfg1.tokens);
+        auto functions2 = cfgBuilder.buildFunctions(cfg2.tokens);
+        auto function_score = scorer.calculateFunctions(functions1, functions2);
+
         // Display results
-        printResults(score, file1, file2);
+        printResults(score, regions, aligned, file1, file2);
+        printFunctionMatches(function_score, cfg1, functions1, lines1, cfg2, functions2, lines2);
+        printVerdict(score);
 
     } catch (const std::exception& e) {
         std::cerr << "\nError during analysis: " << e.what() << std::endl;
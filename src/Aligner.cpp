@@ -0,0 +1,313 @@
+#include "Aligner.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+const std::uint64_t kBase = 0x100000001b3ULL;
+
+// Token ids are unique across kinds; identifiers all become one id
+std::vector<std::uint32_t> tokenCodes(TokenSpan tokens) {
+    std::vector<std::uint32_t> codes(tokens.size());
+    for (std::size_t i = 0; i < tokens.size(); i++) {
+        codes[i] = tokens[i].kind == TokenKind::Identifier ? SymbolTable::kFirstVariable : tokens[i].symbol;
+    }
+    return codes;
+}
+
+// runs[i] = number of unmarked tokens starting at i
+void unmarkedRuns(const std::vector<char>& marked, std::vector<std::uint32_t>& runs) {
+    runs.assign(marked.size() + 1, 0);
+    for (std::size_t i = marked.size(); i-- > 0;) {
+        runs[i] = marked[i] ? 0 : runs[i + 1] + 1;
+    }
+}
+
+// Karp-Rabin hashes of every window of `length` codes
+void windowHashes(const std::vector<std::uint32_t>& codes, std::size_t length,
+                  std::vector<std::uint64_t>& hashes) {
+    hashes.clear();
+    if (codes.size() < length) {
+        return;
+    }
+    std::uint64_t leading = 1;
+    for (std::size_t i = 1; i < length; i++) {
+        leading *= kBase;
+    }
+    std::uint64_t rolling = 0;
+    for (std::size_t i = 0; i < length; i++) {
+        rolling = rolling * kBase + codes[i] + 1;
+    }
+    hashes.push_back(rolling);
+    for (std::size_t i = length; i < codes.size(); i++) {
+        rolling = (rolling - (codes[i - length] + 1) * leading) * kBase + codes[i] + 1;
+        hashes.push_back(rolling);
+    }
+}
+
+struct Match {
+    std::uint32_t first1, first2, length;
+};
+}  // namespace
+
+Aligner::Aligner(const AlignmentOptions& options) : opts(options) {
+    opts.min_tile = std::max(1, opts.min_tile);
+}
+
+std::vector<AlignedRegion> Aligner::tile(TokenSpan tokens1, TokenSpan tokens2) const {
+    std::vector<AlignedRegion> tiles;
+    const std::size_t minimum = static_cast<std::size_t>(opts.min_tile);
+    if (tokens1.size() < minimum || tokens2.size() < minimum) {
+        return tiles;
+    }
+
+    const std::vector<std::uint32_t> codes1 = tokenCodes(tokens1);
+    const std::vector<std::uint32_t> codes2 = tokenCodes(tokens2);
+    const std::size_t n1 = codes1.size(), n2 = codes2.size();
+
+    std::vector<char> marked1(n1, 0), marked2(n2, 0);
+    std::vector<std::uint32_t> runs1, runs2;
+    std::vector<std::uint64_t> hashes1, hashes2;
+    std::vector<std::pair<std::uint64_t, std::uint32_t>> table;
+    std::vector<Match> matches;
+
+    // Maximal unmarked matches of at least `length` tokens; returns the
+    // longest length found
+    auto scan = [&](std::size_t length) {
+        matches.clear();
+        unmarkedRuns(marked1, runs1);
+        unmarkedRuns(marked2, runs2);
+        windowHashes(codes1, length, hashes1);
+        windowHashes(codes2, length, hashes2);
+
+        table.clear();
+        for (std::size_t j = 0; j < hashes2.size(); j++) {
+            if (runs2[j] >= length) {
+                table.emplace_back(hashes2[j], static_cast<std::uint32_t>(j));
+            }
+        }
+        std::sort(table.begin(), table.end());
+
+        std::size_t longest = 0;
+        for (std::size_t i = 0; i < hashes1.size(); i++) {
+            if (runs1[i] < length) {
+                continue;
+            }
+            auto range = std::equal_range(table.begin(), table.end(),
+                                          std::make_pair(hashes1[i], std::uint32_t(0)),
+                                          [](const auto& x, const auto& y) { return x.first < y.first; });
+            for (auto it = range.first; it != range.second; ++it) {
+                std::size_t j = it->second;
+                // Only the left end of a run starts a match
+                if (i > 0 && j > 0 && !marked1[i - 1] && !marked2[j - 1] && codes1[i - 1] == codes2[j - 1]) {
+                    continue;
+                }
+                std::size_t k = 0;
+                std::size_t limit = std::min(runs1[i], runs2[j]);
+                while (k < limit && codes1[i + k] == codes2[j + k]) {
+                    k++;
+                }
+                if (k >= length) {
+                    matches.push_back({static_cast<std::uint32_t>(i), static_cast<std::uint32_t>(j),
+                                       static_cast<std::uint32_t>(k)});
+                    longest = std::max(longest, k);
+                }
+            }
+        }
+        return longest;
+    };
+
+    // Longest first; a match overlapping an earlier tile is dropped
+    auto markTiles = [&]() {
+        std::stable_sort(matches.begin(), matches.end(),
+                         [](const Match& x, const Match& y) { return x.length > y.length; });
+        bool marked_any = false;
+        for (const Match& match : matches) {
+            bool free = true;
+            for (std::uint32_t k = 0; k < match.length && free; k++) {
+                free = !marked1[match.first1 + k] && !marked2[match.first2 + k];
+            }
+            if (!free) {
+                continue;
+            }
+            std::fill_n(marked1.begin() + match.first1, match.length, 1);
+            std::fill_n(marked2.begin() + match.first2, match.length, 1);
+            tiles.push_back({match.first1, match.length, match.first2, match.length,
+                             static_cast<int>(match.length)});
+            marked_any = true;
+        }
+        return marked_any;
+    };
+
+    // Start with long windows, which hash few candidates, and halve down to
+    // the minimum; a match far longer than the window restarts the search
+    // at its length so that it is tiled before its pieces
+    std::size_t length = std::min(std::min(n1, n2), 4 * minimum);
+    while (true) {
+        std::size_t longest = scan(length);
+        if (longest > 2 * length) {
+            length = longest;
+            continue;
+        }
+        bool marked_any = markTiles();
+        if (length > 2 * minimum) {
+            length /= 2;
+        } else if (length > minimum) {
+            length = minimum;
+        } else if (!marked_any) {
+            break;
+        }
+    }
+
+    std::sort(tiles.begin(), tiles.end(),
+              [](const AlignedRegion& x, const AlignedRegion& y) { return x.first1 < y.first1; });
+    return tiles;
+}
+
+std::vector<AlignedRegion> Aligner::localAlignment(TokenSpan tokens1, TokenSpan tokens2) const {
+    std::vector<AlignedRegion> result;
+    bool swapped = tokens1.size() > tokens2.size();
+    if (swapped) {
+        std::swap(tokens1, tokens2);
+    }
+    const std::vector<std::uint32_t> codes1 = tokenCodes(tokens1);
+    const std::vector<std::uint32_t> codes2 = tokenCodes(tokens2);
+    const int n = static_cast<int>(codes1.size());  // the shorter stream
+    const int m = static_cast<int>(codes2.size());
+    if (n == 0) {
+        return result;
+    }
+
+    // Cell (i, j) lies on anti-diagonal i + j and is stored at index i of
+    // that diagonal's buffer. Its three predecessors lie on the two previous
+    // diagonals, so the inner loop has no dependencies between iterations
+    // and no branches. The second stream is read reversed so that both
+    // streams are walked forwards along a diagonal (after n slots of
+    // padding, so that offsets stay inside the buffer). Alongside each
+    // score runs the cell its alignment started from.
+    std::vector<std::uint32_t> reversed2(n, 0);
+    reversed2.insert(reversed2.end(), codes2.rbegin(), codes2.rend());
+    std::vector<int> score2(n + 1, 0), score1(n + 1, 0), score0(n + 1, 0);
+    std::vector<int> row2(n + 1, 0), row1(n + 1, 0), row0(n + 1, 0);  // start cell (row, diagonal)
+    std::vector<int> sum2(n + 1, 0), sum1(n + 1, 0), sum0(n + 1, 0);
+    const int match = opts.match, mismatch = opts.mismatch, gap = opts.gap;
+
+    int best = 0;
+    int best_row = 0, best_sum = 0, start_row = 0, start_sum = 0;
+
+    for (int d = 2; d <= n + m; d++) {
+        const int lo = std::max(1, d - m);
+        const int hi = std::min(n, d - 1);
+        const int column = n + m - d;  // reversed2[column + i] = codes2[d - i - 1]
+
+        const std::uint32_t* text = codes1.data();
+        const std::uint32_t* other = reversed2.data() + column;
+        const int* previous2 = score2.data();
+        const int* previous1 = score1.data();
+        const int* rows2 = row2.data();
+        const int* rows1 = row1.data();
+        const int* sums2 = sum2.data();
+        const int* sums1 = sum1.data();
+        int* scores = score0.data();
+        int* rows = row0.data();
+        int* sums = sum0.data();
+
+        int diagonal_best = 0;
+        for (int i = lo; i <= hi; i++) {
+            const int diagonal = previous2[i - 1] + (text[i - 1] == other[i] ? match : mismatch);
+            const int up = previous1[i - 1] + gap;
+            const int left = previous1[i] + gap;
+            const int up_row = rows1[i - 1], up_sum = sums1[i - 1];
+            const int left_row = rows1[i], left_sum = sums1[i];
+            const int diagonal_row = rows2[i - 1], diagonal_sum = sums2[i - 1];
+            const bool extends = previous2[i - 1] > 0;
+
+            int row = extends ? diagonal_row : i;
+            int sum = extends ? diagonal_sum : d;
+            int value = diagonal;
+            const bool take_up = up > value;
+            row = take_up ? up_row : row;
+            sum = take_up ? up_sum : sum;
+            value = take_up ? up : value;
+            const bool take_left = left > value;
+            row = take_left ? left_row : row;
+            sum = take_left ? left_sum : sum;
+            value = take_left ? left : value;
+            const bool positive = value > 0;
+            row = positive ? row : i;
+            sum = positive ? sum : d;
+            value = positive ? value : 0;
+
+            scores[i] = value;
+            rows[i] = row;
+            sums[i] = sum;
+            diagonal_best = std::max(diagonal_best, value);
+        }
+        if (diagonal_best > best) {
+            for (int i = lo; i <= hi; i++) {
+                if (score0[i] == diagonal_best) {
+                    best = diagonal_best;
+                    best_row = i;
+                    best_sum = d;
+                    start_row = row0[i];
+                    start_sum = sum0[i];
+                    break;
+                }
+            }
+        }
+
+        // Cell (d, 0) is a boundary cell, read by the next two diagonals
+        if (d <= n) {
+            score0[d] = 0;
+        }
+        std::swap(score2, score1);
+        std::swap(score1, score0);
+        std::swap(row2, row1);
+        std::swap(row1, row0);
+        std::swap(sum2, sum1);
+        std::swap(sum1, sum0);
+    }
+
+    if (best < opts.min_score || best == 0) {
+        return result;
+    }
+
+    std::uint32_t first1 = static_cast<std::uint32_t>(start_row - 1);
+    std::uint32_t first2 = static_cast<std::uint32_t>(start_sum - start_row - 1);
+    std::uint32_t length1 = static_cast<std::uint32_t>(best_row) - first1;
+    std::uint32_t length2 = static_cast<std::uint32_t>(best_sum - best_row) - first2;
+    if (swapped) {
+        std::swap(first1, first2);
+        std::swap(length1, length2);
+    }
+    result.push_back({first1, length1, first2, length2, best});
+    return result;
+}
+
+void Aligner::mapLines(std::vector<AlignedRegion>& regions, Span<SourceSpan> spans1,
+                       const LineIndex& lines1, Span<SourceSpan> spans2, const LineIndex& lines2) {
+    for (AlignedRegion& region : regions) {
+        if (region.length1 > 0 && region.first1 + region.length1 <= spans1.size()) {
+            const SourceSpan& last = spans1[region.first1 + region.length1 - 1];
+            region.line_begin1 = lines1.line(spans1[region.first1].offset);
+            region.line_end1 = lines1.line(last.offset + last.length - 1);
+        }
+        if (region.length2 > 0 && region.first2 + region.length2 <= spans2.size()) {
+            const SourceSpan& last = spans2[region.first2 + region.length2 - 1];
+            region.line_begin2 = lines2.line(spans2[region.first2].offset);
+            region.line_end2 = lines2.line(last.offset + last.length - 1);
+        }
+    }
+}
+
+double Aligner::coverage(const std::vector<AlignedRegion>& regions, std::size_t size1,
+                         std::size_t size2) {
+    if (size1 + size2 == 0) {
+        return 0.0;
+    }
+    std::size_t covered = 0;
+    for (const AlignedRegion& region : regions) {
+        covered += region.length1 + region.length2;
+    }
+    return std::min(1.0, static_cast<double>(covered) / static_cast<double>(size1 + size2));
+}
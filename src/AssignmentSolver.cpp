@@ -0,0 +1,228 @@
+#include "AssignmentSolver.h"
+
+#include <algorithm>
+#include <deque>
+#include <limits>
+
+AssignmentSolver::Algorithm AssignmentSolver::choose(int rows, int cols,
+                                                     const AssignmentBudget& budget) {
+    double n = std::max(rows, cols);
+    return n * n * n <= budget.max_dense_work ? Algorithm::Hungarian : Algorithm::Auction;
+}
+
+std::vector<std::pair<int, int>> AssignmentSolver::solve(int rows, int cols, Span<AssignmentEdge> edges,
+                                                         Algorithm algorithm,
+                                                         const AssignmentBudget& budget,
+                                                         std::pmr::memory_resource* memory) {
+    if (rows <= 0 || cols <= 0 || edges.empty()) {
+        return {};
+    }
+
+    if (algorithm == Algorithm::Auto) {
+        algorithm = choose(rows, cols, budget);
+    }
+
+    switch (algorithm) {
+        case Algorithm::Hungarian:
+            return hungarian(rows, cols, edges, memory);
+        case Algorithm::Auction:
+            return auction(rows, cols, edges, budget, memory);
+        default:
+            return greedy(rows, cols, edges, memory);
+    }
+}
+
+std::vector<std::pair<int, int>> AssignmentSolver::hungarian(int rows, int cols, Span<AssignmentEdge> edges,
+                                                             std::pmr::memory_resource* memory) {
+    // Square minimization problem of size n; missing edges cost 0 and stand
+    // for "unmatched", real edges cost -weight
+    const int n = std::max(rows, cols);
+    const double kInf = std::numeric_limits<double>::infinity();
+
+    std::pmr::vector<double> cost(static_cast<std::size_t>(n) * n, 0.0, memory);
+    for (const AssignmentEdge& edge : edges) {
+        double& cell = cost[static_cast<std::size_t>(edge.row) * n + edge.col];
+        cell = std::min(cell, -edge.weight);
+    }
+
+    // Shortest augmenting paths with row/column potentials (1-based, index 0
+    // is the virtual start column)
+    std::pmr::vector<double> u(n + 1, 0.0, memory), v(n + 1, 0.0, memory), min_slack(n + 1, 0.0, memory);
+    std::pmr::vector<int> row_of_col(n + 1, 0, memory), way(n + 1, 0, memory);
+    std::pmr::vector<char> used(n + 1, 0, memory);
+
+    for (int i = 1; i <= n; i++) {
+        row_of_col[0] = i;
+        int col0 = 0;
+        std::fill(min_slack.begin(), min_slack.end(), kInf);
+        std::fill(used.begin(), used.end(), 0);
+
+        do {
+            used[col0] = 1;
+            int row0 = row_of_col[col0];
+            double delta = kInf;
+            int col1 = 0;
+
+            const double* cost_row = &cost[static_cast<std::size_t>(row0 - 1) * n];
+            for (int j = 1; j <= n; j++) {
+                if (used[j]) {
+                    continue;
+                }
+                double reduced = cost_row[j - 1] - u[row0] - v[j];
+                if (reduced < min_slack[j]) {
+                    min_slack[j] = reduced;
+                    way[j] = col0;
+                }
+                if (min_slack[j] < delta) {
+                    delta = min_slack[j];
+                    col1 = j;
+                }
+            }
+
+            for (int j = 0; j <= n; j++) {
+                if (used[j]) {
+                    u[row_of_col[j]] += delta;
+                    v[j] -= delta;
+                } else {
+                    min_slack[j] -= delta;
+                }
+            }
+            col0 = col1;
+        } while (row_of_col[col0] != 0);
+
+        do {
+            int col1 = way[col0];
+            row_of_col[col0] = row_of_col[col1];
+            col0 = col1;
+        } while (col0 != 0);
+    }
+
+    std::vector<std::pair<int, int>> matches;
+    for (int j = 1; j <= n; j++) {
+        int row = row_of_col[j] - 1;
+        int col = j - 1;
+        if (row < rows && col < cols && cost[static_cast<std::size_t>(row) * n + col] < 0.0) {
+            matches.push_back({row, col});
+        }
+    }
+
+    std::sort(matches.begin(), matches.end());
+    return matches;
+}
+
+std::vector<std::pair<int, int>> AssignmentSolver::auction(int rows, int cols, Span<AssignmentEdge> edges,
+                                                           const AssignmentBudget& budget,
+                                                           std::pmr::memory_resource* memory) {
+    struct Candidate {
+        int col;
+        double weight;
+    };
+
+    // Per-row candidate lists, pruned to the strongest few
+    std::pmr::vector<std::pmr::vector<Candidate>> candidates(rows, memory);
+    double max_weight = 0.0;
+    for (const AssignmentEdge& edge : edges) {
+        candidates[edge.row].push_back({edge.col, edge.weight});
+        max_weight = std::max(max_weight, edge.weight);
+    }
+    for (auto& list : candidates) {
+        if (budget.candidates_per_row > 0 &&
+            list.size() > static_cast<std::size_t>(budget.candidates_per_row)) {
+            std::partial_sort(list.begin(), list.begin() + budget.candidates_per_row, list.end(),
+                              [](const Candidate& a, const Candidate& b) {
+                                  return a.weight > b.weight;
+                              });
+            list.resize(budget.candidates_per_row);
+        }
+    }
+
+    // Forward auction where staying unmatched is always an option worth 0.
+    // Prices start at 0 and objects never lose their owner, so unowned
+    // objects keep price 0 and the result is within rows * epsilon of the
+    // optimum.
+    const double epsilon = max_weight / (4.0 * (rows + 1));
+
+    std::pmr::vector<double> price(cols, 0.0, memory);
+    std::pmr::vector<int> owner(cols, -1, memory);
+    std::pmr::vector<int> assigned(rows, -1, memory);
+    std::size_t bids = 0;
+
+    std::pmr::deque<int> queue(memory);
+    for (int i = 0; i < rows; i++) {
+        if (!candidates[i].empty()) {
+            queue.push_back(i);
+        }
+    }
+
+    while (!queue.empty() && bids < budget.max_auction_bids) {
+        int row = queue.front();
+        queue.pop_front();
+
+        int best_col = -1;
+        double best_value = 0.0;
+        double second_value = 0.0;
+        for (const Candidate& candidate : candidates[row]) {
+            double value = candidate.weight - price[candidate.col];
+            if (value > best_value) {
+                second_value = best_value;
+                best_value = value;
+                best_col = candidate.col;
+            } else if (value > second_value) {
+                second_value = value;
+            }
+        }
+
+        if (best_col < 0) {
+            continue;  // nothing is worth more than staying unmatched
+        }
+
+        bids++;
+        price[best_col] += best_value - second_value + epsilon;
+        if (owner[best_col] >= 0) {
+            assigned[owner[best_col]] = -1;
+            queue.push_back(owner[best_col]);
+        }
+        owner[best_col] = row;
+        assigned[row] = best_col;
+    }
+
+    std::vector<std::pair<int, int>> matches;
+    for (int i = 0; i < rows; i++) {
+        if (assigned[i] >= 0) {
+            matches.push_back({i, assigned[i]});
+        }
+    }
+    return matches;
+}
+
+std::vector<std::pair<int, int>> AssignmentSolver::greedy(int rows, int cols, Span<AssignmentEdge> edges,
+                                                          std::pmr::memory_resource* memory) {
+    std::pmr::vector<std::pmr::vector<AssignmentEdge>> by_row(rows, memory);
+    for (const AssignmentEdge& edge : edges) {
+        by_row[edge.row].push_back(edge);
+    }
+
+    std::vector<std::pair<int, int>> matches;
+    std::pmr::vector<char> used(cols, 0, memory);
+
+    for (int i = 0; i < rows; i++) {
+        std::sort(by_row[i].begin(), by_row[i].end(),
+                  [](const AssignmentEdge& a, const AssignmentEdge& b) { return a.col < b.col; });
+
+        int best_col = -1;
+        double best_weight = 0.0;
+        for (const AssignmentEdge& edge : by_row[i]) {
+            if (!used[edge.col] && edge.weight > best_weight) {
+                best_weight = edge.weight;
+                best_col = edge.col;
+            }
+        }
+
+        if (best_col != -1) {
+            matches.push_back({i, best_col});
+            used[best_col] = 1;
+        }
+    }
+
+    return matches;
+}
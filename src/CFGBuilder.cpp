@@ -1,97 +1,545 @@
 #include "CFGBuilder.h"
-#include <set>
+#include "SemanticHasher.h"
+#include "Utils/Metrics.h"
+#include <algorithm>
+#include <limits>
+#include <utility>
 
-CFGBuilder::CFG CFGBuilder::build(const std::vector<Token>& tokens) {
-    CFG cfg;
-    int current_block_id = 0;
-    BasicBlock current_block;
-    current_block.id = current_block_id;
-    
-    for (size_t i = 0; i < tokens.size(); i++) {
+namespace {
+inline bool isSymbol(const Token& token, SymbolId id) {
+    return token.kind == TokenKind::Symbol && token.symbol == id;
+}
+
+inline bool isKeyword(const Token& token, SymbolId id) {
+    return token.kind == TokenKind::Keyword && token.symbol == id;
+}
+
+// Statements nested deeper than this are kept as straight-line tokens
+const int kMaxNesting = 256;
+
+// Index of the brace closing the one at `open`, or the last token
+std::uint32_t closingBrace(TokenSpan tokens, std::uint32_t open) {
+    int depth = 0;
+    for (std::uint32_t i = open; i < tokens.size(); i++) {
+        if (isSymbol(tokens[i], Sym::LBrace)) depth++;
+        if (isSymbol(tokens[i], Sym::RBrace) && --depth == 0) return i;
+    }
+    return static_cast<std::uint32_t>(tokens.size()) - 1;
+}
+
+// Token ranges [begin, end) of function definitions. A declaration whose
+// brace follows a parameter list is a function body; one with '=' before
+// the brace is an initializer or lambda, one led by a control keyword is a
+// statement, and any other brace (class, struct, namespace, enum) is a
+// scope that is searched for functions in turn.
+std::vector<std::pair<std::uint32_t, std::uint32_t>> functionRanges(TokenSpan tokens) {
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> ranges;
+    const std::uint32_t count = static_cast<std::uint32_t>(tokens.size());
+
+    std::uint32_t start = 0;  // first token of the current declaration
+    int parens = 0;
+    bool parameters = false, assignment = false, statement = false;
+    auto reset = [&](std::uint32_t next) {
+        start = next;
+        parens = 0;
+        parameters = assignment = statement = false;
+    };
+
+    for (std::uint32_t i = 0; i < count; i++) {
         const Token& token = tokens[i];
-        
-        // Control flow keywords that end current block
-        if (token.type == "keyword" && 
-            (token.value == "if" || token.value == "else" || 
-             token.value == "while" || token.value == "for")) {
-            
-            // Close current block if it has tokens
-            if (!current_block.tokens.empty()) {
-                cfg.blocks.push_back(current_block);
-                cfg.block_map[current_block.id] = current_block;
+        if (token.kind == TokenKind::Keyword && parens == 0) {
+            switch (token.symbol) {
+                case Sym::If:
+                case Sym::Else:
+                case Sym::While:
+                case Sym::For:
+                case Sym::Do:
+                case Sym::Switch:
+                case Sym::Return: statement = true; break;
+                default: break;
             }
-            
-            // Start new block with control keyword
-            current_block_id++;
-            current_block = BasicBlock();
-            current_block.id = current_block_id;
-            current_block.tokens.push_back(token);
-            
-        } else if (token.value == "{" || token.value == "}") {
-            // Block delimiters - close current block
-            current_block.tokens.push_back(token);
-            
-            if (!current_block.tokens.empty()) {
-                cfg.blocks.push_back(current_block);
-                cfg.block_map[current_block.id] = current_block;
+            continue;
+        }
+        if (token.kind != TokenKind::Symbol) {
+            continue;
+        }
+
+        switch (token.symbol) {
+            case Sym::LParen: parens++; break;
+            case Sym::RParen:
+                parens = std::max(0, parens - 1);
+                parameters |= parens == 0;
+                break;
+            case Sym::Assign: assignment |= parens == 0; break;
+            case Sym::Semi:
+                if (parens == 0) reset(i + 1);
+                break;
+            case Sym::Colon:
+                // "public:" and "private:" labels are not part of what follows
+                if (parens == 0 && i == start + 1 && tokens[start].kind == TokenKind::Keyword &&
+                    (tokens[start].symbol == Sym::Public || tokens[start].symbol == Sym::Private)) {
+                    reset(i + 1);
+                }
+                break;
+            case Sym::RBrace: reset(i + 1); break;  // end of an enclosing scope
+            case Sym::Hash: {
+                // #include "file" or <file> ends where its file name does
+                std::uint32_t name = i + 2;
+                if (parens > 0 || name >= count || tokens[i + 1].kind != TokenKind::Identifier) break;
+                if (tokens[name].kind == TokenKind::Literal) {
+                    i = name;
+                    reset(i + 1);
+                } else if (isSymbol(tokens[name], Sym::Less)) {
+                    std::uint32_t close = name + 1;
+                    while (close < count && close < name + 32 && !isSymbol(tokens[close], Sym::Greater)) close++;
+                    if (close < count && isSymbol(tokens[close], Sym::Greater)) {
+                        i = close;
+                        reset(i + 1);
+                    }
+                }
+                break;
             }
-            
-            current_block_id++;
-            current_block = BasicBlock();
-            current_block.id = current_block_id;
-            
-        } else if (token.value == ";") {
-            // Statement end - add to current block and potentially close
-            current_block.tokens.push_back(token);
-            
-        } else {
-            // Regular token - add to current block
-            current_block.tokens.push_back(token);
+            case Sym::LBrace: {
+                if (parens > 0) break;
+                if (assignment) {
+                    i = closingBrace(tokens, i);  // the declaration goes on to its ';'
+                } else if (statement) {
+                    i = closingBrace(tokens, i);
+                    reset(i + 1);
+                } else if (parameters) {
+                    std::uint32_t end = closingBrace(tokens, i) + 1;
+                    ranges.emplace_back(start, end);
+                    i = end - 1;
+                    reset(end);
+                } else {
+                    reset(i + 1);  // enter the scope
+                }
+                break;
+            }
+            default: break;
         }
     }
-    
-    // Add final block if it has tokens
-    if (!current_block.tokens.empty()) {
-        cfg.blocks.push_back(current_block);
-        cfg.block_map[current_block.id] = current_block;
-    }
-    
-    // Build successor relationships
-    buildSuccessors(cfg);
-    
-    return cfg;
+    return ranges;
 }
+}  // namespace
 
-void CFGBuilder::buildSuccessors(CFG& cfg) {
-    for (size_t i = 0; i < cfg.blocks.size(); i++) {
-        BasicBlock& block = cfg.blocks[i];
-        
-        // Check if this block contains control flow
-        bool has_control_flow = false;
-        for (const Token& token : block.tokens) {
-            if (token.type == "keyword" && 
-                (token.value == "if" || token.value == "while" || token.value == "for")) {
-                has_control_flow = true;
-                break;
+// Statement-level parser over the token stream that emits blocks and edges
+// as it goes. Blocks are opened lazily by the first token that needs one,
+// so every token lands in exactly one block and blocks stay in token
+// order. `pending` holds the blocks that fall through into whichever block
+// opens next; a construct's exits (false branch, breaks, then-branch ends)
+// are added to it at its join point. Loops and switches sit on a stack of
+// jump targets for break and continue.
+class CFGBuilder::Parser {
+   public:
+    explicit Parser(CFG& graph) : cfg(graph), tokens(graph.tokens) {}
+
+    void run() {
+        while (pos < tokens.size()) {
+            if (isSymbol(tokens[pos], Sym::RBrace)) {
+                append();  // unbalanced closing brace
+                continue;
             }
+            statement(0);
+        }
+        finish();
+    }
+
+   private:
+    struct Target {
+        bool loop;
+        int head;                    // loop head for continue; the switch block for cases
+        std::vector<int> breaks;     // blocks jumping past the construct
+        std::vector<int> continues;  // do-while: blocks jumping to the condition
+        bool has_default = false;
+    };
+
+    CFG& cfg;
+    const std::vector<Token>& tokens;
+    std::size_t pos = 0;
+    int open = -1;  // block receiving tokens
+    std::vector<int> pending;
+    std::vector<std::pair<int, int>> edges;
+    std::vector<Target> targets;
+
+    void append() {
+        // A closing brace after a jump or a construct adds nothing to run;
+        // it stays with the block before it
+        if (open < 0 && !cfg.blocks.empty() && isSymbol(tokens[pos], Sym::RBrace)) {
+            pos++;
+            return;
         }
-        
-        if (has_control_flow) {
-            // Control flow block - can branch to multiple successors
-            if (i + 1 < cfg.blocks.size()) {
-                block.successors.push_back(cfg.blocks[i + 1].id);
+        if (open < 0) {
+            open = static_cast<int>(cfg.blocks.size());
+            BasicBlock block;
+            block.id = open;
+            block.first_token = static_cast<std::uint32_t>(pos);
+            cfg.blocks.push_back(block);
+            for (int from : pending) {
+                edges.emplace_back(from, open);
             }
-            if (i + 2 < cfg.blocks.size()) {
-                block.successors.push_back(cfg.blocks[i + 2].id);
+            pending.clear();
+        }
+        pos++;
+    }
+
+    // The next token starts a new block, reached from the current one
+    void leader() {
+        if (open >= 0) {
+            pending.push_back(open);
+            open = -1;
+        }
+    }
+
+    // End the current block without falling through; returns it
+    int jump() {
+        int block = open;
+        open = -1;
+        return block;
+    }
+
+    // Blocks falling through to the next token
+    std::vector<int> flow() {
+        leader();
+        std::vector<int> exits;
+        exits.swap(pending);
+        return exits;
+    }
+
+    bool at(SymbolId symbol) const { return pos < tokens.size() && isSymbol(tokens[pos], symbol); }
+    bool atKeyword(SymbolId keyword) const { return pos < tokens.size() && isKeyword(tokens[pos], keyword); }
+
+    void statement(int depth) {
+        if (pos >= tokens.size() || at(Sym::RBrace)) {
+            return;
+        }
+        if (depth > kMaxNesting) {
+            at(Sym::LBrace) ? appendBraces() : simple(true);
+            return;
+        }
+
+        const Token& token = tokens[pos];
+        if (token.kind == TokenKind::Keyword) {
+            switch (token.symbol) {
+                case Sym::If: ifStatement(depth); return;
+                case Sym::While:
+                case Sym::For: loopStatement(depth); return;
+                case Sym::Do: doStatement(depth); return;
+                case Sym::Switch: switchStatement(depth); return;
+                case Sym::Return:
+                    simple(true);
+                    jump();
+                    return;
+                case Sym::Break:
+                case Sym::Continue: jumpStatement(token.symbol == Sym::Continue); return;
+                case Sym::Case:
+                case Sym::Default:
+                    if (label()) return;
+                    break;
+                default: break;
+            }
+        }
+
+        if (at(Sym::LBrace)) {
+            append();
+            while (pos < tokens.size() && !at(Sym::RBrace)) {
+                statement(depth + 1);
+            }
+            if (pos < tokens.size()) append();
+            return;
+        }
+        simple(false);
+    }
+
+    // Expression statement or declaration, through its semicolon. Stops
+    // before a brace that opens a body (function, class, namespace); braces
+    // after '=' (initializers, lambdas) or inside parentheses are values.
+    void simple(bool braces_are_values) {
+        int depth = 0;
+        bool started = false;
+        while (pos < tokens.size()) {
+            const Token& token = tokens[pos];
+            if (token.kind == TokenKind::Symbol) {
+                if (token.symbol == Sym::LParen || token.symbol == Sym::LBracket) {
+                    depth++;
+                } else if (token.symbol == Sym::RParen || token.symbol == Sym::RBracket) {
+                    depth = std::max(0, depth - 1);
+                } else if (depth == 0) {
+                    if (token.symbol == Sym::Semi) {
+                        append();
+                        return;
+                    }
+                    if (token.symbol == Sym::RBrace && started) return;
+                    if (token.symbol == Sym::LBrace) {
+                        if (!braces_are_values) return;
+                        appendBraces();
+                        continue;
+                    }
+                    if (token.symbol == Sym::Assign) braces_are_values = true;
+                }
+            }
+            append();
+            started = true;
+        }
+    }
+
+    void appendBraces() {
+        int depth = 0;
+        do {
+            if (at(Sym::LBrace)) depth++;
+            if (at(Sym::RBrace)) depth--;
+            append();
+        } while (pos < tokens.size() && depth > 0);
+    }
+
+    // Keyword, anything up to '(', then the balanced parentheses
+    void condition() {
+        append();
+        while (pos < tokens.size() && !at(Sym::LParen) && !at(Sym::LBrace) && !at(Sym::Semi)) {
+            append();
+        }
+        if (!at(Sym::LParen)) {
+            return;
+        }
+        int depth = 0;
+        while (pos < tokens.size()) {
+            if (at(Sym::LParen)) depth++;
+            if (at(Sym::RParen)) depth--;
+            append();
+            if (depth == 0) break;
+        }
+    }
+
+    void ifStatement(int depth) {
+        condition();
+        int branch = jump();
+        pending.push_back(branch);
+        statement(depth + 1);
+
+        if (atKeyword(Sym::Else)) {
+            std::vector<int> then_exits = flow();
+            pending.push_back(branch);
+            append();
+            statement(depth + 1);
+            leader();
+            pending.insert(pending.end(), then_exits.begin(), then_exits.end());
+        } else {
+            leader();
+            pending.push_back(branch);
+        }
+    }
+
+    // while and for: the head holds the condition (and for's init and step)
+    void loopStatement(int depth) {
+        leader();
+        condition();
+        int head = jump();
+        targets.push_back({true, head, {}, {}});
+        pending.push_back(head);
+        statement(depth + 1);
+
+        for (int exit : flow()) {
+            edges.emplace_back(exit, head);
+        }
+        Target loop = std::move(targets.back());
+        targets.pop_back();
+        pending.push_back(head);
+        pending.insert(pending.end(), loop.breaks.begin(), loop.breaks.end());
+    }
+
+    void doStatement(int depth) {
+        leader();
+        append();
+        int body = open;
+        targets.push_back({true, -1, {}, {}});
+        statement(depth + 1);
+
+        std::vector<int> exits = flow();
+        Target loop = std::move(targets.back());
+        targets.pop_back();
+        pending = exits;
+        pending.insert(pending.end(), loop.continues.begin(), loop.continues.end());
+
+        if (atKeyword(Sym::While)) {
+            condition();
+            if (at(Sym::Semi)) append();
+            int test = jump();
+            edges.emplace_back(test, body);
+            pending.push_back(test);
+        }
+        pending.insert(pending.end(), loop.breaks.begin(), loop.breaks.end());
+    }
+
+    void switchStatement(int depth) {
+        condition();
+        bool braces = at(Sym::LBrace);
+        if (braces) append();
+        int head = jump();  // code before the first label is unreachable
+        targets.push_back({false, head, {}, {}});
+        if (braces) {
+            while (pos < tokens.size() && !at(Sym::RBrace)) {
+                statement(depth + 1);
             }
+            if (pos < tokens.size()) append();
+        } else {
+            statement(depth + 1);
+        }
+
+        std::vector<int> exits = flow();
+        Target selection = std::move(targets.back());
+        targets.pop_back();
+        pending = exits;
+        pending.insert(pending.end(), selection.breaks.begin(), selection.breaks.end());
+        if (!selection.has_default) {
+            pending.push_back(head);
+        }
+    }
+
+    // case/default label of the innermost switch; false if the keyword is
+    // not a label here (e.g. "= default;")
+    bool label() {
+        bool is_default = atKeyword(Sym::Default);
+        if (is_default && !(pos + 1 < tokens.size() && isSymbol(tokens[pos + 1], Sym::Colon))) {
+            return false;
+        }
+        auto selection = std::find_if(targets.rbegin(), targets.rend(), [](const Target& t) { return !t.loop; });
+        if (selection == targets.rend()) {
+            return false;
+        }
+
+        leader();
+        pending.push_back(selection->head);
+        selection->has_default |= is_default;
+        append();
+        while (pos < tokens.size() && !at(Sym::Colon) && !at(Sym::Semi) && !at(Sym::LBrace) &&
+               !at(Sym::RBrace)) {
+            append();
+        }
+        if (at(Sym::Colon)) append();
+        return true;
+    }
+
+    void jumpStatement(bool is_continue) {
+        append();
+        if (at(Sym::Semi)) append();
+        int from = jump();
+
+        if (!is_continue) {
+            if (!targets.empty()) targets.back().breaks.push_back(from);
+            return;
+        }
+        auto loop = std::find_if(targets.rbegin(), targets.rend(), [](const Target& t) { return t.loop; });
+        if (loop == targets.rend()) {
+            return;
+        }
+        if (loop->head >= 0) {
+            edges.emplace_back(from, loop->head);
         } else {
-            // Sequential block - goes to next block
-            if (i + 1 < cfg.blocks.size()) {
-                block.successors.push_back(cfg.blocks[i + 1].id);
+            loop->continues.push_back(from);
+        }
+    }
+
+    // Token ranges, features and the CSR edge array
+    void finish() {
+        const std::size_t count = cfg.blocks.size();
+        for (std::size_t i = 0; i < count; i++) {
+            std::uint32_t end = i + 1 < count ? cfg.blocks[i + 1].first_token
+                                              : static_cast<std::uint32_t>(tokens.size());
+            cfg.blocks[i].token_count = end - cfg.blocks[i].first_token;
+            computeFeatures(cfg.blocks[i], cfg.tokensOf(cfg.blocks[i]));
+        }
+
+        std::stable_sort(edges.begin(), edges.end(),
+                         [](const std::pair<int, int>& a, const std::pair<int, int>& b) { return a.first < b.first; });
+        cfg.edges.reserve(edges.size());
+        std::size_t e = 0;
+        for (std::size_t i = 0; i < count; i++) {
+            BasicBlock& block = cfg.blocks[i];
+            block.first_edge = static_cast<std::uint32_t>(cfg.edges.size());
+            for (; e < edges.size() && edges[e].first == static_cast<int>(i); e++) {
+                int to = edges[e].second;
+                auto existing = cfg.edges.begin() + block.first_edge;
+                if (std::find(existing, cfg.edges.end(), to) == cfg.edges.end()) {
+                    cfg.edges.push_back(to);
+                }
+            }
+            block.edge_count = static_cast<std::uint32_t>(cfg.edges.size()) - block.first_edge;
+        }
+    }
+};
+
+CFGBuilder::CFG CFGBuilder::build(const std::vector<Token>& tokens) {
+    return build(std::vector<Token>(tokens));
+}
+
+CFGBuilder::CFG CFGBuilder::build(std::vector<Token>&& tokens, std::vector<SourceSpan>&& spans) {
+    CFG cfg = build(std::move(tokens));
+    if (spans.size() == cfg.tokens.size()) {
+        cfg.spans = std::move(spans);
+    }
+    return cfg;
+}
+
+std::vector<CFGBuilder::FunctionCFG> CFGBuilder::buildFunctions(TokenSpan tokens) {
+    METRIC_TIME(BuildFunctions);
+    std::vector<FunctionCFG> functions;
+    auto ranges = functionRanges(tokens);
+    if (ranges.empty() && !tokens.empty()) {
+        ranges.emplace_back(0, static_cast<std::uint32_t>(tokens.size()));
+    }
+
+    functions.reserve(ranges.size());
+    for (const auto& range : ranges) {
+        FunctionCFG function;
+        function.first_token = range.first;
+        function.token_count = range.second - range.first;
+        function.cfg = build(tokens.subspan(range.first, function.token_count).toVector());
+        functions.push_back(std::move(function));
+    }
+    METRIC_COUNT(Functions, functions.size());
+    return functions;
+}
+
+CFGBuilder::CFG CFGBuilder::build(std::vector<Token>&& tokens) {
+    METRIC_TIME(BuildCFG);
+    CFG cfg;
+    cfg.tokens = std::move(tokens);
+    Parser(cfg).run();
+    METRIC_COUNT(Blocks, cfg.blocks.size());
+    METRIC_COUNT(Edges, cfg.edges.size());
+    return cfg;
+}
+
+void CFGBuilder::computeFeatures(BasicBlock& block, TokenSpan tokens) {
+    BlockFeatures features;
+    const std::uint16_t kMaxCount = std::numeric_limits<std::uint16_t>::max();
+
+    for (const Token& token : tokens) {
+        int bin = token.kind == TokenKind::Identifier ? kVarBin : static_cast<int>(token.symbol);
+        if (bin >= kHistogramBins) {
+            bin = Sym::Unknown;
+        }
+        if (features.histogram[bin] < kMaxCount) {
+            features.histogram[bin]++;
+            features.token_count++;
+        }
+
+        if (token.kind == TokenKind::Keyword) {
+            switch (token.symbol) {
+                case Sym::If: features.control_flow |= CF_IF; break;
+                case Sym::Else: features.control_flow |= CF_ELSE; break;
+                case Sym::While: features.control_flow |= CF_WHILE; break;
+                case Sym::For: features.control_flow |= CF_FOR; break;
+                case Sym::Return: features.control_flow |= CF_RETURN; break;
+                case Sym::Switch: features.control_flow |= CF_SWITCH; break;
+                case Sym::Do: features.control_flow |= CF_DO; break;
+                case Sym::Break:
+                case Sym::Continue: features.control_flow |= CF_JUMP; break;
+                default: break;
             }
         }
-        
-        // Update in block_map
-        cfg.block_map[block.id] = block;
     }
+
+    block.features = features;
+    SemanticHasher::signBlock(block, tokens);
 }
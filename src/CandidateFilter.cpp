@@ -0,0 +1,200 @@
+#include "CandidateFilter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace {
+const std::uint32_t kEmptySlot = 0xFFFFFFFFu;
+const std::uint64_t kSeed = 0xcbf29ce484222325ULL;
+const std::uint64_t kBlockSalt = 0x5bd1e9955bd1e995ULL;  // keeps signatures apart from k-grams
+
+inline std::uint64_t mix(std::uint64_t hash, std::uint64_t code) {
+    hash ^= code + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    return hash * 0x100000001b3ULL;
+}
+
+inline std::uint64_t finish(std::uint64_t hash) {
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+inline std::uint64_t tokenCode(const Token& token) {
+    return (static_cast<std::uint64_t>(token.kind) << 32) | token.symbol;
+}
+}  // namespace
+
+CandidateFilter::CandidateFilter(const CandidateOptions& opts) : options(opts) {
+    options.num_hashes = std::max(1, options.num_hashes);
+    options.shingle = std::max(1, options.shingle);
+
+    const int k = options.num_hashes;
+    if (options.bands > 0) {
+        band_count = std::min(options.bands, k);
+        rows_per_band = k / band_count;
+        return;
+    }
+
+    // The widest bands that still keep a pair at the threshold with the
+    // requested probability: wider bands mean fewer chance collisions
+    band_count = k;
+    rows_per_band = 1;
+    for (int r = k; r >= 1; r--) {
+        band_count = k / r;
+        rows_per_band = r;
+        if (keepProbability(options.threshold) >= options.recall) {
+            break;
+        }
+    }
+}
+
+double CandidateFilter::keepProbability(double s) const {
+    return 1.0 - std::pow(1.0 - std::pow(s, rows_per_band), band_count);
+}
+
+CandidateFilter::Sketch CandidateFilter::sketch(const CFGBuilder::CFG& cfg) const {
+    const std::uint32_t k = static_cast<std::uint32_t>(options.num_hashes);
+    Sketch slots(k, kEmptySlot);
+
+    // One-permutation MinHash: the top bits of a feature hash pick the slot,
+    // the low bits compete for its minimum. Linear in the number of features
+    // instead of one pass per hash function.
+    auto add = [&](std::uint64_t feature) {
+        std::uint64_t hash = finish(feature);
+        std::uint32_t slot = static_cast<std::uint32_t>(((hash >> 32) * k) >> 32);
+        std::uint32_t value = static_cast<std::uint32_t>(hash);
+        slots[slot] = std::min(slots[slot], value);
+    };
+
+    // Token k-grams across the whole file, so that the sketch does not
+    // depend on where block boundaries fall
+    const std::size_t shingle = static_cast<std::size_t>(options.shingle);
+    std::vector<std::uint64_t> window;
+    window.reserve(shingle);
+    std::size_t seen = 0;
+    for (const BasicBlock& block : cfg.blocks) {
+        for (const Token& token : cfg.tokensOf(block)) {
+            if (window.size() < shingle) {
+                window.push_back(tokenCode(token));
+            } else {
+                window[seen % shingle] = tokenCode(token);
+            }
+            seen++;
+
+            if (seen >= shingle) {
+                std::uint64_t hash = kSeed;
+                for (std::size_t i = 0; i < shingle; i++) {
+                    hash = mix(hash, window[(seen + i) % shingle]);
+                }
+                add(hash);
+            }
+        }
+
+        if (block.features.semantic_signature != 0) {
+            add(block.features.semantic_signature ^ kBlockSalt);
+        }
+    }
+    if (seen > 0 && seen < shingle) {
+        std::uint64_t hash = kSeed;
+        for (std::uint64_t code : window) {
+            hash = mix(hash, code);
+        }
+        add(hash);
+    }
+
+    // Fill empty slots from the next filled one (rotation densification) so
+    // that small files still compare slot by slot
+    Sketch original = slots;
+    for (std::uint32_t i = 0; i < k; i++) {
+        if (original[i] != kEmptySlot) {
+            continue;
+        }
+        for (std::uint32_t distance = 1; distance < k; distance++) {
+            std::uint32_t value = original[(i + distance) % k];
+            if (value != kEmptySlot) {
+                slots[i] = static_cast<std::uint32_t>(finish(mix(value, distance)));
+                break;
+            }
+        }
+    }
+
+    return slots;
+}
+
+double CandidateFilter::estimate(const Sketch& a, const Sketch& b) {
+    std::size_t size = std::min(a.size(), b.size());
+    if (size == 0) {
+        return a.size() == b.size() ? 1.0 : 0.0;
+    }
+
+    std::size_t equal = 0;
+    for (std::size_t i = 0; i < size; i++) {
+        equal += a[i] == b[i];
+    }
+    return static_cast<double>(equal) / static_cast<double>(size);
+}
+
+std::vector<std::pair<int, int>> CandidateFilter::candidates(const std::vector<Sketch>& sketches) const {
+    const int n = static_cast<int>(sketches.size());
+    auto first = [](std::uint64_t key) { return static_cast<int>(key >> 32); };
+    auto second = [](std::uint64_t key) { return static_cast<int>(key & 0xFFFFFFFFu); };
+    auto rejected = [&](std::uint64_t key) {
+        return estimate(sketches[first(key)], sketches[second(key)]) < options.threshold;
+    };
+
+    // Accepted pairs so far, sorted. Only one band's pairs are held
+    // besides them, so memory does not grow with the number of bands.
+    std::vector<std::uint64_t> accepted, band_keys, fresh, merged;
+
+    // Per band, files whose rows hash alike land next to each other after
+    // sorting; every group yields its pairs
+    std::vector<std::pair<std::uint64_t, int>> buckets(n);
+    for (int band = 0; band < band_count; band++) {
+        const int first_row = band * rows_per_band;
+        for (int i = 0; i < n; i++) {
+            std::uint64_t hash = mix(kSeed, static_cast<std::uint64_t>(band));
+            for (int r = 0; r < rows_per_band; r++) {
+                hash = mix(hash, sketches[i][first_row + r]);
+            }
+            buckets[i] = {hash, i};
+        }
+        std::sort(buckets.begin(), buckets.end());
+
+        band_keys.clear();
+        for (int start = 0, end = 0; start < n; start = end) {
+            end = start + 1;
+            while (end < n && buckets[end].first == buckets[start].first) {
+                end++;
+            }
+            for (int a = start; a < end; a++) {
+                for (int b = a + 1; b < end; b++) {
+                    // Buckets are sorted by file within equal hashes
+                    band_keys.push_back((static_cast<std::uint64_t>(buckets[a].second) << 32) |
+                                        static_cast<std::uint32_t>(buckets[b].second));
+                }
+            }
+        }
+
+        // A file sits in one bucket per band, so the band holds each pair
+        // once; pairs an earlier band accepted are not checked again
+        std::sort(band_keys.begin(), band_keys.end());
+        fresh.clear();
+        std::set_difference(band_keys.begin(), band_keys.end(), accepted.begin(), accepted.end(),
+                            std::back_inserter(fresh));
+        fresh.erase(std::remove_if(fresh.begin(), fresh.end(), rejected), fresh.end());
+        merged.clear();
+        std::merge(accepted.begin(), accepted.end(), fresh.begin(), fresh.end(), std::back_inserter(merged));
+        accepted.swap(merged);
+    }
+
+    std::vector<std::pair<int, int>> result;
+    result.reserve(accepted.size());
+    for (std::uint64_t key : accepted) {
+        result.emplace_back(first(key), second(key));
+    }
+    return result;
+}
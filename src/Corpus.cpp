@@ -0,0 +1,297 @@
+#include "Corpus.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory_resource>
+#include <mutex>
+#include <unordered_set>
+
+#include "Fingerprinter.h"
+#include "Normalizer.h"
+#include "PersistentIndex.h"
+#include "Utils/Arena.h"
+#include "Utils/SourceFile.h"
+#include "Utils/StringUtils.h"
+#include "Utils/ThreadPool.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+// Pairs handed to one task; small enough to balance, large enough to
+// amortize scheduling
+const std::size_t kPairGrain = 256;
+
+bool isSourceFile(const fs::path& path) {
+    static const std::unordered_set<std::string> extensions = {
+        ".cpp", ".cc", ".cxx", ".c", ".h", ".hpp", ".hh", ".hxx"};
+    return extensions.count(StringUtils::toLowerCase(path.extension().string())) > 0;
+}
+
+// Per-file and per-pair working state comes from an arena private to the
+// worker thread, so workers never meet in the system allocator for it and
+// the arena's memory is reused from one task to the next
+Arena& threadArena() {
+    static thread_local Arena arena;
+    return arena;
+}
+
+// Two filters keep exactly the same pairs
+bool sameFilter(const CandidateOptions& a, const CandidateOptions& b) {
+    CandidateFilter fa(a), fb(b);
+    return a.threshold == b.threshold && a.num_hashes == b.num_hashes && a.shingle == b.shingle &&
+           fa.bands() == fb.bands() && fa.rows() == fb.rows();
+}
+}  // namespace
+
+std::vector<std::string> Corpus::collectFiles(const std::string& source) {
+    std::vector<std::string> result;
+
+    std::error_code ec;
+    if (fs::is_directory(source, ec)) {
+        for (const auto& entry : fs::recursive_directory_iterator(
+                 source, fs::directory_options::skip_permission_denied, ec)) {
+            if (entry.is_regular_file(ec) && isSourceFile(entry.path())) {
+                result.push_back(entry.path().string());
+            }
+        }
+        // Directory iteration order is unspecified; keep runs reproducible
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    std::ifstream list(source);
+    if (!list.is_open()) {
+        std::cerr << "Error: Cannot open corpus '" << source << "'" << std::endl;
+        return result;
+    }
+
+    std::string line;
+    while (std::getline(list, line)) {
+        line = StringUtils::trim(line);
+        if (!line.empty() && line[0] != '#') {
+            result.push_back(line);
+        }
+    }
+    return result;
+}
+
+void Corpus::load(const std::vector<std::string>& paths, unsigned threads,
+                  const PersistentIndex* previous) {
+    std::vector<CorpusEntry> loaded(paths.size());
+    std::vector<char> ok(paths.size(), 0);
+
+    ThreadPool pool(threads);
+    pool.parallelFor(paths.size(), 1, [&](std::size_t begin, std::size_t end) {
+        Arena& arena = threadArena();
+        Normalizer normalizer;
+        normalizer.setArena(&arena);
+        CFGBuilder builder;
+
+        for (std::size_t i = begin; i < end; i++) {
+            arena.reset();
+            SourceFile source;
+            if (!source.open(paths[i]) || source.empty()) {
+                continue;
+            }
+
+            CorpusEntry& entry = loaded[i];
+            entry.path = paths[i];
+            entry.content_hash = StringUtils::contentHash(source.view());
+
+            int id = previous ? previous->find(paths[i]) : -1;
+            if (id >= 0 && previous->contentHash(id) == entry.content_hash) {
+                entry.cfg = previous->loadCFG(id);
+                entry.previous_id = id;
+            } else {
+                entry.cfg = builder.build(normalizer.process(source.view()));
+            }
+            ok[i] = 1;
+        }
+    });
+
+    files.clear();
+    last_stats = CorpusStats();
+    for (std::size_t i = 0; i < paths.size(); i++) {
+        if (ok[i]) {
+            if (loaded[i].previous_id >= 0) {
+                last_stats.files_reused++;
+            } else {
+                last_stats.files_analyzed++;
+            }
+            files.push_back(std::move(loaded[i]));
+        } else {
+            std::cerr << "Warning: Skipping empty or unreadable file '" << paths[i] << "'"
+                      << std::endl;
+        }
+    }
+}
+
+void Corpus::load(const PersistentIndex& index, unsigned threads) {
+    std::vector<CorpusEntry> loaded(index.size());
+
+    ThreadPool pool(threads);
+    pool.parallelFor(loaded.size(), 16, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) {
+            int id = static_cast<int>(i);
+            loaded[i].path = index.path(id);
+            loaded[i].content_hash = index.contentHash(id);
+            loaded[i].cfg = index.loadCFG(id);
+            loaded[i].previous_id = id;
+        }
+    });
+
+    files = std::move(loaded);
+    last_stats = CorpusStats();
+    last_stats.files_reused = files.size();
+}
+
+int Corpus::add(CorpusEntry entry) {
+    files.push_back(std::move(entry));
+    last_stats.files_analyzed++;
+    return static_cast<int>(files.size()) - 1;
+}
+
+std::vector<PairResult> Corpus::scoreAllPairs(unsigned threads, double min_score,
+                                              const PersistentIndex* previous) {
+    std::vector<PairResult> results;
+    std::mutex results_mutex;
+
+    const int n = static_cast<int>(files.size());
+    last_stats.pairs_scored = 0;
+    last_stats.pairs_reused = 0;
+    last_stats.pairs_pruned = 0;
+
+    // Stored pairs are complete down to the index threshold, so they can
+    // stand in for a rescore when we report no lower than that. A filtered
+    // index only knows about its own candidates.
+    bool reuse_pairs = previous && min_score >= previous->pairThreshold() &&
+                       std::fabs(previous->structuralWeight() - structural_weight) < 1e-12 &&
+                       std::fabs(previous->semanticWeight() - semantic_weight) < 1e-12 &&
+                       std::fabs(previous->fingerprintWeight() - fingerprint_weight) < 1e-12 &&
+                       (!previous->candidateOptions().enabled() ||
+                        sameFilter(previous->candidateOptions(), candidate_options));
+    std::atomic<std::size_t> pairs_scored{0};
+    std::atomic<std::size_t> pairs_reused{0};
+
+    // Each file's fingerprint hash set, hashed once rather than per pair
+    // and only when the fingerprint overlap counts towards the score
+    std::vector<std::pmr::vector<std::uint64_t>> fingerprints;
+
+    // Score the pairs produced by `next` into the shared results
+    auto scoreRange = [&](const std::function<bool(int&, int&)>& next) {
+        Scorer scorer;
+        scorer.setWeights(structural_weight, semantic_weight, fingerprint_weight);
+        scorer.setArena(&threadArena());
+
+        std::vector<PairResult> local;
+        std::size_t scored = 0, reused = 0;
+        int i, j;
+        while (next(i, j)) {
+            int previous_i = files[i].previous_id;
+            int previous_j = files[j].previous_id;
+
+            // Stored pairs do not depend on the order the files came in
+            Scorer::Score score;
+            if (reuse_pairs && previous_i >= 0 && previous_j >= 0 && previous_i != previous_j) {
+                reused++;
+                if (!previous->findPair(std::min(previous_i, previous_j), std::max(previous_i, previous_j), score)) {
+                    continue;  // scored below the stored threshold
+                }
+            } else {
+                scored++;
+                // Pairs below min_score are dropped anyway, so bounds may
+                // stop their scoring early
+                bool reached = fingerprints.empty()
+                                   ? scorer.calculateAbove(files[i].cfg, files[j].cfg, min_score, score)
+                                   : scorer.calculateAbove(files[i].cfg, files[j].cfg, fingerprints[i],
+                                                           fingerprints[j], min_score, score);
+                if (!reached) {
+                    continue;
+                }
+            }
+
+            if (score.overall >= min_score) {
+                local.push_back({i, j, score});
+            }
+        }
+        pairs_scored += scored;
+        pairs_reused += reused;
+
+        std::lock_guard<std::mutex> lock(results_mutex);
+        results.insert(results.end(), local.begin(), local.end());
+    };
+
+    ThreadPool pool(threads);
+    if (fingerprint_weight > 0.0) {
+        Fingerprinter fingerprinter;
+        fingerprints.resize(files.size());
+        pool.parallelFor(files.size(), 16, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; i++) {
+                fingerprints[i] = fingerprinter.hashSet(files[i].cfg.tokens);
+            }
+        });
+    }
+
+    if (candidate_options.enabled()) {
+        CandidateFilter filter(candidate_options);
+        std::vector<CandidateFilter::Sketch> sketches(files.size());
+        pool.parallelFor(files.size(), 16, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; i++) {
+                sketches[i] = filter.sketch(files[i].cfg);
+            }
+        });
+
+        std::vector<std::pair<int, int>> candidates = filter.candidates(sketches);
+        last_stats.pairs_pruned =
+            static_cast<std::size_t>(n) * (n - 1) / 2 - candidates.size();
+
+        pool.parallelFor(candidates.size(), kPairGrain, [&](std::size_t begin, std::size_t end) {
+            scoreRange([&, k = begin](int& i, int& j) mutable {
+                if (k == end) return false;
+                i = candidates[k].first;
+                j = candidates[k].second;
+                k++;
+                return true;
+            });
+        });
+    } else {
+        for (int i = 0; i < n; i++) {
+            for (int start = i + 1; start < n; start += static_cast<int>(kPairGrain)) {
+                int stop = std::min(n, start + static_cast<int>(kPairGrain));
+
+                pool.submit([&, i, start, stop] {
+                    scoreRange([i, k = start, stop](int& first, int& second) mutable {
+                        if (k == stop) return false;
+                        first = i;
+                        second = k++;
+                        return true;
+                    });
+                });
+            }
+        }
+        pool.wait();
+    }
+
+    last_stats.pairs_scored = pairs_scored;
+    last_stats.pairs_reused = pairs_reused;
+
+    std::sort(results.begin(), results.end(), [](const PairResult& a, const PairResult& b) {
+        if (a.score.overall != b.score.overall) {
+            return a.score.overall > b.score.overall;
+        }
+        return a.first != b.first ? a.first < b.first : a.second < b.second;
+    });
+
+    return results;
+}
+
+void Corpus::setWeights(double structural_w, double semantic_w, double fingerprint_w) {
+    structural_weight = structural_w;
+    semantic_weight = semantic_w;
+    fingerprint_weight = fingerprint_w;
+}
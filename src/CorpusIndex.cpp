@@ -0,0 +1,234 @@
+#include "CorpusIndex.h"
+
+#include <algorithm>
+#include <limits>
+#include <mutex>
+
+#include "Normalizer.h"
+#include "PersistentIndex.h"
+#include "Utils/Arena.h"
+#include "Utils/StringUtils.h"
+
+namespace {
+// Entries screened or scored by one task
+const std::size_t kScreenGrain = 1024;
+const std::size_t kScoreGrain = 4;
+
+Arena& threadArena() {
+    static thread_local Arena arena;
+    return arena;
+}
+
+// The `limit` best items seen so far. The worst kept item sits at the top
+// of a heap, so every rejected item costs one comparison.
+template <typename T, typename Better>
+class BoundedHeap {
+   public:
+    BoundedHeap(std::size_t limit, Better better) : limit(limit), better(better) {}
+
+    void push(const T& item) {
+        if (limit == 0) {
+            return;
+        }
+        if (items.size() < limit) {
+            items.push_back(item);
+            std::push_heap(items.begin(), items.end(), better);
+        } else if (better(item, items.front())) {
+            std::pop_heap(items.begin(), items.end(), better);
+            items.back() = item;
+            std::push_heap(items.begin(), items.end(), better);
+        }
+    }
+
+    // Kept items, best first
+    std::vector<T> take() {
+        std::sort_heap(items.begin(), items.end(), better);
+        return std::move(items);
+    }
+
+   private:
+    std::size_t limit;
+    Better better;
+    std::vector<T> items;
+};
+
+template <typename T, typename Better>
+BoundedHeap<T, Better> boundedHeap(std::size_t limit, Better better) {
+    return BoundedHeap<T, Better>(limit, better);
+}
+}  // namespace
+
+CorpusIndex::CorpusIndex(unsigned threads)
+    : pool(std::make_unique<ThreadPool>(threads)), thread_count(threads) {}
+
+bool CorpusIndex::open(const std::string& path) {
+    PersistentIndex index;
+    if (!index.open(path)) {
+        error_message = index.error();
+        return false;
+    }
+    corpus.load(index, thread_count);
+    structure.clear();
+    sketches.clear();
+    fingerprints.clear();
+    by_path.clear();
+    sign();
+    error_message.clear();
+    return true;
+}
+
+void CorpusIndex::build(const std::vector<std::string>& files) {
+    corpus.load(files, thread_count);
+    structure.clear();
+    sketches.clear();
+    fingerprints.clear();
+    by_path.clear();
+    sign();
+}
+
+int CorpusIndex::add(const std::string& path, std::string_view code) {
+    if (code.empty()) {
+        return -1;
+    }
+    Normalizer normalizer;
+    CFGBuilder builder;
+    CorpusEntry entry;
+    entry.path = path;
+    entry.content_hash = StringUtils::contentHash(code);
+    entry.cfg = builder.build(normalizer.process(code));
+    return add(std::move(entry));
+}
+
+int CorpusIndex::add(CorpusEntry entry) {
+    int id = corpus.add(std::move(entry));
+    sign();
+    return id;
+}
+
+bool CorpusIndex::save(const std::string& path) {
+    // Pairs are complete above a threshold nothing reaches
+    return PersistentIndex::write(path, corpus, {}, std::numeric_limits<double>::infinity(),
+                                  error_message);
+}
+
+void CorpusIndex::sign() {
+    const std::size_t first = structure.size();
+    const std::size_t count = corpus.entries().size();
+    structure.resize(count);
+    sketches.resize(count);
+    pool->parallelFor(count - first, 16, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = first + begin; i < first + end; i++) {
+            structure[i] = kernel.vectorize(corpus.entries()[i].cfg);
+            sketches[i] = filter.sketch(corpus.entries()[i].cfg);
+        }
+    });
+    for (std::size_t i = first; i < count; i++) {
+        by_path[corpus.entries()[i].path] = static_cast<int>(i);
+    }
+    hashFingerprints();
+}
+
+void CorpusIndex::hashFingerprints() {
+    if (corpus.fingerprintWeight() <= 0.0) {
+        fingerprints.clear();
+        return;
+    }
+    const std::size_t first = fingerprints.size();
+    const std::size_t count = corpus.entries().size();
+    fingerprints.resize(count);
+    pool->parallelFor(count - first, 16, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = first + begin; i < first + end; i++) {
+            fingerprints[i] = fingerprinter.hashSet(corpus.entries()[i].cfg.tokens);
+        }
+    });
+}
+
+int CorpusIndex::find(const std::string& path) const {
+    auto it = by_path.find(path);
+    return it == by_path.end() ? -1 : it->second;
+}
+
+std::vector<Neighbor> CorpusIndex::query(std::string_view code, const QueryOptions& options,
+                                         QueryStats* stats) const {
+    Normalizer normalizer;
+    CFGBuilder builder;
+    return query(builder.build(normalizer.process(code)), options, stats);
+}
+
+std::vector<Neighbor> CorpusIndex::query(const CFGBuilder::CFG& cfg, const QueryOptions& options,
+                                         QueryStats* stats) const {
+    const std::vector<CorpusEntry>& entries = corpus.entries();
+    const std::size_t n = entries.size();
+    const std::size_t screened = options.screened == 0 ? n : std::min(n, options.screened);
+
+    // Screening: structure by WL cosine, tokens by the MinHash estimate.
+    // Each task keeps its own best entries; the survivors are the best of
+    // those.
+    const WLVector query_structure = kernel.vectorize(cfg);
+    const CandidateFilter::Sketch query_sketch = filter.sketch(cfg);
+    auto byScreen = [](const Neighbor& a, const Neighbor& b) {
+        return a.screen != b.screen ? a.screen > b.screen : a.entry < b.entry;
+    };
+    std::vector<Neighbor> survivors;
+    std::mutex survivors_mutex;
+    pool->parallelFor(n, kScreenGrain, [&](std::size_t begin, std::size_t end) {
+        auto best = boundedHeap<Neighbor>(screened, byScreen);
+        for (std::size_t i = begin; i < end; i++) {
+            double screen = 0.5 * WLKernel::cosine(query_structure, structure[i]) +
+                            0.5 * CandidateFilter::estimate(query_sketch, sketches[i]);
+            best.push({static_cast<int>(i), screen, Scorer::Score()});
+        }
+        std::vector<Neighbor> local = best.take();
+        std::lock_guard<std::mutex> lock(survivors_mutex);
+        survivors.insert(survivors.end(), local.begin(), local.end());
+    });
+    auto best_screened = boundedHeap<Neighbor>(screened, byScreen);
+    for (const Neighbor& neighbor : survivors) {
+        best_screened.push(neighbor);
+    }
+    survivors = best_screened.take();
+
+    // Full scores of the survivors: each task scores its share as one
+    // batch against the query and writes every score to the survivor's
+    // own slot
+    std::size_t grain = std::max(kScoreGrain, survivors.size() / (4 * std::max(1u, pool->size())));
+    pool->parallelFor(survivors.size(), grain, [&](std::size_t begin, std::size_t end) {
+        Scorer scorer;
+        scorer.setWeights(corpus.structuralWeight(), corpus.semanticWeight(), corpus.fingerprintWeight());
+        scorer.setArena(&threadArena());
+        std::vector<const CFGBuilder::CFG*> candidates;
+        std::vector<Span<std::uint64_t>> candidate_fingerprints;
+        for (std::size_t k = begin; k < end; k++) {
+            candidates.push_back(&entries[survivors[k].entry].cfg);
+            if (!fingerprints.empty()) {
+                candidate_fingerprints.push_back(fingerprints[survivors[k].entry]);
+            }
+        }
+        // Misses keep their zero score and are dropped below
+        scorer.calculateBatch(
+            cfg, candidates, options.min_score,
+            [&](std::size_t k, const Scorer::Score& score) { survivors[begin + k].score = score; },
+            candidate_fingerprints);
+    });
+
+    auto byScore = [](const Neighbor& a, const Neighbor& b) {
+        return a.score.overall != b.score.overall ? a.score.overall > b.score.overall : a.entry < b.entry;
+    };
+    auto top = boundedHeap<Neighbor>(options.top_k, byScore);
+    for (const Neighbor& neighbor : survivors) {
+        if (neighbor.score.overall >= options.min_score) {
+            top.push(neighbor);
+        }
+    }
+
+    if (stats) {
+        stats->entries = n;
+        stats->scored = survivors.size();
+    }
+    return top.take();
+}
+
+void CorpusIndex::setWeights(double structural_w, double semantic_w, double fingerprint_w) {
+    corpus.setWeights(structural_w, semantic_w, fingerprint_w);
+    hashFingerprints();
+}
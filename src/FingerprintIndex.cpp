@@ -0,0 +1,49 @@
+#include "FingerprintIndex.h"
+
+#include <algorithm>
+
+int FingerprintIndex::add(const std::vector<Fingerprint>& fingerprints) {
+    int document = static_cast<int>(set_sizes.size());
+    std::vector<std::uint64_t> hashes = Fingerprinter::hashSet(fingerprints);
+    for (std::uint64_t hash : hashes) {
+        postings[hash].push_back(document);
+    }
+    set_sizes.push_back(hashes.size());
+    return document;
+}
+
+std::vector<FingerprintMatch> FingerprintIndex::query(const std::vector<Fingerprint>& fingerprints,
+                                                      std::size_t min_shared,
+                                                      std::size_t max_postings) const {
+    std::vector<std::uint64_t> hashes = Fingerprinter::hashSet(fingerprints);
+
+    // Shared-hash counts of only the documents we actually meet
+    std::unordered_map<int, std::size_t> shared;
+    for (std::uint64_t hash : hashes) {
+        auto it = postings.find(hash);
+        if (it == postings.end() || (max_postings > 0 && it->second.size() > max_postings)) {
+            continue;
+        }
+        for (int document : it->second) {
+            shared[document]++;
+        }
+    }
+
+    std::vector<FingerprintMatch> matches;
+    for (const auto& entry : shared) {
+        if (entry.second < std::max<std::size_t>(min_shared, 1)) {
+            continue;
+        }
+        std::size_t total = hashes.size() + set_sizes[entry.first] - entry.second;
+        matches.push_back({entry.first, entry.second,
+                           static_cast<double>(entry.second) / static_cast<double>(total)});
+    }
+
+    std::sort(matches.begin(), matches.end(), [](const FingerprintMatch& a, const FingerprintMatch& b) {
+        if (a.overlap != b.overlap) {
+            return a.overlap > b.overlap;
+        }
+        return a.document < b.document;
+    });
+    return matches;
+}
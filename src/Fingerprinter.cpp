@@ -0,0 +1,140 @@
+#include "Fingerprinter.h"
+
+#include <algorithm>
+#include <deque>
+
+namespace {
+const std::uint64_t kBase = 0x100000001b3ULL;
+
+// Variables are numbered by first appearance in the whole file, so the same
+// code after a different prefix gets different numbers. All variables hash
+// alike here to keep shared runs position independent.
+inline std::uint64_t tokenCode(const Token& token) {
+    SymbolId symbol = token.kind == TokenKind::Identifier ? SymbolTable::kFirstVariable : token.symbol;
+    return ((static_cast<std::uint64_t>(token.kind) << 32) | symbol) + 1;
+}
+
+// Karp-Rabin sums are weak in the low bits; scramble before comparing
+inline std::uint64_t finish(std::uint64_t hash) {
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+}  // namespace
+
+Fingerprinter::Fingerprinter(const FingerprintOptions& options) : opts(options) {
+    opts.k = std::max(1, opts.k);
+    opts.window = std::max(1, opts.window);
+}
+
+template <typename Emit>
+void Fingerprinter::winnow(TokenSpan tokens, std::pmr::memory_resource* memory, Emit emit) const {
+    const std::size_t k = static_cast<std::size_t>(opts.k);
+    const std::size_t w = static_cast<std::size_t>(opts.window);
+    if (tokens.size() < k) {
+        return;
+    }
+
+    // kBase^(k-1), the weight of the token leaving the k-gram
+    std::uint64_t leading = 1;
+    for (std::size_t i = 1; i < k; i++) {
+        leading *= kBase;
+    }
+
+    std::uint64_t rolling = 0;
+    for (std::size_t i = 0; i < k; i++) {
+        rolling = rolling * kBase + tokenCode(tokens[i]);
+    }
+
+    // Monotonic deque of k-gram indices whose hashes increase from front to
+    // back; the front is the window minimum. Ties keep the rightmost, so a
+    // minimum is recorded once while it stays in the window.
+    const std::size_t grams = tokens.size() - k + 1;
+    std::pmr::vector<std::uint64_t> hashes(grams, 0, memory);
+    std::pmr::deque<std::size_t> minima(memory);
+    std::size_t last_recorded = grams;
+
+    for (std::size_t i = 0; i < grams; i++) {
+        if (i > 0) {
+            rolling = (rolling - tokenCode(tokens[i - 1]) * leading) * kBase +
+                      tokenCode(tokens[i + k - 1]);
+        }
+        hashes[i] = finish(rolling);
+
+        while (!minima.empty() && hashes[minima.back()] >= hashes[i]) {
+            minima.pop_back();
+        }
+        minima.push_back(i);
+        if (minima.front() + w <= i) {
+            minima.pop_front();
+        }
+
+        // The first full window, or a short stream treated as one window
+        if (i + 1 >= w || i + 1 == grams) {
+            if (minima.front() != last_recorded) {
+                last_recorded = minima.front();
+                emit(hashes[last_recorded], last_recorded);
+            }
+        }
+    }
+}
+
+std::vector<Fingerprint> Fingerprinter::fingerprint(TokenSpan tokens) const {
+    std::vector<Fingerprint> result;
+    winnow(tokens, std::pmr::get_default_resource(), [&](std::uint64_t hash, std::size_t position) {
+        result.push_back({hash, static_cast<std::uint32_t>(position)});
+    });
+    return result;
+}
+
+std::vector<Fingerprint> Fingerprinter::fingerprint(const CFGBuilder::CFG& cfg) const {
+    return fingerprint(TokenSpan(cfg.tokens));
+}
+
+std::vector<std::uint64_t> Fingerprinter::hashSet(const std::vector<Fingerprint>& fingerprints) {
+    std::vector<std::uint64_t> set;
+    set.reserve(fingerprints.size());
+    for (const Fingerprint& fingerprint : fingerprints) {
+        set.push_back(fingerprint.hash);
+    }
+    std::sort(set.begin(), set.end());
+    set.erase(std::unique(set.begin(), set.end()), set.end());
+    return set;
+}
+
+std::pmr::vector<std::uint64_t> Fingerprinter::hashSet(TokenSpan tokens,
+                                                       std::pmr::memory_resource* memory) const {
+    std::pmr::vector<std::uint64_t> set(memory);
+    winnow(tokens, memory, [&](std::uint64_t hash, std::size_t) { set.push_back(hash); });
+    std::sort(set.begin(), set.end());
+    set.erase(std::unique(set.begin(), set.end()), set.end());
+    return set;
+}
+
+std::size_t Fingerprinter::sharedCount(Span<std::uint64_t> set1, Span<std::uint64_t> set2) {
+    std::size_t shared = 0;
+    auto a = set1.begin(), b = set2.begin();
+    while (a != set1.end() && b != set2.end()) {
+        if (*a < *b) {
+            ++a;
+        } else if (*b < *a) {
+            ++b;
+        } else {
+            shared++;
+            ++a;
+            ++b;
+        }
+    }
+    return shared;
+}
+
+double Fingerprinter::overlap(Span<std::uint64_t> set1, Span<std::uint64_t> set2) {
+    if (set1.empty() && set2.empty()) {
+        return 1.0;
+    }
+    std::size_t shared = sharedCount(set1, set2);
+    return static_cast<double>(shared) / static_cast<double>(set1.size() + set2.size() - shared);
+}
@@ -0,0 +1,176 @@
+#include "HistogramKernel.h"
+
+#include <algorithm>
+#include <atomic>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define HISTOGRAM_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define HISTOGRAM_NEON 1
+#include <arm_neon.h>
+#endif
+
+static_assert(kHistogramBins % 16 == 0, "the vector kernels load whole registers");
+
+namespace {
+using Function = void (*)(const std::uint16_t*, const std::uint16_t*, std::size_t, std::uint32_t*);
+
+void intersectionsScalar(const std::uint16_t* query, const std::uint16_t* rows, std::size_t count,
+                         std::uint32_t* out) {
+    for (std::size_t k = 0; k < count; k++) {
+        const std::uint16_t* row = rows + k * kHistogramBins;
+        std::uint32_t shared = 0;
+        for (int bin = 0; bin < kHistogramBins; bin++) {
+            shared += std::min(query[bin], row[bin]);
+        }
+        out[k] = shared;
+    }
+}
+
+#ifdef HISTOGRAM_X86
+// The minimums are unsigned 16-bit, so they are widened by splitting each
+// 32-bit lane into its halves rather than with the signed madd
+
+__attribute__((target("sse4.1"))) void intersectionsSse41(const std::uint16_t* query, const std::uint16_t* rows,
+                                                          std::size_t count, std::uint32_t* out) {
+    const int kVectors = kHistogramBins / 8;
+    __m128i wanted[kVectors];
+    for (int v = 0; v < kVectors; v++) {
+        wanted[v] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(query + 8 * v));
+    }
+    const __m128i low = _mm_set1_epi32(0xFFFF);
+    for (std::size_t k = 0; k < count; k++) {
+        const std::uint16_t* row = rows + k * kHistogramBins;
+        __m128i sum = _mm_setzero_si128();
+        for (int v = 0; v < kVectors; v++) {
+            __m128i shared =
+                _mm_min_epu16(wanted[v], _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + 8 * v)));
+            sum = _mm_add_epi32(sum, _mm_and_si128(shared, low));
+            sum = _mm_add_epi32(sum, _mm_srli_epi32(shared, 16));
+        }
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+        out[k] = static_cast<std::uint32_t>(_mm_cvtsi128_si32(sum));
+    }
+}
+
+__attribute__((target("avx2"))) void intersectionsAvx2(const std::uint16_t* query, const std::uint16_t* rows,
+                                                       std::size_t count, std::uint32_t* out) {
+    const int kVectors = kHistogramBins / 16;
+    __m256i wanted[kVectors];
+    for (int v = 0; v < kVectors; v++) {
+        wanted[v] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(query + 16 * v));
+    }
+    const __m256i low = _mm256_set1_epi32(0xFFFF);
+    for (std::size_t k = 0; k < count; k++) {
+        const std::uint16_t* row = rows + k * kHistogramBins;
+        __m256i sum = _mm256_setzero_si256();
+        for (int v = 0; v < kVectors; v++) {
+            __m256i shared =
+                _mm256_min_epu16(wanted[v], _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + 16 * v)));
+            sum = _mm256_add_epi32(sum, _mm256_and_si256(shared, low));
+            sum = _mm256_add_epi32(sum, _mm256_srli_epi32(shared, 16));
+        }
+        __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+        half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+        half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+        out[k] = static_cast<std::uint32_t>(_mm_cvtsi128_si32(half));
+    }
+}
+#endif
+
+#ifdef HISTOGRAM_NEON
+void intersectionsNeon(const std::uint16_t* query, const std::uint16_t* rows, std::size_t count,
+                       std::uint32_t* out) {
+    const int kVectors = kHistogramBins / 8;
+    uint16x8_t wanted[kVectors];
+    for (int v = 0; v < kVectors; v++) {
+        wanted[v] = vld1q_u16(query + 8 * v);
+    }
+    for (std::size_t k = 0; k < count; k++) {
+        const std::uint16_t* row = rows + k * kHistogramBins;
+        uint32x4_t sum = vdupq_n_u32(0);
+        for (int v = 0; v < kVectors; v++) {
+            sum = vpadalq_u16(sum, vminq_u16(wanted[v], vld1q_u16(row + 8 * v)));
+        }
+        out[k] = vaddvq_u32(sum);
+    }
+}
+#endif
+
+Function implementation(HistogramKernel::Level level) {
+    switch (level) {
+#ifdef HISTOGRAM_X86
+        case HistogramKernel::Level::SSE41: return intersectionsSse41;
+        case HistogramKernel::Level::AVX2: return intersectionsAvx2;
+#endif
+#ifdef HISTOGRAM_NEON
+        case HistogramKernel::Level::NEON: return intersectionsNeon;
+#endif
+        default: return intersectionsScalar;
+    }
+}
+
+std::atomic<Function> current{nullptr};
+std::atomic<HistogramKernel::Level> current_level{HistogramKernel::Level::Scalar};
+}  // namespace
+
+void HistogramKernel::intersections(const std::uint16_t* query, const std::uint16_t* rows, std::size_t count,
+                                    std::uint32_t* out) {
+    Function function = current.load(std::memory_order_relaxed);
+    if (!function) {
+        use(best());
+        function = current.load(std::memory_order_relaxed);
+    }
+    function(query, rows, count, out);
+}
+
+HistogramKernel::Level HistogramKernel::active() {
+    if (!current.load(std::memory_order_relaxed)) {
+        use(best());
+    }
+    return current_level.load(std::memory_order_relaxed);
+}
+
+HistogramKernel::Level HistogramKernel::best() {
+    for (Level level : {Level::AVX2, Level::NEON, Level::SSE41}) {
+        if (supported(level)) {
+            return level;
+        }
+    }
+    return Level::Scalar;
+}
+
+bool HistogramKernel::supported(Level level) {
+    switch (level) {
+        case Level::Scalar: return true;
+#ifdef HISTOGRAM_X86
+        case Level::SSE41: __builtin_cpu_init(); return __builtin_cpu_supports("sse4.1");
+        case Level::AVX2: __builtin_cpu_init(); return __builtin_cpu_supports("avx2");
+#endif
+#ifdef HISTOGRAM_NEON
+        case Level::NEON: return true;  // part of the 64-bit ARM baseline
+#endif
+        default: return false;
+    }
+}
+
+bool HistogramKernel::use(Level level) {
+    if (!supported(level)) {
+        return false;
+    }
+    current_level.store(level, std::memory_order_relaxed);
+    current.store(implementation(level), std::memory_order_relaxed);
+    return true;
+}
+
+const char* HistogramKernel::name(Level level) {
+    switch (level) {
+        case Level::Scalar: return "scalar";
+        case Level::SSE41: return "sse4.1";
+        case Level::AVX2: return "avx2";
+        case Level::NEON: return "neon";
+    }
+    return "";
+}
@@ -1,88 +1,409 @@
 #include "Normalizer.h"
+#include "Utils/Metrics.h"
 
+#include <array>
 #include <cctype>
-#include <map>
-#include <regex>
+#include <deque>
 #include <string>
-#include <unordered_set>
-
-std::vector<Token> Normalizer::process(const std::string& code) {
-    std::string cleaned = code;
-    removeComments(cleaned);
-    auto tokens = tokenize(cleaned);
-    normalizeVariables(tokens);
-    return tokens;
+#include <unordered_map>
+
+namespace {
+inline bool isWordChar(unsigned char c) {
+    return std::isalnum(c) || c == '_';
 }
 
-void Normalizer::removeComments(std::string& code) {
-    // Remove single-line comments
-    size_t pos = 0;
-    while ((pos = code.find("//", pos)) != std::string::npos) {
-        size_t end = code.find('\n', pos);
-        if (end == std::string::npos)
-            end = code.length();
-        code.erase(pos, end - pos);
-    }
+// Single-character symbol ids indexed by byte
+const std::array<SymbolId, 256>& singleCharSymbols() {
+    static const std::array<SymbolId, 256> table = [] {
+        std::array<SymbolId, 256> result;
+        for (int c = 0; c < 256; c++) {
+            char ch = static_cast<char>(c);
+            SymbolId id = SymbolTable::punctuation(std::string_view(&ch, 1));
+            result[c] = id == SymbolTable::kNoSymbol ? static_cast<SymbolId>(Sym::Unknown) : id;
+        }
+        return result;
+    }();
+    return table;
+}
+
+// Longest operator starting at p (maximal munch); needs up to 3 bytes
+std::size_t matchOperator(const char* p, std::size_t avail, SymbolId& id) {
+    char c0 = p[0];
+    char c1 = avail > 1 ? p[1] : '\0';
+    char c2 = avail > 2 ? p[2] : '\0';
 
-    // Remove multi-line comments
-    pos = 0;
-    while ((pos = code.find("/*", pos)) != std::string::npos) {
-        size_t end = code.find("*/", pos + 2);
-        if (end == std::string::npos)
+    switch (c0) {
+        case '<':
+            if (c1 == '<' && c2 == '=') { id = Sym::ShiftLeftAssign; return 3; }
+            if (c1 == '<') { id = Sym::ShiftLeft; return 2; }
+            if (c1 == '=') { id = Sym::LessEqual; return 2; }
+            break;
+        case '>':
+            if (c1 == '>' && c2 == '=') { id = Sym::ShiftRightAssign; return 3; }
+            if (c1 == '>') { id = Sym::ShiftRight; return 2; }
+            if (c1 == '=') { id = Sym::GreaterEqual; return 2; }
+            break;
+        case '-':
+            if (c1 == '>' && c2 == '*') { id = Sym::ArrowStar; return 3; }
+            if (c1 == '>') { id = Sym::Arrow; return 2; }
+            if (c1 == '-') { id = Sym::MinusMinus; return 2; }
+            if (c1 == '=') { id = Sym::MinusAssign; return 2; }
+            break;
+        case '.':
+            if (c1 == '.' && c2 == '.') { id = Sym::Ellipsis; return 3; }
+            if (c1 == '*') { id = Sym::DotStar; return 2; }
+            break;
+        case '+':
+            if (c1 == '+') { id = Sym::PlusPlus; return 2; }
+            if (c1 == '=') { id = Sym::PlusAssign; return 2; }
             break;
-        code.erase(pos, end - pos + 2);
+        case '&':
+            if (c1 == '&') { id = Sym::AndAnd; return 2; }
+            if (c1 == '=') { id = Sym::AmpAssign; return 2; }
+            break;
+        case '|':
+            if (c1 == '|') { id = Sym::OrOr; return 2; }
+            if (c1 == '=') { id = Sym::PipeAssign; return 2; }
+            break;
+        case ':':
+            if (c1 == ':') { id = Sym::ColonColon; return 2; }
+            break;
+        case '*': if (c1 == '=') { id = Sym::StarAssign; return 2; } break;
+        case '/': if (c1 == '=') { id = Sym::SlashAssign; return 2; } break;
+        case '%': if (c1 == '=') { id = Sym::PercentAssign; return 2; } break;
+        case '^': if (c1 == '=') { id = Sym::CaretAssign; return 2; } break;
+        case '=': if (c1 == '=') { id = Sym::Equal; return 2; } break;
+        case '!': if (c1 == '=') { id = Sym::NotEqual; return 2; } break;
+        default: break;
     }
+
+    id = singleCharSymbols()[static_cast<unsigned char>(c0)];
+    return 1;
 }
 
-std::vector<Token> Normalizer::tokenize(const std::string& code) {
+bool isRawStringPrefix(std::string_view word) {
+    return word == "R" || word == "LR" || word == "uR" || word == "UR" || word == "u8R";
+}
+}  // namespace
+
+// Resumable lexer. Input arrives in one or more chunks; a lexeme that may
+// continue past the end of a chunk is carried over (a few bytes at most,
+// or one identifier) and re-scanned together with the next chunk.
+class Normalizer::Lexer {
+   public:
+    Lexer(bool owns_input, std::pmr::memory_resource* memory, std::vector<SourceSpan>* spans = nullptr)
+        : carry(memory), raw_terminator(memory), spans(spans), variables(memory), names(memory),
+          copy_names(owns_input) {}
+
+    void feed(std::string_view chunk, bool last) {
+        if (carry.empty()) {
+            origin = consumed;
+            consumed += chunk.size();
+            scan(chunk, last);
+            finish(last);
+            return;
+        }
+
+        std::pmr::string buffer(carry.get_allocator());
+        buffer.reserve(carry.size() + chunk.size());
+        buffer.append(carry).append(chunk.data(), chunk.size());
+        origin = consumed - carry.size();
+        consumed += chunk.size();
+        carry.clear();
+        // Identifiers seen in this buffer must outlive it
+        bool saved = copy_names;
+        copy_names = true;
+        scan(buffer, last);
+        copy_names = saved;
+        finish(last);
+    }
+
+    std::vector<Token> take() {
+        METRIC_COUNT(Files, 1);
+        METRIC_COUNT(Tokens, tokens.size());
+        return std::move(tokens);
+    }
+
+   private:
+    enum class State { Code, LineComment, BlockComment, String, Char, RawString };
+
+    State state = State::Code;
+    std::pmr::string carry;
+    std::pmr::string raw_terminator;  // )delimiter" of the open raw string
     std::vector<Token> tokens;
-    std::string current = "";
-
-    for (size_t i = 0; i < code.length(); i++) {
-        char c = code[i];
-
-        if (std::isalnum(c) || c == '_') {
-            current += c;
-        } else {
-            if (!current.empty()) {
-                std::string type = isKeyword(current) ? "keyword" : "identifier";
-                tokens.push_back({type, current});
-                current = "";
+
+    // Source positions, when requested: `origin` is the offset of the
+    // buffer being scanned, `consumed` the offset after the last chunk fed
+    std::vector<SourceSpan>* spans;
+    std::size_t origin = 0;
+    std::size_t consumed = 0;
+    std::size_t open_literal = kNoLiteral;  // span of the literal being skipped
+    static constexpr std::size_t kNoLiteral = static_cast<std::size_t>(-1);
+
+    // Identifier spellings; views point into the input unless copy_names,
+    // in which case they point into `names`
+    std::pmr::unordered_map<std::string_view, SymbolId> variables;
+    std::pmr::deque<std::pmr::string> names;
+    bool copy_names;
+
+    void scan(std::string_view s, bool last) {
+        const std::size_t n = s.size();
+        std::size_t i = 0;
+
+        while (i < n) {
+            switch (state) {
+                case State::LineComment: {
+                    std::size_t end = s.find('\n', i);
+                    if (end == std::string_view::npos) {
+                        return;
+                    }
+                    state = State::Code;
+                    i = end + 1;
+                    break;
+                }
+                case State::BlockComment: {
+                    std::size_t end = s.find("*/", i);
+                    if (end == std::string_view::npos) {
+                        if (!last && s[n - 1] == '*') carry.assign(1, '*');
+                        return;
+                    }
+                    state = State::Code;
+                    i = end + 2;
+                    break;
+                }
+                case State::String:
+                case State::Char: {
+                    char quote = state == State::String ? '"' : '\'';
+                    while (i < n && s[i] != quote && s[i] != '\n') {
+                        if (s[i] == '\\') {
+                            if (i + 1 == n) {
+                                if (!last) carry.assign(1, '\\');
+                                return;
+                            }
+                            i++;
+                        }
+                        i++;
+                    }
+                    if (i == n) {
+                        return;
+                    }
+                    // Closing quote, or an unterminated literal ends at the newline
+                    closeLiteral(s[i] == quote ? i + 1 : i);
+                    state = State::Code;
+                    i++;
+                    break;
+                }
+                case State::RawString: {
+                    std::size_t end = s.find(raw_terminator, i);
+                    if (end == std::string_view::npos) {
+                        std::size_t keep = std::min(n - i, raw_terminator.size() - 1);
+                        if (!last) carry.assign(s.substr(n - keep));
+                        return;
+                    }
+                    state = State::Code;
+                    i = end + raw_terminator.size();
+                    closeLiteral(i);
+                    break;
+                }
+                case State::Code:
+                    if (!scanCode(s, i, last)) {
+                        return;
+                    }
+                    break;
+            }
+        }
+    }
+
+    // Lex code up to the next comment or literal. Returns false once the rest
+    // of the chunk has been carried over.
+    bool scanCode(std::string_view s, std::size_t& i, bool last) {
+        const std::size_t n = s.size();
+
+        while (i < n) {
+            unsigned char c = static_cast<unsigned char>(s[i]);
+
+            if (std::isspace(c)) {
+                i++;
+                continue;
             }
 
-            if (!std::isspace(c)) {
-                std::string symbol(1, c);
-                tokens.push_back({"symbol", symbol});
+            if (isWordChar(c)) {
+                std::size_t start = i;
+                bool number = std::isdigit(c);
+                while (i < n) {
+                    unsigned char w = static_cast<unsigned char>(s[i]);
+                    // Digit separators (1'000'000) stay inside the number
+                    bool separator = number && w == '\'' && i + 1 < n &&
+                                     isWordChar(static_cast<unsigned char>(s[i + 1]));
+                    if (!isWordChar(w) && !separator) break;
+                    i++;
+                }
+                if ((i == n || (number && s[i] == '\'' && i + 1 == n)) && !last) {
+                    carry.assign(s.substr(start));
+                    return false;
+                }
+
+                std::string_view word = s.substr(start, i - start);
+                if (i < n && s[i] == '"' && isRawStringPrefix(word)) {
+                    if (!openRawString(s, start, i, last)) {
+                        carry.assign(s.substr(start));
+                        return false;
+                    }
+                    return true;
+                }
+                emitWord(word, start);
+                continue;
+            }
+
+            if (c == '/' || c == '"' || c == '\'') {
+                if (c == '/' && i + 1 == n && !last) {
+                    carry.assign(1, '/');
+                    return false;
+                }
+                char next = i + 1 < n ? s[i + 1] : '\0';
+                if (c == '/' && next == '/') {
+                    state = State::LineComment;
+                    i += 2;
+                    return true;
+                }
+                if (c == '/' && next == '*') {
+                    state = State::BlockComment;
+                    i += 2;
+                    return true;
+                }
+                if (c == '"' || c == '\'') {
+                    emit({TokenKind::Literal, c == '"' ? static_cast<SymbolId>(Sym::StringLiteral)
+                                                       : static_cast<SymbolId>(Sym::CharLiteral)},
+                         i, 1);
+                    openLiteral();
+                    state = c == '"' ? State::String : State::Char;
+                    i++;
+                    return true;
+                }
+            }
+
+            // Operators need up to two bytes of lookahead
+            if (n - i < 3 && !last) {
+                carry.assign(s.substr(i));
+                return false;
             }
+            SymbolId id;
+            std::size_t length = matchOperator(s.data() + i, n - i, id);
+            emit({TokenKind::Symbol, id}, i, length);
+            i += length;
         }
+        return true;
     }
 
-    if (!current.empty()) {
-        std::string type = isKeyword(current) ? "keyword" : "identifier";
-        tokens.push_back({type, current});
+    // s[i] is the opening quote of R"delim( ... )delim", whose prefix starts at s[start]
+    bool openRawString(std::string_view s, std::size_t start, std::size_t& i, bool last) {
+        std::size_t paren = s.find('(', i + 1);
+        if (paren == std::string_view::npos) {
+            return last ? (i = s.size(), true) : false;
+        }
+
+        raw_terminator.assign(1, ')');
+        raw_terminator.append(s.substr(i + 1, paren - i - 1));
+        raw_terminator.push_back('"');
+
+        emit({TokenKind::Literal, Sym::StringLiteral}, start, paren + 1 - start);
+        openLiteral();
+        state = State::RawString;
+        i = paren + 1;
+        return true;
     }
 
-    return tokens;
-}
+    void emit(Token token, std::size_t start, std::size_t length) {
+        tokens.push_back(token);
+        if (spans) {
+            spans->push_back({static_cast<std::uint32_t>(origin + start), static_cast<std::uint32_t>(length)});
+        }
+    }
+
+    // A literal's span grows to its closing quote, which may be chunks away
+    void openLiteral() {
+        if (spans) {
+            open_literal = spans->size() - 1;
+        }
+    }
 
-void Normalizer::normalizeVariables(std::vector<Token>& tokens) {
-    std::map<std::string, std::string> var_map;
-    int counter = 1;
+    void closeLiteral(std::size_t end) {
+        if (spans && open_literal != kNoLiteral) {
+            SourceSpan& span = (*spans)[open_literal];
+            span.length = static_cast<std::uint32_t>(origin + end - span.offset);
+            open_literal = kNoLiteral;
+        }
+    }
 
-    for (auto& token : tokens) {
-        if (token.type == "identifier" && !isKeyword(token.value)) {
-            if (var_map.find(token.value) == var_map.end()) {
-                var_map[token.value] = "VAR_" + std::to_string(counter++);
+    // Input ended inside a literal or comment
+    void finish(bool last) {
+        if (last && open_literal != kNoLiteral) {
+            closeLiteral(consumed - origin);
+        }
+    }
+
+    void emitWord(std::string_view word, std::size_t start) {
+        SymbolId keyword = SymbolTable::keyword(word);
+        if (keyword != SymbolTable::kNoSymbol) {
+            emit({TokenKind::Keyword, keyword}, start, word.size());
+            return;
+        }
+
+        auto it = variables.find(word);
+        if (it == variables.end()) {
+            if (copy_names) {
+                names.emplace_back(word);
+                word = names.back();
             }
-            token.value = var_map[token.value];
+            SymbolId id = SymbolTable::variable(static_cast<std::uint32_t>(variables.size() + 1));
+            it = variables.emplace(word, id).first;
         }
+        emit({TokenKind::Identifier, it->second}, start, word.size());
     }
+};
+
+void Normalizer::setArena(std::pmr::memory_resource* memory) {
+    scratch = memory ? memory : std::pmr::get_default_resource();
+}
+
+std::vector<Token> Normalizer::process(std::string_view code) {
+    METRIC_TIME(Normalize);
+    Lexer lexer(false, scratch);
+    lexer.feed(code, true);
+    return lexer.take();
+}
+
+std::vector<Token> Normalizer::process(std::istream& input, std::size_t chunk_size) {
+    METRIC_TIME(Normalize);
+    Lexer lexer(true, scratch);
+    return lexStream(lexer, input, chunk_size);
+}
+
+std::vector<Token> Normalizer::process(std::string_view code, std::vector<SourceSpan>& spans) {
+    METRIC_TIME(Normalize);
+    spans.clear();
+    Lexer lexer(false, scratch, &spans);
+    lexer.feed(code, true);
+    return lexer.take();
+}
+
+std::vector<Token> Normalizer::process(std::istream& input, std::vector<SourceSpan>& spans,
+                                       std::size_t chunk_size) {
+    METRIC_TIME(Normalize);
+    spans.clear();
+    Lexer lexer(true, scratch, &spans);
+    return lexStream(lexer, input, chunk_size);
 }
 
-bool Normalizer::isKeyword(const std::string& word) {
-    static const std::unordered_set<std::string> keywords = {
-        "int",    "float",  "double", "char", "if",     "else",    "while",
-        "for",    "return", "class",  "void", "public", "private", "const",
-        "static", "struct", "bool",   "true", "false"};
-    return keywords.count(word) > 0;
+std::vector<Token> Normalizer::lexStream(Lexer& lexer, std::istream& input, std::size_t chunk_size) {
+    std::string chunk(chunk_size > 0 ? chunk_size : 1, '\0');
+
+    while (input) {
+        input.read(&chunk[0], static_cast<std::streamsize>(chunk.size()));
+        std::size_t got = static_cast<std::size_t>(input.gcount());
+        bool last = !input;
+        lexer.feed(std::string_view(chunk.data(), got), last);
+    }
+
+    return lexer.take();
 }
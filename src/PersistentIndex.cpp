@@ -0,0 +1,414 @@
+#include "PersistentIndex.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <utility>
+
+namespace {
+const char kMagic[8] = {'S', 'I', 'M', 'I', 'D', 'X', '\0', '\0'};
+
+std::uint64_t align8(std::uint64_t offset) {
+    return (offset + 7) & ~static_cast<std::uint64_t>(7);
+}
+
+std::uint64_t pairKey(int a, int b) {
+    if (a > b) std::swap(a, b);
+    return (static_cast<std::uint64_t>(a) << 32) | static_cast<std::uint32_t>(b);
+}
+}  // namespace
+
+struct PersistentIndex::Header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t symbol_count;    // Sym::PredefinedCount when written
+    std::uint32_t histogram_bins;  // kHistogramBins when written
+    std::uint32_t file_count;
+    std::uint64_t block_count;
+    std::uint64_t token_count;
+    std::uint64_t edge_count;
+    std::uint64_t pair_count;
+    std::uint64_t string_bytes;
+    std::uint64_t files_offset;
+    std::uint64_t blocks_offset;
+    std::uint64_t tokens_offset;
+    std::uint64_t edges_offset;
+    std::uint64_t pairs_offset;
+    std::uint64_t strings_offset;
+    double threshold;
+    double structural_weight;
+    double semantic_weight;
+    double fingerprint_weight;
+    double candidate_threshold;  // CandidateOptions of the run; 0 = all pairs scored
+    double candidate_recall;
+    std::int32_t candidate_hashes;
+    std::int32_t candidate_bands;
+    std::int32_t candidate_shingle;
+    std::uint32_t reserved;
+};
+
+struct PersistentIndex::FileRecord {
+    std::uint64_t content_hash;
+    std::uint64_t path_offset;
+    std::uint64_t first_block;
+    std::uint64_t first_token;
+    std::uint32_t path_length;
+    std::uint32_t block_count;
+    std::uint32_t token_count;
+    std::uint32_t reserved;
+};
+
+struct PersistentIndex::BlockRecord {
+    std::int32_t id;
+    std::uint32_t token_count;
+    std::uint64_t first_token;  // into the token array of the whole index
+    std::uint64_t first_edge;
+    std::uint32_t edge_count;
+    std::uint32_t control_flow;
+    std::uint32_t feature_token_count;
+    std::uint32_t reserved;
+    std::uint64_t semantic_signature;
+    std::uint64_t operation_signature;
+    std::uint16_t histogram[kHistogramBins];
+};
+
+struct PersistentIndex::TokenRecord {
+    std::uint32_t symbol;
+    std::uint8_t kind;
+    std::uint8_t reserved[3];
+};
+
+struct PersistentIndex::PairRecord {
+    std::uint32_t first;
+    std::uint32_t second;
+    double structural;
+    double semantic;
+    double fingerprint;
+    double overall;
+    std::int32_t matched_blocks;
+    std::int32_t total_blocks;
+};
+
+static_assert(sizeof(std::uint16_t) * kHistogramBins % 8 == 0, "block records must stay 8-byte aligned");
+
+bool PersistentIndex::open(const std::string& path) {
+    by_path.clear();
+    by_pair.clear();
+    files = nullptr;
+    file_count = 0;
+    pair_count = 0;
+
+    if (!file.open(path)) {
+        error_message = file.error();
+        return false;
+    }
+
+    auto fail = [this](const std::string& message) {
+        error_message = message;
+        file.close();
+        return false;
+    };
+
+    const char* base = file.view().data();
+    std::uint64_t size = file.size();
+
+    Header header;
+    if (size < sizeof(Header)) {
+        return fail("index file is truncated");
+    }
+    std::memcpy(&header, base, sizeof(Header));
+
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+        return fail("not an index file");
+    }
+    if (header.version != kVersion || header.symbol_count != Sym::PredefinedCount ||
+        header.histogram_bins != static_cast<std::uint32_t>(kHistogramBins)) {
+        return fail("index was written by an incompatible version");
+    }
+
+    // Every section must lie inside the file and be aligned for in-place reads
+    auto section = [&](std::uint64_t offset, std::uint64_t count, std::uint64_t record_size) {
+        return offset % 8 == 0 && offset <= size && count <= (size - offset) / record_size;
+    };
+    if (reinterpret_cast<std::uintptr_t>(base) % 8 != 0 ||
+        !section(header.files_offset, header.file_count, sizeof(FileRecord)) ||
+        !section(header.blocks_offset, header.block_count, sizeof(BlockRecord)) ||
+        !section(header.tokens_offset, header.token_count, sizeof(TokenRecord)) ||
+        !section(header.edges_offset, header.edge_count, sizeof(std::int32_t)) ||
+        !section(header.pairs_offset, header.pair_count, sizeof(PairRecord)) ||
+        !section(header.strings_offset, header.string_bytes, 1)) {
+        return fail("index file is damaged");
+    }
+
+    files = reinterpret_cast<const FileRecord*>(base + header.files_offset);
+    blocks = reinterpret_cast<const BlockRecord*>(base + header.blocks_offset);
+    tokens = reinterpret_cast<const TokenRecord*>(base + header.tokens_offset);
+    edges = reinterpret_cast<const std::int32_t*>(base + header.edges_offset);
+    pairs = reinterpret_cast<const PairRecord*>(base + header.pairs_offset);
+    strings = base + header.strings_offset;
+    file_count = header.file_count;
+    pair_count = header.pair_count;
+    threshold = header.threshold;
+    structural_weight = header.structural_weight;
+    semantic_weight = header.semantic_weight;
+    fingerprint_weight = header.fingerprint_weight;
+    candidate_options.threshold = header.candidate_threshold;
+    candidate_options.recall = header.candidate_recall;
+    candidate_options.num_hashes = header.candidate_hashes;
+    candidate_options.bands = header.candidate_bands;
+    candidate_options.shingle = header.candidate_shingle;
+
+    // [first, first + count) inside [low, high), without overflowing
+    auto inside = [](std::uint64_t first, std::uint64_t count, std::uint64_t low, std::uint64_t high) {
+        return first >= low && first <= high && count <= high - first;
+    };
+    for (std::uint32_t i = 0; i < file_count; i++) {
+        const FileRecord& record = files[i];
+        if (!inside(record.path_offset, record.path_length, 0, header.string_bytes) ||
+            !inside(record.first_block, record.block_count, 0, header.block_count) ||
+            !inside(record.first_token, record.token_count, 0, header.token_count)) {
+            return fail("index file is damaged");
+        }
+        by_path[this->path(static_cast<int>(i))] = static_cast<int>(i);
+
+        // Blocks index their file's tokens and edges and name their file's
+        // blocks; a file's edges start at those of its first block, and
+        // loadCFG() takes edge offsets relative to that
+        const std::uint64_t first_edge = record.block_count > 0 ? blocks[record.first_block].first_edge : 0;
+        for (std::uint64_t b = record.first_block; b < record.first_block + record.block_count; b++) {
+            const BlockRecord& block = blocks[b];
+            if (block.id != static_cast<std::int32_t>(b - record.first_block) ||
+                !inside(block.first_token, block.token_count, record.first_token,
+                        record.first_token + record.token_count) ||
+                !inside(block.first_edge, block.edge_count, first_edge, header.edge_count) ||
+                block.first_edge - first_edge + block.edge_count > UINT32_MAX) {
+                return fail("index file is damaged");
+            }
+            for (std::uint64_t e = block.first_edge; e < block.first_edge + block.edge_count; e++) {
+                if (edges[e] < 0 || static_cast<std::uint32_t>(edges[e]) >= record.block_count) {
+                    return fail("index file is damaged");
+                }
+            }
+        }
+    }
+    for (std::uint64_t i = 0; i < pair_count; i++) {
+        by_pair[pairKey(pairs[i].first, pairs[i].second)] = i;
+    }
+
+    error_message.clear();
+    return true;
+}
+
+bool PersistentIndex::write(const std::string& path, const Corpus& corpus,
+                            const std::vector<PairResult>& results, double min_score,
+                            std::string& error) {
+    std::vector<FileRecord> file_records;
+    std::vector<BlockRecord> block_records;
+    std::vector<TokenRecord> token_records;
+    std::vector<std::int32_t> edge_records;
+    std::vector<PairRecord> pair_records;
+    std::string string_pool;
+
+    for (const CorpusEntry& entry : corpus.entries()) {
+        FileRecord file_record = {};
+        file_record.content_hash = entry.content_hash;
+        file_record.path_offset = string_pool.size();
+        file_record.path_length = static_cast<std::uint32_t>(entry.path.size());
+        file_record.first_block = block_records.size();
+        file_record.first_token = token_records.size();
+        string_pool += entry.path;
+
+        // The CFG layout is already flat: block token and edge ranges only
+        // move by the offset of this file's arrays
+        const std::uint64_t first_token = token_records.size();
+        const std::uint64_t first_edge = edge_records.size();
+        for (const BasicBlock& block : entry.cfg.blocks) {
+            BlockRecord record = {};
+            record.id = block.id;
+            record.first_token = first_token + block.first_token;
+            record.token_count = block.token_count;
+            record.first_edge = first_edge + block.first_edge;
+            record.edge_count = block.edge_count;
+            record.control_flow = block.features.control_flow;
+            record.feature_token_count = block.features.token_count;
+            record.semantic_signature = block.features.semantic_signature;
+            record.operation_signature = block.features.operation_signature;
+            std::memcpy(record.histogram, block.features.histogram.data(), sizeof(record.histogram));
+            block_records.push_back(record);
+        }
+        for (const Token& token : entry.cfg.tokens) {
+            TokenRecord token_record = {};
+            token_record.symbol = token.symbol;
+            token_record.kind = static_cast<std::uint8_t>(token.kind);
+            token_records.push_back(token_record);
+        }
+        edge_records.insert(edge_records.end(), entry.cfg.edges.begin(), entry.cfg.edges.end());
+
+        file_record.block_count = static_cast<std::uint32_t>(block_records.size() - file_record.first_block);
+        file_record.token_count = static_cast<std::uint32_t>(token_records.size() - file_record.first_token);
+        file_records.push_back(file_record);
+    }
+
+    for (const PairResult& result : results) {
+        PairRecord record = {};
+        record.first = static_cast<std::uint32_t>(result.first);
+        record.second = static_cast<std::uint32_t>(result.second);
+        record.structural = result.score.structural;
+        record.semantic = result.score.semantic;
+        record.fingerprint = result.score.fingerprint;
+        record.overall = result.score.overall;
+        record.matched_blocks = result.score.matched_blocks;
+        record.total_blocks = result.score.total_blocks;
+        pair_records.push_back(record);
+    }
+
+    Header header = {};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.symbol_count = Sym::PredefinedCount;
+    header.histogram_bins = kHistogramBins;
+    header.file_count = static_cast<std::uint32_t>(file_records.size());
+    header.block_count = block_records.size();
+    header.token_count = token_records.size();
+    header.edge_count = edge_records.size();
+    header.pair_count = pair_records.size();
+    header.string_bytes = string_pool.size();
+    header.threshold = min_score;
+    header.structural_weight = corpus.structuralWeight();
+    header.semantic_weight = corpus.semanticWeight();
+    header.fingerprint_weight = corpus.fingerprintWeight();
+    header.candidate_threshold = corpus.candidateOptions().threshold;
+    header.candidate_recall = corpus.candidateOptions().recall;
+    header.candidate_hashes = corpus.candidateOptions().num_hashes;
+    header.candidate_bands = corpus.candidateOptions().bands;
+    header.candidate_shingle = corpus.candidateOptions().shingle;
+
+    std::uint64_t offset = align8(sizeof(Header));
+    header.files_offset = offset;
+    offset = align8(offset + file_records.size() * sizeof(FileRecord));
+    header.blocks_offset = offset;
+    offset = align8(offset + block_records.size() * sizeof(BlockRecord));
+    header.tokens_offset = offset;
+    offset = align8(offset + token_records.size() * sizeof(TokenRecord));
+    header.edges_offset = offset;
+    offset = align8(offset + edge_records.size() * sizeof(std::int32_t));
+    header.pairs_offset = offset;
+    offset = align8(offset + pair_records.size() * sizeof(PairRecord));
+    header.strings_offset = offset;
+
+    // Write to a temporary name and rename, so readers never see a partial file
+    std::string temporary = path + ".tmp";
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        error = "cannot create '" + temporary + "'";
+        return false;
+    }
+
+    std::uint64_t written = 0;
+    auto put = [&](std::uint64_t at, const void* data, std::uint64_t bytes) {
+        static const char zeros[8] = {};
+        out.write(zeros, static_cast<std::streamsize>(at - written));
+        out.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+        written = at + bytes;
+    };
+
+    put(0, &header, sizeof(Header));
+    put(header.files_offset, file_records.data(), file_records.size() * sizeof(FileRecord));
+    put(header.blocks_offset, block_records.data(), block_records.size() * sizeof(BlockRecord));
+    put(header.tokens_offset, token_records.data(), token_records.size() * sizeof(TokenRecord));
+    put(header.edges_offset, edge_records.data(), edge_records.size() * sizeof(std::int32_t));
+    put(header.pairs_offset, pair_records.data(), pair_records.size() * sizeof(PairRecord));
+    put(header.strings_offset, string_pool.data(), string_pool.size());
+    out.close();
+
+    if (!out || std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        error = "cannot write '" + path + "'";
+        return false;
+    }
+    return true;
+}
+
+std::size_t PersistentIndex::size() const {
+    return file_count;
+}
+
+int PersistentIndex::find(const std::string& path) const {
+    auto it = by_path.find(path);
+    return it != by_path.end() ? it->second : -1;
+}
+
+std::string PersistentIndex::path(int id) const {
+    const FileRecord& record = files[id];
+    return std::string(strings + record.path_offset, record.path_length);
+}
+
+std::uint64_t PersistentIndex::contentHash(int id) const {
+    return files[id].content_hash;
+}
+
+std::vector<Token> PersistentIndex::loadTokens(int id) const {
+    const FileRecord& record = files[id];
+    std::vector<Token> result;
+    result.reserve(record.token_count);
+
+    for (std::uint64_t t = record.first_token; t < record.first_token + record.token_count; t++) {
+        result.push_back({static_cast<TokenKind>(tokens[t].kind), tokens[t].symbol});
+    }
+    return result;
+}
+
+CFGBuilder::CFG PersistentIndex::loadCFG(int id) const {
+    const FileRecord& record = files[id];
+    CFGBuilder::CFG cfg;
+    cfg.tokens = loadTokens(id);
+    cfg.blocks.reserve(record.block_count);
+    if (record.block_count == 0) {
+        return cfg;
+    }
+
+    // Edges of a file are contiguous, starting at those of its first block
+    const std::uint64_t first_edge = blocks[record.first_block].first_edge;
+    std::uint64_t edge_end = first_edge;
+
+    for (std::uint64_t b = record.first_block; b < record.first_block + record.block_count; b++) {
+        const BlockRecord& stored = blocks[b];
+
+        BasicBlock block;
+        block.id = stored.id;
+        block.first_token = static_cast<std::uint32_t>(stored.first_token - record.first_token);
+        block.token_count = stored.token_count;
+        block.first_edge = static_cast<std::uint32_t>(stored.first_edge - first_edge);
+        block.edge_count = stored.edge_count;
+        edge_end = std::max(edge_end, stored.first_edge + stored.edge_count);
+
+        block.features.control_flow = stored.control_flow;
+        block.features.token_count = stored.feature_token_count;
+        block.features.semantic_signature = stored.semantic_signature;
+        block.features.operation_signature = stored.operation_signature;
+        std::memcpy(block.features.histogram.data(), stored.histogram, sizeof(stored.histogram));
+
+        cfg.blocks.push_back(block);
+    }
+    cfg.edges.assign(edges + first_edge, edges + edge_end);
+
+    return cfg;
+}
+
+bool PersistentIndex::findPair(int a, int b, Scorer::Score& score) const {
+    auto it = by_pair.find(pairKey(a, b));
+    if (it == by_pair.end()) {
+        return false;
+    }
+
+    const PairRecord& record = pairs[it->second];
+    score.structural = record.structural;
+    score.semantic = record.semantic;
+    score.fingerprint = record.fingerprint;
+    score.overall = record.overall;
+    score.matched_blocks = record.matched_blocks;
+    score.total_blocks = record.total_blocks;
+    return true;
+}
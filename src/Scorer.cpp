@@ -1,12 +1,198 @@
 #include "Scorer.h"
 
+#include "AssignmentSolver.h"
+#include "Utils/Metrics.h"
 #include <algorithm>
+#include <array>
 #include <iostream>
 
+namespace {
+// The matcher's blend of matched blocks and preserved edges
+const double kNodeWeight = 0.6;
+const double kEdgeWeight = 0.4;
+
+// Slack for rounding, so that a bound never rules out a pair whose exact
+// score lands on the threshold
+const double kBoundSlack = 1e-9;
+
+// Candidates whose blocks are laid out together at a time
+const std::size_t kBatchChunk = 64;
+
+// Size of the multiset intersection of two sorted sequences
+std::size_t sharedCount(Span<std::uint64_t> a, Span<std::uint64_t> b) {
+    std::size_t shared = 0;
+    for (std::size_t i = 0, j = 0; i < a.size() && j < b.size();) {
+        if (a[i] < b[j]) {
+            i++;
+        } else if (b[j] < a[i]) {
+            j++;
+        } else {
+            shared++;
+            i++;
+            j++;
+        }
+    }
+    return shared;
+}
+}  // namespace
+
+Scorer::BoundSide::BoundSide(std::pmr::memory_resource* memory)
+    : classes(memory), semantic(memory), operations(memory) {}
+
+Scorer::BoundSide Scorer::boundSide(const CFGBuilder::CFG& cfg, std::pmr::memory_resource* memory) {
+    // The matcher never pairs an empty block
+    std::pmr::vector<const BlockFeatures*> blocks(memory);
+    blocks.reserve(cfg.blocks.size());
+    for (const auto& block : cfg.blocks) {
+        if (block.features.token_count > 0) {
+            blocks.push_back(&block.features);
+        }
+    }
+    std::sort(blocks.begin(), blocks.end(), [](const BlockFeatures* a, const BlockFeatures* b) {
+        return a->control_flow < b->control_flow;
+    });
+
+    BoundSide side(memory);
+    for (std::size_t i = 0; i < blocks.size();) {
+        ClassSummary summary;
+        summary.control_flow = blocks[i]->control_flow;
+        summary.semantic_begin = side.semantic.size();
+        summary.operation_begin = side.operations.size();
+        for (; i < blocks.size() && blocks[i]->control_flow == summary.control_flow; i++) {
+            summary.blocks++;
+            for (int bin = 0; bin < kHistogramBins; bin++) {
+                summary.histogram[bin] += blocks[i]->histogram[bin];
+            }
+            side.semantic.push_back(blocks[i]->semantic_signature);
+            if (blocks[i]->operation_signature != 0) {
+                side.operations.push_back(blocks[i]->operation_signature);
+            }
+        }
+        std::sort(side.semantic.begin() + summary.semantic_begin, side.semantic.end());
+        std::sort(side.operations.begin() + summary.operation_begin, side.operations.end());
+        side.classes.push_back(summary);
+    }
+    return side;
+}
+
+Scorer::PairingBound Scorer::pairingBound(const BoundSide& side1, const BoundSide& side2) {
+    // Matched blocks share their control flow and at least one token, so
+    // per class no more pair than the smaller side has blocks or the two
+    // sides' summed histograms share tokens; likewise no more pairs score
+    // semantically than the class shares signatures
+    auto semanticOf = [](const BoundSide& side, std::size_t c) {
+        std::size_t end = c + 1 < side.classes.size() ? side.classes[c + 1].semantic_begin : side.semantic.size();
+        return Span<std::uint64_t>(side.semantic).subspan(side.classes[c].semantic_begin,
+                                                          end - side.classes[c].semantic_begin);
+    };
+    auto operationsOf = [](const BoundSide& side, std::size_t c) {
+        std::size_t end = c + 1 < side.classes.size() ? side.classes[c + 1].operation_begin : side.operations.size();
+        return Span<std::uint64_t>(side.operations).subspan(side.classes[c].operation_begin,
+                                                            end - side.classes[c].operation_begin);
+    };
+
+    PairingBound bound;
+    for (std::size_t c1 = 0, c2 = 0; c1 < side1.classes.size() && c2 < side2.classes.size();) {
+        const ClassSummary& class1 = side1.classes[c1];
+        const ClassSummary& class2 = side2.classes[c2];
+        if (class1.control_flow < class2.control_flow) {
+            c1++;
+            continue;
+        }
+        if (class2.control_flow < class1.control_flow) {
+            c2++;
+            continue;
+        }
+
+        std::size_t shared_tokens = 0;
+        for (int bin = 0; bin < kHistogramBins; bin++) {
+            shared_tokens += std::min(class1.histogram[bin], class2.histogram[bin]);
+        }
+        int pairs = static_cast<int>(
+            std::min({static_cast<std::size_t>(std::min(class1.blocks, class2.blocks)), shared_tokens}));
+        bound.blocks += pairs;
+        bound.semantic += std::min(pairs, static_cast<int>(sharedCount(semanticOf(side1, c1), semanticOf(side2, c2))));
+        bound.operations +=
+            std::min(pairs, static_cast<int>(sharedCount(operationsOf(side1, c1), operationsOf(side2, c2))));
+        c1++;
+        c2++;
+    }
+    return bound;
+}
+
+double Scorer::semanticBound(int matched, int total_blocks, const PairingBound& bound) {
+    // Scored as in SemanticHasher::compareBlocks: 1 for equal semantic
+    // signatures, 0.8 for equal operation signatures
+    if (matched <= 0 || total_blocks <= 0) {
+        return 0.0;
+    }
+    int equal = std::min(matched, bound.semantic);
+    int similar = std::min(matched - equal, bound.operations);
+    return (equal + 0.8 * similar) / total_blocks;
+}
+
 Scorer::Score Scorer::calculate(const CFGBuilder::CFG& cfg1, const CFGBuilder::CFG& cfg2) {
+    PairInputs inputs;
+    inputs.report_fingerprint = true;
     Score result;
+    scorePair(cfg1, cfg2, 0.0, inputs, result);
+    return result;
+}
+
+bool Scorer::calculateAbove(const CFGBuilder::CFG& cfg1, const CFGBuilder::CFG& cfg2, double threshold,
+                            Score& result) {
+    return scorePair(cfg1, cfg2, threshold, PairInputs(), result);
+}
+
+bool Scorer::calculateAbove(const CFGBuilder::CFG& cfg1, const CFGBuilder::CFG& cfg2,
+                            Span<std::uint64_t> fingerprints1, Span<std::uint64_t> fingerprints2, double threshold,
+                            Score& result) {
+    PairInputs inputs;
+    inputs.fingerprints1 = &fingerprints1;
+    inputs.fingerprints2 = &fingerprints2;
+    return scorePair(cfg1, cfg2, threshold, inputs, result);
+}
+
+void Scorer::calculateBatch(const CFGBuilder::CFG& query, Span<const CFGBuilder::CFG*> candidates,
+                            double threshold, const BatchCallback& callback, Span<Span<std::uint64_t>> fingerprints) {
+    // Per-pair scratch lives in the arena, which every pair resets, so
+    // what outlives a pair comes from the heap
+    BoundSide bound = boundSide(query, std::pmr::get_default_resource());
+    std::pmr::vector<std::uint64_t> hashes;
+    if (fingerprint_weight > 0.0) {
+        hashes = fingerprinter.hashSet(query.tokens);
+    }
+    Span<std::uint64_t> query_fingerprints = hashes;
+
+    BlockTable table;
+    PairInputs inputs;
+    inputs.bound1 = &bound;
+    inputs.fingerprints1 = &query_fingerprints;
+    inputs.table = &table;
+    for (std::size_t first = 0; first < candidates.size(); first += kBatchChunk) {
+        std::size_t last = std::min(candidates.size(), first + kBatchChunk);
+        table.clear();
+        for (std::size_t k = first; k < last; k++) {
+            table.add(*candidates[k]);
+        }
+        for (std::size_t k = first; k < last; k++) {
+            inputs.fingerprints2 = fingerprints.empty() ? nullptr : &fingerprints[k];
+            inputs.entry = k - first;
+            Score score;
+            if (scorePair(query, *candidates[k], threshold, inputs, score)) {
+                callback(k, score);
+            }
+        }
+    }
+}
+
+bool Scorer::scorePair(const CFGBuilder::CFG& cfg1, const CFGBuilder::CFG& cfg2, double threshold,
+                       const PairInputs& inputs, Score& result) {
+    METRIC_TIME(Score);
+    METRIC_COUNT(PairsScored, 1);
     result.structural = 0.0;
     result.semantic = 0.0;
+    result.fingerprint = 0.0;
     result.overall = 0.0;
     result.matched_blocks = 0;
     result.total_blocks = std::max(cfg1.blocks.size(), cfg2.blocks.size());
@@ -15,45 +201,225 @@ Scorer::Score Scorer::calculate(const CFGBuilder::CFG& cfg1, const CFGBuilder::C
     if (cfg1.blocks.empty() && cfg2.blocks.empty()) {
         result.structural = 1.0;
         result.semantic = 1.0;
+        result.fingerprint = 1.0;
         result.overall = 1.0;
-        return result;
+        return true;
     }
 
     if (cfg1.blocks.empty() || cfg2.blocks.empty()) {
         result.structural = 0.0;
         result.semantic = 0.0;
         result.overall = 0.0;
-        return result;
+        return result.overall >= threshold;
+    }
+
+    // Everything the previous pair allocated goes at once
+    if (arena) {
+        arena->reset();
+    }
+    std::pmr::memory_resource* memory = arena ? static_cast<std::pmr::memory_resource*>(arena)
+                                              : std::pmr::get_default_resource();
+
+    // Give up as soon as the best the rest could add falls short; the
+    // bound the pair missed by is left in `overall`
+    bool bounded = threshold > 0.0;
+    auto abandon = [&](double bound) {
+        if (bound + kBoundSlack >= threshold) {
+            return false;
+        }
+        METRIC_COUNT(PairsAbandoned, 1);
+        result.overall = bound;
+        return true;
+    };
+
+    // Best case before matching: every matchable block matched and every
+    // edge preserved, for any number of matches the bound allows
+    PairingBound pairing;
+    if (bounded) {
+        BoundSide side2 = boundSide(cfg2, memory);
+        pairing = inputs.bound1 ? pairingBound(*inputs.bound1, side2)
+                                : pairingBound(boundSide(cfg1, memory), side2);
+        double best = 0.0;
+        for (int matched = 0; matched <= pairing.blocks; matched++) {
+            double structural = matched > 0
+                                    ? kNodeWeight * matched / result.total_blocks + kEdgeWeight
+                                    : 0.0;
+            best = std::max(best, structural_weight * structural +
+                                      semantic_weight * semanticBound(matched, result.total_blocks, pairing));
+        }
+        if (abandon(best + fingerprint_weight)) {
+            return false;
+        }
     }
 
     // Calculate structural similarity
-    MatchResult structural_result = matcher.compare(cfg1, cfg2);
+    MatchResult structural_result = inputs.table ? matcher.compare(cfg1, cfg2, *inputs.table, inputs.entry)
+                                                 : matcher.compare(cfg1, cfg2);
     result.structural = structural_result.similarity;
     result.matched_blocks = structural_result.matched_nodes;
 
+    if (bounded && abandon(structural_weight * result.structural +
+                           semantic_weight * semanticBound(result.matched_blocks, result.total_blocks, pairing) +
+                           fingerprint_weight)) {
+        return false;
+    }
+
     // Calculate semantic similarity for matched blocks
     result.semantic = calculateSemanticSimilarity(cfg1, cfg2, structural_result.node_matches);
 
+    if (bounded && abandon(structural_weight * result.structural + semantic_weight * result.semantic +
+                           fingerprint_weight)) {
+        return false;
+    }
+
+    // Shared token runs, independent of how blocks were split or ordered;
+    // hashed only when they count towards the score or are asked for
+    if (fingerprint_weight > 0.0 || inputs.report_fingerprint) {
+        METRIC_TIME(Fingerprint);
+        std::pmr::vector<std::uint64_t> hashes1(memory), hashes2(memory);
+        if (!inputs.fingerprints1) {
+            hashes1 = fingerprinter.hashSet(cfg1.tokens, memory);
+        }
+        if (!inputs.fingerprints2) {
+            hashes2 = fingerprinter.hashSet(cfg2.tokens, memory);
+        }
+        result.fingerprint = Fingerprinter::overlap(inputs.fingerprints1 ? *inputs.fingerprints1 : hashes1,
+                                                    inputs.fingerprints2 ? *inputs.fingerprints2 : hashes2);
+    }
+
     // Calculate overall similarity using weighted combination
-    result.overall = structural_weight * result.structural + semantic_weight * result.semantic;
+    result.overall = structural_weight * result.structural + semantic_weight * result.semantic +
+                     fingerprint_weight * result.fingerprint;
 
     // Ensure score is between 0 and 1
     result.overall = std::max(0.0, std::min(1.0, result.overall));
 
+    return result.overall >= threshold;
+}
+
+Scorer::FunctionScore Scorer::calculateFunctions(const std::vector<CFGBuilder::FunctionCFG>& functions1,
+                                                 const std::vector<CFGBuilder::FunctionCFG>& functions2) {
+    FunctionScore result;
+    result.rows = static_cast<int>(functions1.size());
+    result.cols = static_cast<int>(functions2.size());
+    result.score = {0.0, 0.0, 0.0, 0.0, 0, 0};
+
+    if (functions1.empty() && functions2.empty()) {
+        result.score = {1.0, 1.0, 1.0, 1.0, 0, 0};
+        return result;
+    }
+
+    double total_tokens = 0.0;
+    int blocks1 = 0, blocks2 = 0;
+    for (const auto& function : functions1) {
+        total_tokens += function.token_count;
+        blocks1 += static_cast<int>(function.cfg.blocks.size());
+    }
+    for (const auto& function : functions2) {
+        total_tokens += function.token_count;
+        blocks2 += static_cast<int>(function.cfg.blocks.size());
+    }
+    result.score.total_blocks = std::max(blocks1, blocks2);
+    if (functions1.empty() || functions2.empty() || total_tokens == 0.0) {
+        return result;
+    }
+
+    // Each function keeps its closest candidates on the other side by WL
+    // cosine; only pairs one of the two kept go through calculate()
+    std::vector<char> screened(functions1.size() * functions2.size(), 1);
+    if (function_candidates > 0 &&
+        (result.cols > function_candidates || result.rows > function_candidates)) {
+        std::vector<WLVector> vectors1, vectors2;
+        for (const auto& function : functions1) {
+            vectors1.push_back(kernel.vectorize(function.cfg));
+        }
+        for (const auto& function : functions2) {
+            vectors2.push_back(kernel.vectorize(function.cfg));
+        }
+        std::vector<double> cosines(screened.size());
+        for (int i = 0; i < result.rows; i++) {
+            for (int j = 0; j < result.cols; j++) {
+                cosines[i * result.cols + j] = WLKernel::cosine(vectors1[i], vectors2[j]);
+            }
+        }
+        std::fill(screened.begin(), screened.end(), 0);
+        std::vector<int> order;
+        auto keep = [&](int count, auto cellOf) {
+            order.resize(count);
+            for (int k = 0; k < count; k++) {
+                order[k] = k;
+            }
+            int kept = std::min(count, function_candidates);
+            std::partial_sort(order.begin(), order.begin() + kept, order.end(), [&](int x, int y) {
+                return cosines[cellOf(x)] > cosines[cellOf(y)];
+            });
+            for (int k = 0; k < kept; k++) {
+                screened[cellOf(order[k])] = 1;
+            }
+        };
+        for (int i = 0; i < result.rows; i++) {
+            keep(result.cols, [&](int j) { return i * result.cols + j; });
+        }
+        for (int j = 0; j < result.cols; j++) {
+            keep(result.rows, [&](int i) { return i * result.cols + j; });
+        }
+    }
+
+    // Rows are independent of each other
+    std::vector<Score> scores(functions1.size() * functions2.size(), Score{0.0, 0.0, 0.0, 0.0, 0, 0});
+    std::vector<AssignmentEdge> edges;
+    result.matrix.resize(scores.size());
+    for (int i = 0; i < result.rows; i++) {
+        for (int j = 0; j < result.cols; j++) {
+            if (!screened[i * result.cols + j]) {
+                continue;
+            }
+            Score& pair = scores[i * result.cols + j];
+            pair = calculate(functions1[i].cfg, functions2[j].cfg);
+            result.matrix[i * result.cols + j] = pair.overall;
+            if (pair.overall > 0.0) {
+                double size = functions1[i].token_count + functions2[j].token_count;
+                edges.push_back({i, j, pair.overall * size});
+            }
+        }
+    }
+
+    for (const auto& match : AssignmentSolver::solve(result.rows, result.cols, edges)) {
+        const Score& pair = scores[match.first * result.cols + match.second];
+        double share = (functions1[match.first].token_count + functions2[match.second].token_count) / total_tokens;
+        result.score.structural += share * pair.structural;
+        result.score.semantic += share * pair.semantic;
+        result.score.fingerprint += share * pair.fingerprint;
+        result.score.overall += share * pair.overall;
+        result.score.matched_blocks += pair.matched_blocks;
+        result.matches.push_back({match.first, match.second, pair.overall});
+    }
+    result.score.overall = std::max(0.0, std::min(1.0, result.score.overall));
     return result;
 }
 
-void Scorer::setWeights(double structural_w, double semantic_w) {
+void Scorer::setFunctionScreening(int candidates) {
+    function_candidates = std::max(0, candidates);
+}
+
+void Scorer::setArena(Arena* scratch) {
+    arena = scratch;
+    matcher.setArena(scratch);
+}
+
+void Scorer::setWeights(double structural_w, double semantic_w, double fingerprint_w) {
     // Normalize weights to sum to 1.0
-    double total = structural_w + semantic_w;
+    double total = structural_w + semantic_w + fingerprint_w;
     if (total > 0) {
         structural_weight = structural_w / total;
         semantic_weight = semantic_w / total;
+        fingerprint_weight = fingerprint_w / total;
     }
 }
 
 double Scorer::calculateSemanticSimilarity(const CFGBuilder::CFG& cfg1, const CFGBuilder::CFG& cfg2,
                                            const std::vector<std::pair<int, int>>& matches) {
+    METRIC_TIME(Semantic);
     if (matches.empty()) {
         return 0.0;
     }
@@ -77,5 +443,12 @@ double Scorer::calculateSemanticSimilarity(const CFGBuilder::CFG& cfg1, const CF
         }
     }
 
-    return valid_comparisons > 0 ? total_similarity / valid_comparisons : 0.0;
+    // Average over the matched blocks times their share of all blocks,
+    // as the structural node term counts them
+    std::size_t total_blocks = std::max(cfg1.blocks.size(), cfg2.blocks.size());
+    if (valid_comparisons == 0) {
+        return 0.0;
+    }
+    double coverage = static_cast<double>(valid_comparisons) / static_cast<double>(total_blocks);
+    return total_similarity / valid_comparisons * std::min(1.0, coverage);
 }
@@ -1,124 +1,198 @@
 #include "SemanticHasher.h"
+#include "Utils/Metrics.h"
+
+namespace {
+// Pattern codes for non-keyword tokens. Keywords use their own symbol id,
+// which is always below SymbolTable::kFirstVariable.
+enum PatternCode : std::uint32_t {
+    P_VAR = SymbolTable::kFirstVariable,
+    P_ADD,
+    P_SUB,
+    P_MUL,
+    P_DIV,
+    P_INC_DEC,
+    P_ASSIGN_OP,
+    P_COMP_OP,
+    P_LOGIC_OP,
+    P_BLOCK,
+    P_PAREN,
+    P_STMT_END,
+    P_LITERAL,
+    P_SYM,
+};
+
+// Operation classes; operations in the same class count as similar
+enum OperationClass : std::uint32_t {
+    OP_NONE = 0,
+    OP_CONTROL = SymbolTable::kFirstVariable,  // if, while, for
+    OP_RETURN,
+    OP_ARITH,    // + - * /, their compound assignments, ++ and --
+    OP_ASSIGN,   // =
+    OP_COMPARE,  // == != < > <= >=
+};
+
+const std::uint64_t kSeed = 0xcbf29ce484222325ULL;
+
+inline std::uint64_t mix(std::uint64_t hash, std::uint32_t code) {
+    hash ^= code + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    return hash * 0x100000001b3ULL;
+}
 
-#include <algorithm>
-#include <functional>
-#include <sstream>
+inline std::uint64_t finish(std::uint64_t hash) {
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+std::uint32_t patternCode(const Token& token) {
+    if (token.kind == TokenKind::Keyword) {
+        return token.symbol;
+    }
+    if (token.kind == TokenKind::Identifier) {
+        // All variables become VAR for semantic similarity
+        return P_VAR;
+    }
+    if (token.kind == TokenKind::Literal) {
+        return P_LITERAL;
+    }
+
+    switch (token.symbol) {
+        case Sym::Plus: return P_ADD;
+        case Sym::Minus: return P_SUB;
+        case Sym::Star: return P_MUL;
+        case Sym::Slash: return P_DIV;
+        case Sym::PlusPlus:
+        case Sym::MinusMinus:
+            return P_INC_DEC;
+        case Sym::Assign:
+        case Sym::PlusAssign:
+        case Sym::MinusAssign:
+        case Sym::StarAssign:
+        case Sym::SlashAssign:
+            return P_ASSIGN_OP;
+        case Sym::Equal:
+        case Sym::NotEqual:
+        case Sym::Less:
+        case Sym::Greater:
+        case Sym::LessEqual:
+        case Sym::GreaterEqual:
+            return P_COMP_OP;
+        case Sym::AndAnd:
+        case Sym::OrOr:
+        case Sym::Exclaim:
+            return P_LOGIC_OP;
+        case Sym::LBrace:
+        case Sym::RBrace:
+            return P_BLOCK;
+        case Sym::LParen:
+        case Sym::RParen:
+            return P_PAREN;
+        case Sym::Semi:
+            return P_STMT_END;
+        default:
+            // Other symbols
+            return P_SYM;
+    }
+}
+
+std::uint32_t operationClass(const Token& token) {
+    if (token.kind == TokenKind::Keyword) {
+        switch (token.symbol) {
+            case Sym::If:
+            case Sym::While:
+            case Sym::For:
+                return OP_CONTROL;
+            case Sym::Return:
+                return OP_RETURN;
+            default:
+                return token.symbol;
+        }
+    }
+    if (token.kind != TokenKind::Symbol) {
+        return OP_NONE;
+    }
+
+    switch (token.symbol) {
+        case Sym::Plus:
+        case Sym::PlusAssign:
+        case Sym::Minus:
+        case Sym::MinusAssign:
+        case Sym::Star:
+        case Sym::StarAssign:
+        case Sym::Slash:
+        case Sym::SlashAssign:
+        case Sym::PlusPlus:
+        case Sym::MinusMinus:
+            return OP_ARITH;
+        case Sym::Assign:
+            return OP_ASSIGN;
+        case Sym::Equal:
+        case Sym::NotEqual:
+        case Sym::Less:
+        case Sym::Greater:
+        case Sym::LessEqual:
+        case Sym::GreaterEqual:
+            return OP_COMPARE;
+        default:
+            return OP_NONE;
+    }
+}
+}  // namespace
 
 std::string SemanticHasher::hashBlock(const BasicBlock& block) {
-    if (block.tokens.empty()) {
+    if (block.token_count == 0) {
         return "EMPTY_BLOCK";
     }
-
-    std::string semantic_pattern = extractSemanticPattern(block.tokens);
-    return std::to_string(simpleHash(semantic_pattern));
+    return std::to_string(block.features.semantic_signature);
 }
 
 double SemanticHasher::compareBlocks(const BasicBlock& block1, const BasicBlock& block2) {
-    std::string hash1 = hashBlock(block1);
-    std::string hash2 = hashBlock(block2);
+    METRIC_COUNT(BlockComparisons, 1);
+    const BlockFeatures& f1 = block1.features;
+    const BlockFeatures& f2 = block2.features;
 
-    if (hash1 == hash2) {
+    if (f1.semantic_signature == f2.semantic_signature) {
         return 1.0;  // Identical semantic content
     }
 
-    // Extract operation patterns for more nuanced comparison
-    std::string op1 = normalizeOperation(block1.tokens);
-    std::string op2 = normalizeOperation(block2.tokens);
-
-    if (areOperationsSimilar(op1, op2)) {
+    if (f1.operation_signature != 0 && f1.operation_signature == f2.operation_signature) {
         return 0.8;  // Similar operations
     }
 
     return 0.0;  // Different semantic content
 }
 
-std::string SemanticHasher::extractSemanticPattern(const std::vector<Token>& tokens) {
-    std::stringstream pattern;
-
-    for (size_t i = 0; i < tokens.size(); i++) {
-        const Token& token = tokens[i];
-
-        if (token.type == "keyword") {
-            pattern << token.value << " ";
-        } else if (token.type == "identifier") {
-            // All variables become VAR for semantic similarity
-            pattern << "VAR ";
-        } else if (token.value == "+" || token.value == "-" || token.value == "*" ||
-                   token.value == "/") {
-            pattern << "ARITH_OP ";
-        } else if (token.value == "=" || token.value == "+=" || token.value == "-=" ||
-                   token.value == "*=" || token.value == "/=") {
-            pattern << "ASSIGN_OP ";
-        } else if (token.value == "==" || token.value == "!=" || token.value == "<" ||
-                   token.value == ">" || token.value == "<=" || token.value == ">=") {
-            pattern << "COMP_OP ";
-        } else if (token.value == "&&" || token.value == "||" || token.value == "!") {
-            pattern << "LOGIC_OP ";
-        } else if (token.value == "{" || token.value == "}") {
-            pattern << "BLOCK ";
-        } else if (token.value == "(" || token.value == ")") {
-            pattern << "PAREN ";
-        } else if (token.value == ";") {
-            pattern << "STMT_END ";
-        } else {
-            // Other symbols
-            pattern << "SYM ";
-        }
+std::uint64_t SemanticHasher::semanticSignature(TokenSpan tokens) {
+    std::uint64_t hash = kSeed;
+    for (const Token& token : tokens) {
+        hash = mix(hash, patternCode(token));
     }
 
-    return pattern.str();
+    hash = finish(hash);
+    return hash != 0 ? hash : 1;
 }
 
-std::string SemanticHasher::normalizeOperation(const std::vector<Token>& tokens) {
-    std::stringstream operation;
+std::uint64_t SemanticHasher::operationSignature(TokenSpan tokens) {
+    std::uint64_t hash = kSeed;
+    bool has_operation = false;
 
     for (const Token& token : tokens) {
-        if (token.type == "keyword") {
-            if (token.value == "if")
-                operation << "CONDITIONAL ";
-            else if (token.value == "while" || token.value == "for")
-                operation << "LOOP ";
-            else if (token.value == "return")
-                operation << "RETURN ";
-            else
-                operation << token.value << " ";
-        } else if (token.value == "+" || token.value == "+=") {
-            operation << "ADD ";
-        } else if (token.value == "-" || token.value == "-=") {
-            operation << "SUB ";
-        } else if (token.value == "*" || token.value == "*=") {
-            operation << "MUL ";
-        } else if (token.value == "/" || token.value == "/=") {
-            operation << "DIV ";
-        } else if (token.value == "=") {
-            operation << "ASSIGN ";
-        } else if (token.value == "==" || token.value == "!=") {
-            operation << "EQUALITY ";
-        } else if (token.value == "<" || token.value == ">" || token.value == "<=" ||
-                   token.value == ">=") {
-            operation << "COMPARISON ";
+        std::uint32_t op = operationClass(token);
+        if (op != OP_NONE) {
+            hash = mix(hash, op);
+            has_operation = true;
         }
     }
 
-    return operation.str();
-}
-
-bool SemanticHasher::areOperationsSimilar(const std::string& op1, const std::string& op2) {
-    // Define groups of similar operations
-    static const std::unordered_set<std::string> arithmetic = {"ADD", "SUB", "MUL", "DIV"};
-    static const std::unordered_set<std::string> comparison = {"EQUALITY", "COMPARISON"};
-    static const std::unordered_set<std::string> control = {"CONDITIONAL", "LOOP"};
-
-    // Check if both operations belong to the same category
-    if ((arithmetic.count(op1) && arithmetic.count(op2)) ||
-        (comparison.count(op1) && comparison.count(op2)) ||
-        (control.count(op1) && control.count(op2))) {
-        return true;
+    if (!has_operation) {
+        return 0;
     }
-
-    return false;
+    hash = finish(hash);
+    return hash != 0 ? hash : 1;
 }
 
-std::size_t SemanticHasher::simpleHash(const std::string& str) {
-    return std::hash<std::string>{}(str);
+void SemanticHasher::signBlock(BasicBlock& block, TokenSpan tokens) {
+    block.features.semantic_signature = semanticSignature(tokens);
+    block.features.operation_signature = operationSignature(tokens);
 }
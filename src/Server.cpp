@@ -0,0 +1,423 @@
+#include "Server.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "Normalizer.h"
+#include "Utils/Metrics.h"
+#include "Utils/SourceFile.h"
+#include "Utils/StringUtils.h"
+
+namespace {
+// Longest the connection loop sleeps before it looks at the stop flag
+const int kPollMillis = 200;
+
+std::string failure(const std::string& message) {
+    return "{\"ok\":false,\"error\":" + Json::quote(message) + "}";
+}
+
+std::string scoreFields(const Scorer::Score& score) {
+    return "\"overall\":" + Json::number(score.overall) + ",\"structural\":" + Json::number(score.structural) +
+           ",\"semantic\":" + Json::number(score.semantic) + ",\"fingerprint\":" +
+           Json::number(score.fingerprint);
+}
+
+bool sendAll(int fd, const std::string& data) {
+    std::size_t sent = 0;
+    while (sent < data.size()) {
+#ifdef MSG_NOSIGNAL
+        ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+#else
+        ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, 0);
+#endif
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        sent += static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+// A numeric member, or `fallback` when it is absent or not a number
+double numberOr(const Json::Object& request, const char* name, double fallback) {
+    auto it = request.find(name);
+    if (it == request.end()) {
+        return fallback;
+    }
+    char* end = nullptr;
+    double value = std::strtod(it->second.c_str(), &end);
+    return *end == '\0' && end != it->second.c_str() ? value : fallback;
+}
+
+// Most results or screened entries a query may ask for; larger counts are
+// clamped, since no index comes near it
+const double kMaxCount = 1e9;
+
+std::size_t clampCount(double value) {
+    return static_cast<std::size_t>(std::min(kMaxCount, std::max(0.0, value)));
+}
+
+// The file or inline code of one side of a request, analyzed once. Files
+// the index holds with the same content reuse the index's CFG; the caller
+// holds the index lock for as long as the CFG is used.
+class Source {
+   public:
+    bool load(const CorpusIndex& index, const Json::Object& request, const char* code_key,
+              const char* path_key, std::string& error) {
+        auto code = request.find(code_key);
+        auto path = request.find(path_key);
+        std::string_view text;
+        if (code != request.end()) {
+            text = code->second;
+        } else if (path != request.end()) {
+            if (!file.open(path->second)) {
+                error = "cannot read '" + path->second + "': " + file.error();
+                return false;
+            }
+            text = file.view();
+            int id = index.find(path->second);
+            if (id >= 0 && index.entry(id).content_hash == StringUtils::contentHash(text)) {
+                cfg = &index.entry(id).cfg;
+                return true;
+            }
+        } else {
+            error = std::string("missing \"") + code_key + "\" or \"" + path_key + "\"";
+            return false;
+        }
+
+        Normalizer normalizer;
+        CFGBuilder builder;
+        own = builder.build(normalizer.process(text));
+        cfg = &own;
+        return true;
+    }
+
+    const CFGBuilder::CFG& get() const { return *cfg; }
+
+   private:
+    SourceFile file;
+    CFGBuilder::CFG own;
+    const CFGBuilder::CFG* cfg = nullptr;
+};
+}  // namespace
+
+Server::Server(CorpusIndex& corpus_index, const ServerOptions& options)
+    : index(corpus_index), opts(options) {}
+
+Server::~Server() {
+    stop();
+    pool.reset();  // waits for the requests still being answered
+    for (int fd : wake_fds) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+    if (listen_fd >= 0) {
+        ::close(listen_fd);
+        if (!opts.socket_path.empty()) {
+            ::unlink(opts.socket_path.c_str());
+        }
+    }
+}
+
+bool Server::listen() {
+    if (!opts.socket_path.empty()) {
+        sockaddr_un address = {};
+        if (opts.socket_path.size() >= sizeof(address.sun_path)) {
+            error_message = "socket path too long";
+            return false;
+        }
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, opts.socket_path.c_str(), sizeof(address.sun_path) - 1);
+        listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        ::unlink(opts.socket_path.c_str());
+        if (listen_fd < 0 || ::bind(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            error_message = std::strerror(errno);
+            return false;
+        }
+    } else {
+        // Loopback only: the protocol has no authentication
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(static_cast<std::uint16_t>(opts.port));
+        listen_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        int reuse = 1;
+        if (listen_fd >= 0) {
+            ::setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        }
+        if (listen_fd < 0 || ::bind(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            error_message = std::strerror(errno);
+            return false;
+        }
+        socklen_t length = sizeof(address);
+        ::getsockname(listen_fd, reinterpret_cast<sockaddr*>(&address), &length);
+        bound_port = ntohs(address.sin_port);
+    }
+
+    if (::listen(listen_fd, 64) != 0 || ::pipe(wake_fds) != 0) {
+        error_message = std::strerror(errno);
+        return false;
+    }
+    for (int fd : wake_fds) {
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+    }
+    pool = std::make_unique<ThreadPool>(opts.threads);
+    return true;
+}
+
+void Server::run() {
+    std::vector<std::unique_ptr<Connection>> connections;
+    std::vector<pollfd> waiting;
+    while (!stopping) {
+        // Hung up or failed connections go once their replies are out
+        auto finished = [](const std::unique_ptr<Connection>& connection) {
+            if (connection->busy || !connection->closing) {
+                return false;
+            }
+            ::close(connection->fd);
+            return true;
+        };
+        connections.erase(std::remove_if(connections.begin(), connections.end(), finished), connections.end());
+
+        // Busy connections are left out (a negative fd is skipped), so a
+        // hangup is not reported again and again while a task runs
+        waiting.clear();
+        waiting.push_back({listen_fd, POLLIN, 0});
+        waiting.push_back({wake_fds[0], POLLIN, 0});
+        for (const auto& connection : connections) {
+            waiting.push_back({connection->busy ? -1 : connection->fd, POLLIN, 0});
+        }
+        if (::poll(waiting.data(), waiting.size(), kPollMillis) <= 0) {
+            continue;
+        }
+
+        if (waiting[1].revents) {
+            char drain[64];
+            while (::read(wake_fds[0], drain, sizeof(drain)) > 0) {
+            }
+        }
+        for (std::size_t k = 0; k < connections.size(); k++) {
+            if (waiting[k + 2].revents) {
+                receive(*connections[k]);
+            }
+        }
+        if (!(waiting[0].revents & POLLIN)) {
+            continue;
+        }
+        int fd = ::accept(listen_fd, nullptr, nullptr);
+        if (fd < 0) {
+            continue;
+        }
+#ifdef SO_NOSIGPIPE
+        int no_sigpipe = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &no_sigpipe, sizeof(no_sigpipe));
+#endif
+        connections.push_back(std::make_unique<Connection>());
+        connections.back()->fd = fd;
+    }
+
+    // Requests already handed out are answered before their connections
+    // close
+    pool->wait();
+    for (const auto& connection : connections) {
+        ::close(connection->fd);
+    }
+}
+
+void Server::stop() {
+    stopping = true;
+    wake();
+}
+
+void Server::wake() {
+    if (wake_fds[1] >= 0) {
+        char byte = 0;
+        ssize_t written = ::write(wake_fds[1], &byte, 1);
+        (void)written;  // a full pipe already wakes the loop
+    }
+}
+
+void Server::receive(Connection& connection) {
+    char chunk[65536];
+    ssize_t n = ::recv(connection.fd, chunk, sizeof(chunk), 0);
+    if (n < 0 && (errno == EINTR || errno == EAGAIN)) {
+        return;
+    }
+    if (n <= 0) {
+        connection.closing = true;
+        return;
+    }
+
+    // Only the new bytes can hold the end of the pending line
+    std::vector<std::string> lines;
+    std::size_t start = 0, newline, search = connection.buffer.size();
+    connection.buffer.append(chunk, static_cast<std::size_t>(n));
+    while ((newline = connection.buffer.find('\n', search)) != std::string::npos) {
+        std::string_view line(connection.buffer.data() + start, newline - start);
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        if (!line.empty()) {
+            lines.emplace_back(line);
+        }
+        start = search = newline + 1;
+    }
+    connection.buffer.erase(0, start);
+
+    bool too_long = connection.buffer.size() > opts.max_request;
+    if (lines.empty() && !too_long) {
+        return;
+    }
+    connection.busy = true;
+    pool->submit([this, &connection, lines = std::move(lines), too_long] { answer(connection, lines, too_long); });
+}
+
+void Server::answer(Connection& connection, const std::vector<std::string>& lines, bool too_long) {
+    bool open = true;
+    for (std::size_t k = 0; k < lines.size() && open; k++) {
+        open = sendAll(connection.fd, handle(lines[k]) + "\n");
+    }
+    if (open && too_long) {
+        sendAll(connection.fd, failure("request too long") + "\n");
+    }
+    if (!open || too_long) {
+        connection.closing = true;
+    }
+    connection.busy = false;
+    wake();
+}
+
+std::string Server::handle(std::string_view request) {
+    Json::Object fields;
+    std::string error;
+    if (!Json::parseObject(request, fields, error)) {
+        return failure("bad request: " + error);
+    }
+
+    const std::string op = fields.count("op") ? fields["op"] : "";
+    try {
+        if (op == "compare") {
+            return compare(fields);
+        }
+        if (op == "query") {
+            return query(fields);
+        }
+        if (op == "add") {
+            return add(fields);
+        }
+        if (op == "ping") {
+            std::shared_lock<std::shared_mutex> lock(index_mutex);
+            return "{\"ok\":true,\"entries\":" + std::to_string(index.size()) + "}";
+        }
+        if (op == "metrics") {
+            if (fields.count("format") && fields["format"] == "prometheus") {
+                return "{\"ok\":true,\"text\":" + Json::quote(Metrics::prometheus()) + "}";
+            }
+            return "{\"ok\":true,\"metrics\":" + Metrics::json() + "}";
+        }
+        if (op == "shutdown") {
+            stop();
+            return "{\"ok\":true}";
+        }
+    } catch (const std::exception& e) {
+        return failure(e.what());
+    }
+    return failure("unknown op '" + op + "'");
+}
+
+std::string Server::compare(const Json::Object& request) {
+    std::shared_lock<std::shared_mutex> lock(index_mutex);
+    Source source1, source2;
+    std::string error;
+    if (!source1.load(index, request, "code1", "path1", error) ||
+        !source2.load(index, request, "code2", "path2", error)) {
+        return failure(error);
+    }
+
+    Scorer scorer;
+    Scorer::Score score = scorer.calculate(source1.get(), source2.get());
+    return "{\"ok\":true," + scoreFields(score) + ",\"matched_blocks\":" + std::to_string(score.matched_blocks) +
+           ",\"total_blocks\":" + std::to_string(score.total_blocks) + "}";
+}
+
+std::string Server::query(const Json::Object& request) {
+    std::shared_lock<std::shared_mutex> lock(index_mutex);
+    Source source;
+    std::string error;
+    if (!source.load(index, request, "code", "path", error)) {
+        return failure(error);
+    }
+
+    QueryOptions options;
+    double top = numberOr(request, "top", 10.0);
+    double screen = numberOr(request, "screen", 200.0);
+    double min_score = numberOr(request, "min_score", options.min_score);
+    if (!std::isfinite(top) || !std::isfinite(screen) || !std::isfinite(min_score)) {
+        return failure("\"top\", \"screen\" and \"min_score\" must be finite");
+    }
+    options.top_k = clampCount(top);
+    options.screened = clampCount(screen);
+    options.min_score = min_score;
+
+    QueryStats stats;
+    auto neighbors = index.query(source.get(), options, &stats);
+
+    std::ostringstream reply;
+    reply << "{\"ok\":true,\"entries\":" << stats.entries << ",\"scored\":" << stats.scored << ",\"results\":[";
+    for (std::size_t k = 0; k < neighbors.size(); k++) {
+        reply << (k ? "," : "") << "{\"path\":" << Json::quote(index.entry(neighbors[k].entry).path) << ","
+              << scoreFields(neighbors[k].score) << "}";
+    }
+    reply << "]}";
+    return reply.str();
+}
+
+std::string Server::add(const Json::Object& request) {
+    auto path = request.find("path");
+    if (path == request.end()) {
+        return failure("missing \"path\"");
+    }
+
+    // Analyze outside the lock; only the insertion excludes other requests
+    SourceFile file;
+    std::string_view code;
+    auto inline_code = request.find("code");
+    if (inline_code != request.end()) {
+        code = inline_code->second;
+    } else if (file.open(path->second)) {
+        code = file.view();
+    } else {
+        return failure("cannot read '" + path->second + "': " + file.error());
+    }
+
+    if (code.empty()) {
+        return failure("empty file");
+    }
+    Normalizer normalizer;
+    CFGBuilder builder;
+    CorpusEntry entry;
+    entry.path = path->second;
+    entry.content_hash = StringUtils::contentHash(code);
+    entry.cfg = builder.build(normalizer.process(code));
+
+    std::unique_lock<std::shared_mutex> lock(index_mutex);
+    int id = index.add(std::move(entry));
+    return "{\"ok\":true,\"id\":" + std::to_string(id) + ",\"entries\":" + std::to_string(index.size()) + "}";
+}
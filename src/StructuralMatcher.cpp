@@ -1,10 +1,56 @@
 #include "StructuralMatcher.h"
+#include "HistogramKernel.h"
+#include "Utils/Metrics.h"
 #include <algorithm>
 #include <cmath>
-#include <unordered_set>
-#include <map>
+
+BlockTable::BlockTable(std::pmr::memory_resource* memory)
+    : control_flow(memory), token_count(memory), block(memory), histograms(memory), offsets(1, 0, memory) {}
+
+void BlockTable::add(const CFGBuilder::CFG& cfg) {
+    std::size_t first = control_flow.size();
+    for (size_t j = 0; j < cfg.blocks.size(); j++) {
+        // Empty blocks never match
+        if (cfg.blocks[j].features.token_count > 0) {
+            block.push_back(static_cast<int>(j));
+        }
+    }
+    auto order = block.begin() + first;
+    std::sort(order, block.end(), [&](int a, int b) {
+        const BlockFeatures& x = cfg.blocks[a].features;
+        const BlockFeatures& y = cfg.blocks[b].features;
+        if (x.control_flow != y.control_flow) return x.control_flow < y.control_flow;
+        if (x.token_count != y.token_count) return x.token_count < y.token_count;
+        return a < b;
+    });
+
+    histograms.resize(block.size() * kHistogramBins);
+    for (std::size_t row = first; row < block.size(); row++) {
+        const BlockFeatures& features = cfg.blocks[block[row]].features;
+        control_flow.push_back(features.control_flow);
+        token_count.push_back(features.token_count);
+        std::copy(features.histogram.begin(), features.histogram.end(), histograms.begin() + row * kHistogramBins);
+    }
+    offsets.push_back(block.size());
+}
+
+void BlockTable::clear() {
+    control_flow.clear();
+    token_count.clear();
+    block.clear();
+    histograms.clear();
+    offsets.resize(1);
+}
 
 MatchResult StructuralMatcher::compare(const CFGBuilder::CFG& cfg1, const CFGBuilder::CFG& cfg2) {
+    BlockTable table(scratch);
+    table.add(cfg2);
+    return compare(cfg1, cfg2, table, 0);
+}
+
+MatchResult StructuralMatcher::compare(const CFGBuilder::CFG& cfg1, const CFGBuilder::CFG& cfg2,
+                                       const BlockTable& table, std::size_t entry) {
+    METRIC_TIME(Match);
     MatchResult result;
     result.similarity = 0.0;
     result.matched_nodes = 0;
@@ -21,8 +67,15 @@ MatchResult StructuralMatcher::compare(const CFGBuilder::CFG& cfg1, const CFGBui
     }
     
     // Find node matches
-    result.node_matches = findNodeMatches(cfg1, cfg2);
+    result.node_matches = findNodeMatches(cfg1, cfg2, table, entry);
     result.matched_nodes = result.node_matches.size();
+    if (!cfg1.spans.empty() && !cfg2.spans.empty()) {
+        result.match_sources.reserve(result.node_matches.size());
+        for (const auto& match : result.node_matches) {
+            result.match_sources.emplace_back(cfg1.sourceOf(cfg1.blocks[match.first]),
+                                              cfg2.sourceOf(cfg2.blocks[match.second]));
+        }
+    }
     
     // Calculate structural similarity
     double node_similarity = static_cast<double>(result.matched_nodes) / result.total_nodes;
@@ -36,98 +89,95 @@ MatchResult StructuralMatcher::compare(const CFGBuilder::CFG& cfg1, const CFGBui
     return result;
 }
 
-std::vector<std::pair<int, int>> StructuralMatcher::findNodeMatches(const CFGBuilder::CFG& cfg1, const CFGBuilder::CFG& cfg2) {
-    std::vector<std::pair<int, int>> matches;
-    std::vector<bool> used_cfg2(cfg2.blocks.size(), false);
+void StructuralMatcher::setAssignment(AssignmentSolver::Algorithm algo, const AssignmentBudget& limits) {
+    algorithm = algo;
+    budget = limits;
+}
+
+void StructuralMatcher::setArena(std::pmr::memory_resource* memory) {
+    scratch = memory ? memory : std::pmr::get_default_resource();
+}
+
+std::vector<std::pair<int, int>> StructuralMatcher::findNodeMatches(const CFGBuilder::CFG& cfg1,
+                                                                    const CFGBuilder::CFG& cfg2,
+                                                                    const BlockTable& table, std::size_t entry) {
+    std::pmr::vector<AssignmentEdge> candidates = findCandidates(cfg1, cfg2, table, entry);
     
+    return AssignmentSolver::solve(static_cast<int>(cfg1.blocks.size()), static_cast<int>(cfg2.blocks.size()),
+                                   candidates, algorithm, budget, scratch);
+}
+
+std::pmr::vector<AssignmentEdge> StructuralMatcher::findCandidates(const CFGBuilder::CFG& cfg1,
+                                                                   const CFGBuilder::CFG& cfg2,
+                                                                   const BlockTable& table, std::size_t entry) {
+    // Blocks only match with identical control flow, and the weighted Jaccard
+    // is bounded by min(|a|, |b|) / max(|a|, |b|), so sizes must be within a
+    // factor of two. The table holds cfg2 by control flow, then size, so
+    // everything else is skipped without scoring it.
+    const std::size_t begin = table.offsets[entry];
+    const std::size_t end = table.offsets[entry + 1];
+    const std::uint32_t* control_flow = table.control_flow.data();
+    const std::uint32_t* sizes = table.token_count.data();
+    
+    // Many blocks are interchangeable ("}", "return VAR ;"), so ties are
+    // broken towards pairs at the same relative position; that keeps
+    // successor edges aligned without outweighing any real difference in
+    // similarity
+    const double kPositionBonus = 0.01;
+    const double scale1 = 1.0 / cfg1.blocks.size();
+    const double scale2 = 1.0 / cfg2.blocks.size();
+    
+    std::pmr::vector<AssignmentEdge> candidates(scratch);
+    std::pmr::vector<std::uint32_t> shared(scratch);
     for (size_t i = 0; i < cfg1.blocks.size(); i++) {
-        int best_match = -1;
-        double best_similarity = 0.0;
+        const BlockFeatures& features = cfg1.blocks[i].features;
+        if (features.token_count == 0) continue;
         
-        for (size_t j = 0; j < cfg2.blocks.size(); j++) {
-            if (used_cfg2[j]) continue;
-            
-            double similarity = calculateBlockSimilarity(cfg1.blocks[i], cfg2.blocks[j]);
-            if (similarity > best_similarity && similarity > 0.5) { // Threshold for matching
-                best_similarity = similarity;
-                best_match = j;
+        // Same control flow, sizes strictly between |a| / 2 and 2 |a|
+        std::uint32_t low = features.token_count / 2 + 1;
+        std::uint32_t high = 2 * features.token_count;
+        // First row at or past (control flow, low)
+        std::size_t row = begin;
+        for (std::size_t count = end - begin; count > 0;) {
+            std::size_t half = count / 2;
+            std::size_t middle = row + half;
+            if (control_flow[middle] < features.control_flow ||
+                (control_flow[middle] == features.control_flow && sizes[middle] < low)) {
+                row = middle + 1;
+                count -= half + 1;
+            } else {
+                count = half;
             }
         }
         
-        if (best_match != -1) {
-            matches.push_back({static_cast<int>(i), best_match});
-            used_cfg2[best_match] = true;
-        }
-    }
-    
-    return matches;
-}
-
-double StructuralMatcher::calculateBlockSimilarity(const BasicBlock& block1, const BasicBlock& block2) {
-    // Check control flow similarity
-    if (!controlFlowMatches(block1, block2)) {
-        return 0.0;
-    }
-    
-    // Count similar token types
-    std::map<std::string, int> types1, types2;
-    
-    for (const Token& token : block1.tokens) {
-        if (token.type == "keyword" || token.type == "symbol") {
-            types1[token.value]++;
-        } else if (token.type == "identifier") {
-            types1["VAR"]++;
+        std::size_t last = row;
+        while (last < end && control_flow[last] == features.control_flow && sizes[last] < high) {
+            last++;
         }
-    }
-    
-    for (const Token& token : block2.tokens) {
-        if (token.type == "keyword" || token.type == "symbol") {
-            types2[token.value]++;
-        } else if (token.type == "identifier") {
-            types2["VAR"]++;
+        if (last == row) continue;
+        
+        // Shared tokens with the whole run of rows at once
+        shared.resize(last - row);
+        HistogramKernel::intersections(features.histogram.data(), table.histogram(row), last - row, shared.data());
+        for (std::size_t k = row; k < last; k++) {
+            double similarity = weightedJaccard(shared[k - row], features.token_count, sizes[k]);
+            if (similarity > kMatchThreshold) {
+                int j = table.block[k];
+                double offset = std::fabs(i * scale1 - j * scale2);
+                candidates.push_back({static_cast<int>(i), j, similarity + kPositionBonus * (1.0 - offset)});
+            }
         }
     }
     
-    // Calculate Jaccard similarity
-    std::unordered_set<std::string> all_types;
-    for (const auto& pair : types1) all_types.insert(pair.first);
-    for (const auto& pair : types2) all_types.insert(pair.first);
-    
-    int intersection = 0;
-    for (const std::string& type : all_types) {
-        intersection += std::min(types1[type], types2[type]);
-    }
-    
-    int union_size = 0;
-    for (const std::string& type : all_types) {
-        union_size += std::max(types1[type], types2[type]);
-    }
-    
-    return union_size > 0 ? static_cast<double>(intersection) / union_size : 0.0;
+    METRIC_COUNT(BlockCandidates, candidates.size());
+    return candidates;
 }
 
-bool StructuralMatcher::controlFlowMatches(const BasicBlock& block1, const BasicBlock& block2) {
-    // Check if both blocks have similar control flow keywords
-    std::unordered_set<std::string> control1, control2;
-    
-    for (const Token& token : block1.tokens) {
-        if (token.type == "keyword" && 
-            (token.value == "if" || token.value == "else" || token.value == "while" || 
-             token.value == "for" || token.value == "return")) {
-            control1.insert(token.value);
-        }
-    }
+double StructuralMatcher::weightedJaccard(std::uint32_t intersection, std::uint32_t size1, std::uint32_t size2) {
+    // sum(min) / sum(max), where sum(max) = |a| + |b| - sum(min)
+    std::uint32_t union_size = size1 + size2 - intersection;
     
-    for (const Token& token : block2.tokens) {
-        if (token.type == "keyword" && 
-            (token.value == "if" || token.value == "else" || token.value == "while" || 
-             token.value == "for" || token.value == "return")) {
-            control2.insert(token.value);
-        }
-    }
-    
-    // Both should have same control flow type or both should have none
-    return control1 == control2;
+    return union_size > 0 ? static_cast<double>(intersection) / union_size : 0.0;
 }
 
 double StructuralMatcher::calculateEdgeSimilarity(const CFGBuilder::CFG& cfg1, const CFGBuilder::CFG& cfg2, 
@@ -137,37 +187,27 @@ double StructuralMatcher::calculateEdgeSimilarity(const CFGBuilder::CFG& cfg1, c
     int matching_edges = 0;
     int total_edges = 0;
     
-    // Create mapping from cfg1 block indices to cfg2 block indices
-    std::map<int, int> block_mapping;
+    // Block ids are indices, so the mapping from cfg1 blocks to their
+    // cfg2 partners is a plain array
+    std::pmr::vector<int> block_mapping(cfg1.blocks.size(), -1, scratch);
     for (const auto& match : node_matches) {
         block_mapping[match.first] = match.second;
     }
     
     // Check edge preservation
     for (const auto& match : node_matches) {
-        int block1_idx = match.first;
-        int block2_idx = match.second;
-        
-        const BasicBlock& block1 = cfg1.blocks[block1_idx];
-        const BasicBlock& block2 = cfg2.blocks[block2_idx];
+        const BasicBlock& block1 = cfg1.blocks[match.first];
+        const BasicBlock& block2 = cfg2.blocks[match.second];
+        Span<int> successors2 = cfg2.successorsOf(block2);
         
-        total_edges += block1.successors.size();
+        total_edges += block1.edge_count;
         
-        for (int successor1 : block1.successors) {
-            // Find if this successor is also matched
-            for (const auto& succ_match : node_matches) {
-                if (succ_match.first == successor1) {
-                    int mapped_successor = succ_match.second;
-                    
-                    // Check if block2 has this successor
-                    for (int successor2 : block2.successors) {
-                        if (successor2 == mapped_successor) {
-                            matching_edges++;
-                            break;
-                        }
-                    }
-                    break;
-                }
+        for (int successor1 : cfg1.successorsOf(block1)) {
+            // The successor must be matched, and block2 must have its partner
+            int mapped_successor = block_mapping[successor1];
+            if (mapped_successor >= 0 &&
+                std::find(successors2.begin(), successors2.end(), mapped_successor) != successors2.end()) {
+                matching_edges++;
             }
         }
     }
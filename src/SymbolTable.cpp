@@ -0,0 +1,62 @@
+#include "SymbolTable.h"
+
+#include <unordered_map>
+
+namespace {
+// Spellings indexed by predefined id; must follow the order of Sym
+const char* const kSpellings[Sym::PredefinedCount] = {
+    // Keywords
+    "int", "float", "double", "char", "if", "else", "while", "for", "return", "class", "void",
+    "public", "private", "const", "static", "struct", "bool", "true", "false", "switch", "case",
+    "default", "break", "continue", "do",
+
+    // Single-character punctuation
+    "!", "\"", "#", "$", "%", "&", "'", "(", ")", "*", "+", ",", "-", ".", "/", ":", ";", "<",
+    "=", ">", "?", "@", "[", "\\", "]", "^", "`", "{", "|", "}", "~",
+
+    // Multi-character operators
+    "+=", "-=", "*=", "/=", "%=", "&=", "|=", "^=", "==", "!=", "<=", ">=", "&&", "||", "++",
+    "--", "->", "::", "<<", ">>", "<<=", ">>=", "->*", ".*", "...",
+
+    // Literal placeholders
+    "STRING_LITERAL", "CHAR_LITERAL",
+
+    "UNKNOWN"};
+
+const std::unordered_map<std::string_view, SymbolId>& spellingIndex() {
+    static const std::unordered_map<std::string_view, SymbolId> index = [] {
+        std::unordered_map<std::string_view, SymbolId> map;
+        for (SymbolId id = 0; id < Sym::StringLiteral; id++) {
+            map.emplace(kSpellings[id], id);
+        }
+        return map;
+    }();
+    return index;
+}
+}  // namespace
+
+SymbolId SymbolTable::keyword(std::string_view word) {
+    auto it = spellingIndex().find(word);
+    if (it != spellingIndex().end() && isKeyword(it->second)) {
+        return it->second;
+    }
+    return kNoSymbol;
+}
+
+SymbolId SymbolTable::punctuation(std::string_view spelling) {
+    auto it = spellingIndex().find(spelling);
+    if (it != spellingIndex().end() && !isKeyword(it->second)) {
+        return it->second;
+    }
+    return kNoSymbol;
+}
+
+std::string SymbolTable::spelling(SymbolId id) {
+    if (id < Sym::PredefinedCount) {
+        return kSpellings[id];
+    }
+    if (isVariable(id)) {
+        return "VAR_" + std::to_string(id - kFirstVariable + 1);
+    }
+    return kSpellings[Sym::Unknown];
+}
@@ -0,0 +1,71 @@
+#include "Utils/Arena.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+namespace {
+// Chunk data starts after the header at this alignment
+const std::size_t kChunkAlignment = alignof(std::max_align_t);
+
+std::size_t headerSize() {
+    return (sizeof(void*) + sizeof(std::size_t) + kChunkAlignment - 1) & ~(kChunkAlignment - 1);
+}
+}  // namespace
+
+Arena::Arena(std::size_t initial_size) : next_size(std::max<std::size_t>(initial_size, 1024)) {}
+
+Arena::~Arena() { freeChunks(); }
+
+void Arena::addChunk(std::size_t min_size) {
+    std::size_t size = std::max(next_size, min_size);
+    char* memory = static_cast<char*>(::operator new(headerSize() + size));
+
+    Chunk* chunk = reinterpret_cast<Chunk*>(memory);
+    chunk->next = chunks;
+    chunk->size = size;
+    chunks = chunk;
+
+    cursor = memory + headerSize();
+    limit = cursor + size;
+    reserved += size;
+    next_size = size * 2;  // geometric growth keeps the chunk count logarithmic
+}
+
+void Arena::freeChunks() {
+    while (chunks) {
+        Chunk* next = chunks->next;
+        ::operator delete(chunks);
+        chunks = next;
+    }
+    cursor = limit = nullptr;
+    reserved = 0;
+}
+
+void Arena::reset() {
+    if (chunks && chunks->next) {
+        // Replace the chain by one chunk that fits the whole last round
+        std::size_t total = reserved;
+        freeChunks();
+        next_size = total;
+        addChunk(total);
+    } else if (chunks) {
+        cursor = reinterpret_cast<char*>(chunks) + headerSize();
+    }
+    allocated = 0;
+}
+
+void* Arena::do_allocate(std::size_t bytes, std::size_t alignment) {
+    std::uintptr_t position = reinterpret_cast<std::uintptr_t>(cursor);
+    std::uintptr_t aligned = (position + alignment - 1) & ~(static_cast<std::uintptr_t>(alignment) - 1);
+
+    if (!cursor || aligned + bytes > reinterpret_cast<std::uintptr_t>(limit)) {
+        addChunk(bytes + alignment);
+        position = reinterpret_cast<std::uintptr_t>(cursor);
+        aligned = (position + alignment - 1) & ~(static_cast<std::uintptr_t>(alignment) - 1);
+    }
+
+    cursor = reinterpret_cast<char*>(aligned + bytes);
+    allocated += bytes;
+    return reinterpret_cast<void*>(aligned);
+}
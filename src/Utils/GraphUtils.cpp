@@ -50,11 +50,25 @@ double GraphAlgorithms::calculateSimilarity(const std::vector<int>& graph1_struc
         return 0.0;
     }
 
-    double size_diff = std::abs(static_cast<int>(graph1_structure.size()) -
-                                static_cast<int>(graph2_structure.size()));
-    double max_size = std::max(graph1_structure.size(), graph2_structure.size());
-
-    return max_size > 0 ? 1.0 - (size_diff / max_size) : 0.0;
+    // Multiset Jaccard: shared labels over the labels of both graphs
+    std::vector<int> labels1 = graph1_structure;
+    std::vector<int> labels2 = graph2_structure;
+    std::sort(labels1.begin(), labels1.end());
+    std::sort(labels2.begin(), labels2.end());
+    std::size_t shared = 0;
+    for (std::size_t i = 0, j = 0; i < labels1.size() && j < labels2.size();) {
+        if (labels1[i] < labels2[j]) {
+            i++;
+        } else if (labels2[j] < labels1[i]) {
+            j++;
+        } else {
+            shared++;
+            i++;
+            j++;
+        }
+    }
+    double total = static_cast<double>(labels1.size() + labels2.size() - shared);
+    return static_cast<double>(shared) / total;
 }
 
 template <typename NodeType>
@@ -0,0 +1,253 @@
+#include "Utils/Json.h"
+
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+class Reader {
+   public:
+    Reader(std::string_view text, std::string& error) : text(text), error(error) {}
+
+    bool object(Json::Object& result) {
+        result.clear();
+        skipSpace();
+        if (!consume('{')) {
+            return fail("expected '{'");
+        }
+        skipSpace();
+        if (consume('}')) {
+            return end();
+        }
+        while (true) {
+            std::string name, value;
+            skipSpace();
+            if (!string(name)) {
+                return false;
+            }
+            skipSpace();
+            if (!consume(':')) {
+                return fail("expected ':'");
+            }
+            skipSpace();
+            if (!member(value)) {
+                return false;
+            }
+            result[name] = std::move(value);
+            skipSpace();
+            if (consume('}')) {
+                return end();
+            }
+            if (!consume(',')) {
+                return fail("expected ',' or '}'");
+            }
+        }
+    }
+
+   private:
+    std::string_view text;
+    std::string& error;
+    std::size_t at = 0;
+
+    bool fail(const char* message) {
+        error = std::string(message) + " at offset " + std::to_string(at);
+        return false;
+    }
+
+    void skipSpace() {
+        while (at < text.size() && (text[at] == ' ' || text[at] == '\t' || text[at] == '\n' || text[at] == '\r')) {
+            at++;
+        }
+    }
+
+    bool consume(char c) {
+        if (at < text.size() && text[at] == c) {
+            at++;
+            return true;
+        }
+        return false;
+    }
+
+    bool end() {
+        skipSpace();
+        return at == text.size() || fail("trailing characters");
+    }
+
+    bool member(std::string& value) {
+        if (at >= text.size()) {
+            return fail("missing value");
+        }
+        char c = text[at];
+        if (c == '"') {
+            return string(value);
+        }
+        if (c == '{' || c == '[') {
+            return fail("nested values are not supported");
+        }
+        for (const char* literal : {"true", "false", "null"}) {
+            std::string_view word(literal);
+            if (text.substr(at, word.size()) == word) {
+                value = literal;
+                at += word.size();
+                return true;
+            }
+        }
+        // Number: validated by strtod over the maximal run of number characters
+        std::size_t start = at;
+        while (at < text.size() && (std::isdigit(static_cast<unsigned char>(text[at])) || text[at] == '-' ||
+                                     text[at] == '+' || text[at] == '.' || text[at] == 'e' || text[at] == 'E')) {
+            at++;
+        }
+        value = std::string(text.substr(start, at - start));
+        char* parsed_end = nullptr;
+        if (value.empty() || (std::strtod(value.c_str(), &parsed_end), *parsed_end != '\0')) {
+            at = start;
+            return fail("invalid value");
+        }
+        return true;
+    }
+
+    bool hex4(std::uint32_t& code) {
+        if (at + 4 > text.size()) {
+            return fail("truncated \\u escape");
+        }
+        code = 0;
+        for (int i = 0; i < 4; i++) {
+            char c = text[at++];
+            code <<= 4;
+            if (c >= '0' && c <= '9') {
+                code |= c - '0';
+            } else if (c >= 'a' && c <= 'f') {
+                code |= c - 'a' + 10;
+            } else if (c >= 'A' && c <= 'F') {
+                code |= c - 'A' + 10;
+            } else {
+                return fail("invalid \\u escape");
+            }
+        }
+        return true;
+    }
+
+    static void appendUtf8(std::string& out, std::uint32_t code) {
+        if (code < 0x80) {
+            out += static_cast<char>(code);
+        } else if (code < 0x800) {
+            out += static_cast<char>(0xc0 | (code >> 6));
+            out += static_cast<char>(0x80 | (code & 0x3f));
+        } else if (code < 0x10000) {
+            out += static_cast<char>(0xe0 | (code >> 12));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+            out += static_cast<char>(0x80 | (code & 0x3f));
+        } else {
+            out += static_cast<char>(0xf0 | (code >> 18));
+            out += static_cast<char>(0x80 | ((code >> 12) & 0x3f));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+            out += static_cast<char>(0x80 | (code & 0x3f));
+        }
+    }
+
+    bool string(std::string& out) {
+        out.clear();
+        if (!consume('"')) {
+            return fail("expected string");
+        }
+        while (at < text.size()) {
+            char c = text[at++];
+            if (c == '"') {
+                return true;
+            }
+            if (static_cast<unsigned char>(c) < 0x20) {
+                return fail("control character in string");
+            }
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (at >= text.size()) {
+                break;
+            }
+            char escape = text[at++];
+            switch (escape) {
+                case '"': out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/': out += '/'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    std::uint32_t code = 0;
+                    if (!hex4(code)) {
+                        return false;
+                    }
+                    // A surrogate pair encodes one code point above 0xFFFF
+                    if (code >= 0xd800 && code < 0xdc00 && text.substr(at, 2) == "\\u") {
+                        at += 2;
+                        std::uint32_t low = 0;
+                        if (!hex4(low)) {
+                            return false;
+                        }
+                        if (low < 0xdc00 || low >= 0xe000) {
+                            return fail("invalid surrogate pair");
+                        }
+                        code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+                    }
+                    appendUtf8(out, code);
+                    break;
+                }
+                default:
+                    return fail("invalid escape");
+            }
+        }
+        return fail("unterminated string");
+    }
+};
+}  // namespace
+
+bool Json::parseObject(std::string_view text, Object& object, std::string& error) {
+    Reader reader(text, error);
+    return reader.object(object);
+}
+
+std::string Json::quote(std::string_view text) {
+    static const char* kHex = "0123456789abcdef";
+    std::string out;
+    out.reserve(text.size() + 2);
+    out += '"';
+    for (char c : text) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    out += "\\u00";
+                    out += kHex[(c >> 4) & 0xf];
+                    out += kHex[c & 0xf];
+                } else {
+                    out += c;
+                }
+        }
+    }
+    out += '"';
+    return out;
+}
+
+std::string Json::number(double value) {
+    if (!std::isfinite(value)) {
+        return "null";
+    }
+    char buffer[32];
+    for (int precision = 6; precision <= 17; precision++) {
+        std::snprintf(buffer, sizeof(buffer), "%.*g", precision, value);
+        if (std::strtod(buffer, nullptr) == value) {
+            break;
+        }
+    }
+    return buffer;
+}
@@ -0,0 +1,33 @@
+#include "Utils/LineIndex.h"
+
+#include <algorithm>
+#include <cstring>
+
+LineIndex::LineIndex(std::string_view text) {
+    starts.push_back(0);
+    const char* begin = text.data();
+    const char* end = begin + text.size();
+    for (const char* p = begin; p < end;) {
+        const void* newline = std::memchr(p, '\n', static_cast<std::size_t>(end - p));
+        if (!newline) {
+            break;
+        }
+        p = static_cast<const char*>(newline) + 1;
+        starts.push_back(static_cast<std::uint32_t>(p - begin));
+    }
+}
+
+std::uint32_t LineIndex::line(std::uint32_t offset) const {
+    if (starts.empty()) {
+        return 1;
+    }
+    // The last line start at or before offset
+    return static_cast<std::uint32_t>(std::upper_bound(starts.begin(), starts.end(), offset) - starts.begin());
+}
+
+std::uint32_t LineIndex::column(std::uint32_t offset) const {
+    if (starts.empty()) {
+        return offset + 1;
+    }
+    return offset - starts[line(offset) - 1] + 1;
+}
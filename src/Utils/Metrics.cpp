@@ -0,0 +1,314 @@
+#include "Utils/Metrics.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstddef>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <sstream>
+
+namespace {
+// Counters, then stage nanoseconds, then stage calls
+const int kSlots = Metrics::kCounterCount + 2 * Metrics::kStageCount;
+
+int stageSlot(Metrics::Stage stage) {
+    return Metrics::kCounterCount + stage;
+}
+
+int callSlot(Metrics::Stage stage) {
+    return Metrics::kCounterCount + Metrics::kStageCount + stage;
+}
+
+struct ThreadCounters;
+
+// Constant-initialized, so usable from any static constructor or
+// allocation, and never allocates itself
+struct Registry {
+    std::mutex mutex;
+    ThreadCounters* head = nullptr;
+    std::atomic<std::uint64_t> retired[kSlots] = {};  // threads that have exited
+    std::uint64_t baseline[kSlots] = {};              // totals at the last reset
+};
+
+Registry registry;
+
+// One thread's counters. Only the owner writes them, with plain relaxed
+// load/store pairs, so recording never contends; readers may see a value
+// one update behind.
+struct ThreadCounters {
+    std::atomic<std::uint64_t> values[kSlots] = {};
+    ThreadCounters* next = nullptr;
+    ThreadCounters* previous = nullptr;
+
+    ThreadCounters();
+    ~ThreadCounters();
+};
+
+// 0 = not constructed yet, 1 = live, 2 = destroyed; trivially initialized,
+// so it can be read at any point of the thread's life
+thread_local int counters_state = 0;
+thread_local ThreadCounters counters;
+
+ThreadCounters::ThreadCounters() {
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    next = registry.head;
+    if (next) {
+        next->previous = this;
+    }
+    registry.head = this;
+    counters_state = 1;
+}
+
+ThreadCounters::~ThreadCounters() {
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (int i = 0; i < kSlots; i++) {
+        registry.retired[i].fetch_add(values[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    if (previous) {
+        previous->next = next;
+    } else {
+        registry.head = next;
+    }
+    if (next) {
+        next->previous = previous;
+    }
+    counters_state = 2;
+}
+
+void add(int slot, std::uint64_t amount) {
+    if (counters_state == 2) {
+        // Allocations made while the thread's other destructors run
+        registry.retired[slot].fetch_add(amount, std::memory_order_relaxed);
+        return;
+    }
+    std::atomic<std::uint64_t>& value = counters.values[slot];
+    value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+void sum(std::uint64_t (&values)[kSlots]) {
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (int i = 0; i < kSlots; i++) {
+        values[i] = registry.retired[i].load(std::memory_order_relaxed);
+    }
+    for (ThreadCounters* thread = registry.head; thread; thread = thread->next) {
+        for (int i = 0; i < kSlots; i++) {
+            values[i] += thread->values[i].load(std::memory_order_relaxed);
+        }
+    }
+}
+
+std::string seconds(std::uint64_t nanoseconds) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.9f", nanoseconds / 1e9);
+    return buffer;
+}
+}  // namespace
+
+void Metrics::count(Counter counter, std::uint64_t amount) {
+    add(counter, amount);
+}
+
+void Metrics::time(Stage stage, std::uint64_t nanoseconds) {
+    add(stageSlot(stage), nanoseconds);
+    add(callSlot(stage), 1);
+}
+
+Metrics::Totals Metrics::totals() {
+    std::uint64_t values[kSlots];
+    sum(values);
+    Totals result;
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (int i = 0; i < kCounterCount; i++) {
+        result.counters[i] = values[i] - registry.baseline[i];
+    }
+    for (int s = 0; s < kStageCount; s++) {
+        Stage stage = static_cast<Stage>(s);
+        result.stage_nanoseconds[s] = values[stageSlot(stage)] - registry.baseline[stageSlot(stage)];
+        result.stage_calls[s] = values[callSlot(stage)] - registry.baseline[callSlot(stage)];
+    }
+    return result;
+}
+
+void Metrics::reset() {
+    // Threads keep their counters; later totals subtract what they were now
+    std::uint64_t values[kSlots];
+    sum(values);
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (int i = 0; i < kSlots; i++) {
+        registry.baseline[i] = values[i];
+    }
+}
+
+const char* Metrics::name(Stage stage) {
+    static const char* kNames[] = {"normalize", "build_cfg", "build_functions", "match",
+                                   "semantic",  "fingerprint", "score"};
+    return kNames[stage];
+}
+
+const char* Metrics::name(Counter counter) {
+    static const char* kNames[] = {"files",      "tokens",           "blocks",
+                                   "edges",      "functions",        "pairs_scored",
+                                   "pairs_abandoned", "block_candidates", "block_comparisons",
+                                   "allocations", "allocated_bytes"};
+    return kNames[counter];
+}
+
+std::string Metrics::json() {
+    Totals current = totals();
+    std::ostringstream out;
+    out << "{\"enabled\":" << (enabled() ? "true" : "false") << ",\"stages\":{";
+    for (int s = 0; s < kStageCount; s++) {
+        out << (s ? "," : "") << "\"" << name(static_cast<Stage>(s)) << "\":{\"seconds\":"
+            << seconds(current.stage_nanoseconds[s]) << ",\"calls\":" << current.stage_calls[s] << "}";
+    }
+    out << "},\"counters\":{";
+    for (int c = 0; c < kCounterCount; c++) {
+        out << (c ? "," : "") << "\"" << name(static_cast<Counter>(c)) << "\":" << current.counters[c];
+    }
+    out << "}}";
+    return out.str();
+}
+
+std::string Metrics::prometheus() {
+    Totals current = totals();
+    std::ostringstream out;
+    out << "# HELP similarity_stage_seconds_total Wall time spent in each analysis stage.\n"
+        << "# TYPE similarity_stage_seconds_total counter\n";
+    for (int s = 0; s < kStageCount; s++) {
+        out << "similarity_stage_seconds_total{stage=\"" << name(static_cast<Stage>(s)) << "\"} "
+            << seconds(current.stage_nanoseconds[s]) << "\n";
+    }
+    out << "# HELP similarity_stage_calls_total Times each analysis stage ran.\n"
+        << "# TYPE similarity_stage_calls_total counter\n";
+    for (int s = 0; s < kStageCount; s++) {
+        out << "similarity_stage_calls_total{stage=\"" << name(static_cast<Stage>(s)) << "\"} "
+            << current.stage_calls[s] << "\n";
+    }
+    for (int c = 0; c < kCounterCount; c++) {
+        const char* counter = name(static_cast<Counter>(c));
+        out << "# TYPE similarity_" << counter << "_total counter\n"
+            << "similarity_" << counter << "_total " << current.counters[c] << "\n";
+    }
+    return out.str();
+}
+
+#ifdef SIMILARITY_METRICS
+// Allocation counting. Replacing the global operators is what makes this a
+// build-time choice: without SIMILARITY_METRICS they are not defined here.
+// Every replaceable form is replaced, so that each allocation is counted
+// and memory from our malloc never reaches the library's delete or the
+// other way round.
+namespace {
+void* allocate(std::size_t size, std::size_t alignment) {
+    add(Metrics::Allocations, 1);
+    add(Metrics::AllocatedBytes, size);
+    size = size ? size : 1;
+    while (true) {
+        void* pointer = nullptr;
+        if (alignment <= alignof(std::max_align_t)) {
+            pointer = std::malloc(size);
+        } else if (posix_memalign(&pointer, alignment, size) != 0) {
+            pointer = nullptr;
+        }
+        if (pointer) {
+            return pointer;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+void* allocateNothrow(std::size_t size, std::size_t alignment) noexcept {
+    try {
+        return allocate(size, alignment);
+    } catch (...) {
+        return nullptr;
+    }
+}
+}  // namespace
+
+void* operator new(std::size_t size) {
+    return allocate(size, alignof(std::max_align_t));
+}
+
+void* operator new[](std::size_t size) {
+    return allocate(size, alignof(std::max_align_t));
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return allocateNothrow(size, alignof(std::max_align_t));
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return allocateNothrow(size, alignof(std::max_align_t));
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocateNothrow(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocateNothrow(size, static_cast<std::size_t>(alignment));
+}
+
+// malloc and posix_memalign memory both go back through free()
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept {
+    std::free(pointer);
+}
+#endif
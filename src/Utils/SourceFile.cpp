@@ -0,0 +1,106 @@
+#include "Utils/SourceFile.h"
+
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+SourceFile::~SourceFile() {
+    close();
+}
+
+SourceFile::SourceFile(SourceFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+SourceFile& SourceFile::operator=(SourceFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        mapped = other.mapped;
+        length = other.length;
+        buffer = std::move(other.buffer);
+        error_message = std::move(other.error_message);
+        data = mapped ? other.data : buffer.data();
+
+        other.data = nullptr;
+        other.length = 0;
+        other.mapped = false;
+    }
+    return *this;
+}
+
+bool SourceFile::open(const std::string& path) {
+    close();
+    error_message.clear();
+
+    if (path == "-") {
+        return readAll(STDIN_FILENO);
+    }
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error_message = std::strerror(errno);
+        return false;
+    }
+
+    struct stat info;
+    if (::fstat(fd, &info) == 0 && S_ISREG(info.st_mode)) {
+        if (info.st_size == 0) {
+            ::close(fd);
+            return true;
+        }
+
+        void* address = ::mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ,
+                               MAP_PRIVATE, fd, 0);
+        if (address != MAP_FAILED) {
+            ::madvise(address, static_cast<std::size_t>(info.st_size), MADV_SEQUENTIAL);
+            ::close(fd);
+            data = static_cast<const char*>(address);
+            length = static_cast<std::size_t>(info.st_size);
+            mapped = true;
+            return true;
+        }
+    }
+
+    // Not a regular file, or mmap refused: fall back to read()
+    bool ok = readAll(fd);
+    ::close(fd);
+    return ok;
+}
+
+void SourceFile::close() {
+    if (mapped && data != nullptr) {
+        ::munmap(const_cast<char*>(data), length);
+    }
+    data = nullptr;
+    length = 0;
+    mapped = false;
+    buffer.clear();
+}
+
+bool SourceFile::readAll(int fd) {
+    char chunk[64 * 1024];
+    while (true) {
+        ssize_t got = ::read(fd, chunk, sizeof(chunk));
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            error_message = std::strerror(errno);
+            buffer.clear();
+            return false;
+        }
+        if (got == 0) {
+            break;
+        }
+        buffer.append(chunk, static_cast<std::size_t>(got));
+    }
+
+    data = buffer.data();
+    length = buffer.size();
+    return true;
+}
@@ -1,4 +1,5 @@
 #include "Utils/StringUtils.h"
+#include "Utils/SourceFile.h"
 #include <algorithm>
 #include <fstream>
 #include <sstream>
@@ -6,6 +7,166 @@
 #include <unordered_set>
 #include <cmath>
 #include <functional>
+#include <unordered_map>
+
+namespace {
+// Match masks of a pattern for the bit-parallel edit distance: for symbol c,
+// bit i of word w is set when pattern[64 * w + i] == c. Symbols absent from
+// the pattern map to a row of zeros.
+class ByteMasks {
+   public:
+    ByteMasks(const unsigned char* pattern, size_t length)
+        : words((length + 63) / 64), masks(256 * words, 0) {
+        for (size_t i = 0; i < length; i++) {
+            masks[pattern[i] * words + i / 64] |= 1ULL << (i % 64);
+        }
+    }
+
+    const std::uint64_t* find(unsigned char symbol) const { return &masks[symbol * words]; }
+
+   private:
+    size_t words;
+    std::vector<std::uint64_t> masks;
+};
+
+class SymbolMasks {
+   public:
+    SymbolMasks(const std::uint32_t* pattern, size_t length)
+        : words((length + 63) / 64), masks(words, 0) {  // row 0 is the zero row
+        for (size_t i = 0; i < length; i++) {
+            auto it = rows.emplace(pattern[i], masks.size() / words).first;
+            if (it->second * words == masks.size()) {
+                masks.resize(masks.size() + words, 0);
+            }
+            masks[it->second * words + i / 64] |= 1ULL << (i % 64);
+        }
+    }
+
+    const std::uint64_t* find(std::uint32_t symbol) const {
+        auto it = rows.find(symbol);
+        return &masks[it == rows.end() ? 0 : it->second * words];
+    }
+
+   private:
+    size_t words;
+    std::vector<std::uint64_t> masks;
+    std::unordered_map<std::uint32_t, size_t> rows;
+};
+
+// Myers' block-based bit-vector algorithm. The pattern runs down the
+// columns in 64-row words; each text symbol advances every word, passing
+// the horizontal delta of its last row on to the next word.
+template <typename Masks, typename T>
+int myersDistance(const T* pattern, size_t m, const T* text, size_t n) {
+    Masks masks(pattern, m);
+    const size_t words = (m + 63) / 64;
+    const std::uint64_t last_bit = 1ULL << ((m - 1) % 64);
+
+    std::vector<std::uint64_t> positive(words, ~0ULL), negative(words, 0);
+    int score = static_cast<int>(m);
+
+    for (size_t j = 0; j < n; j++) {
+        const std::uint64_t* match = masks.find(text[j]);
+        int carry = 1;  // the top row grows by one per column
+
+        for (size_t w = 0; w < words; w++) {
+            std::uint64_t eq = match[w];
+            std::uint64_t pv = positive[w];
+            std::uint64_t mv = negative[w];
+
+            std::uint64_t xv = eq | mv;
+            if (carry < 0) eq |= 1;
+            std::uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+            std::uint64_t ph = mv | ~(xh | pv);
+            std::uint64_t mh = pv & xh;
+
+            std::uint64_t top = w + 1 == words ? last_bit : 1ULL << 63;
+            int out = (ph & top) ? 1 : (mh & top) ? -1 : 0;
+
+            ph <<= 1;
+            mh <<= 1;
+            if (carry < 0) {
+                mh |= 1;
+            } else if (carry > 0) {
+                ph |= 1;
+            }
+            positive[w] = mh | ~(xv | ph);
+            negative[w] = ph & xv;
+            carry = out;
+        }
+        score += carry;
+    }
+    return score;
+}
+
+template <typename Masks, typename T>
+int levenshtein(const T* a, size_t m, const T* b, size_t n) {
+    // The shorter sequence is the pattern: fewer words per column
+    if (m > n) {
+        std::swap(a, b);
+        std::swap(m, n);
+    }
+    if (m == 0) return static_cast<int>(n);
+    return myersDistance<Masks>(a, m, b, n);
+}
+
+// Ukkonen's band: only cells with |i - j| <= k can hold a distance <= k.
+// Row i keeps cell j at index j - i + k.
+template <typename T>
+int bandedDistance(const T* a, size_t m, const T* b, size_t n, int k) {
+    const int width = 2 * k + 1;
+    const int over = k + 1;
+    std::vector<int> previous(width, over), current(width, over);
+
+    for (int j = 0; j <= k && j <= static_cast<int>(n); j++) {
+        previous[j + k] = j;
+    }
+
+    for (int i = 1; i <= static_cast<int>(m); i++) {
+        int row_min = over;
+        for (int d = 0; d < width; d++) {
+            int j = i + d - k;
+            if (j < 0 || j > static_cast<int>(n)) {
+                current[d] = over;
+                continue;
+            }
+
+            int value;
+            if (j == 0) {
+                value = i;
+            } else {
+                value = previous[d] + (a[i - 1] == b[j - 1] ? 0 : 1);  // diagonal
+                if (d + 1 < width) value = std::min(value, previous[d + 1] + 1);  // from above
+                if (d > 0) value = std::min(value, current[d - 1] + 1);            // from the left
+            }
+            current[d] = std::min(value, over);
+            row_min = std::min(row_min, current[d]);
+        }
+        if (row_min > k) {
+            return over;  // every path already costs more than k
+        }
+        std::swap(previous, current);
+    }
+
+    return previous[static_cast<int>(n) - static_cast<int>(m) + k];
+}
+
+template <typename Masks, typename T>
+int boundedLevenshtein(const T* a, size_t m, const T* b, size_t n, int max_distance) {
+    max_distance = std::max(max_distance, 0);
+    size_t length_gap = m > n ? m - n : n - m;
+    if (length_gap > static_cast<size_t>(max_distance)) {
+        return max_distance + 1;
+    }
+
+    // A narrow band beats the bit-vectors; a wide one does not
+    size_t words = (std::min(m, n) + 63) / 64;
+    if (static_cast<size_t>(2 * max_distance + 1) < 4 * words) {
+        return bandedDistance(a, m, b, n, max_distance);
+    }
+    return std::min(levenshtein<Masks>(a, m, b, n), max_distance + 1);
+}
+}  // namespace
 
 std::string StringUtils::trim(const std::string& str) {
     size_t start = str.find_first_not_of(" \t\n\r");
@@ -70,25 +231,27 @@ double StringUtils::calculateJaccardSimilarity(const std::string& str1, const st
 }
 
 int StringUtils::calculateLevenshteinDistance(const std::string& str1, const std::string& str2) {
-    int m = str1.length();
-    int n = str2.length();
-    
-    std::vector<std::vector<int>> dp(m + 1, std::vector<int>(n + 1));
-    
-    for (int i = 0; i <= m; i++) dp[i][0] = i;
-    for (int j = 0; j <= n; j++) dp[0][j] = j;
-    
-    for (int i = 1; i <= m; i++) {
-        for (int j = 1; j <= n; j++) {
-            if (str1[i-1] == str2[j-1]) {
-                dp[i][j] = dp[i-1][j-1];
-            } else {
-                dp[i][j] = 1 + std::min({dp[i-1][j], dp[i][j-1], dp[i-1][j-1]});
-            }
-        }
-    }
-    
-    return dp[m][n];
+    return levenshtein<ByteMasks>(reinterpret_cast<const unsigned char*>(str1.data()), str1.size(),
+                                  reinterpret_cast<const unsigned char*>(str2.data()), str2.size());
+}
+
+int StringUtils::calculateLevenshteinDistance(const std::vector<std::uint32_t>& seq1,
+                                              const std::vector<std::uint32_t>& seq2) {
+    return levenshtein<SymbolMasks>(seq1.data(), seq1.size(), seq2.data(), seq2.size());
+}
+
+int StringUtils::calculateLevenshteinDistance(const std::string& str1, const std::string& str2,
+                                              int max_distance) {
+    return boundedLevenshtein<ByteMasks>(reinterpret_cast<const unsigned char*>(str1.data()), str1.size(),
+                                         reinterpret_cast<const unsigned char*>(str2.data()), str2.size(),
+                                         max_distance);
+}
+
+int StringUtils::calculateLevenshteinDistance(const std::vector<std::uint32_t>& seq1,
+                                              const std::vector<std::uint32_t>& seq2,
+                                              int max_distance) {
+    return boundedLevenshtein<SymbolMasks>(seq1.data(), seq1.size(), seq2.data(), seq2.size(),
+                                           max_distance);
 }
 
 std::string StringUtils::calculateHash(const std::string& input) {
@@ -99,15 +262,36 @@ std::size_t StringUtils::simpleHash(const std::string& str) {
     return std::hash<std::string>{}(str);
 }
 
+std::uint64_t StringUtils::contentHash(std::string_view data) {
+    const std::uint64_t kMul = 0x9E3779B97F4A7C15ULL;
+    std::uint64_t hash = 0x243F6A8885A308D3ULL ^ (data.size() * kMul);
+    
+    size_t i = 0;
+    for (; i + 8 <= data.size(); i += 8) {
+        std::uint64_t word = 0;
+        for (int b = 0; b < 8; b++) {
+            word |= static_cast<std::uint64_t>(static_cast<unsigned char>(data[i + b])) << (8 * b);
+        }
+        hash = (hash ^ word) * kMul;
+        hash ^= hash >> 29;
+    }
+    
+    std::uint64_t tail = 0;
+    for (int b = 0; i < data.size(); i++, b++) {
+        tail |= static_cast<std::uint64_t>(static_cast<unsigned char>(data[i])) << (8 * b);
+    }
+    hash = (hash ^ tail) * kMul;
+    hash ^= hash >> 32;
+    return hash;
+}
+
 std::string StringUtils::readFile(const std::string& filename) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
+    SourceFile file;
+    if (!file.open(filename)) {
         return "";
     }
     
-    std::string content((std::istreambuf_iterator<char>(file)),
-                       std::istreambuf_iterator<char>());
-    return content;
+    return std::string(file.view());
 }
 
 bool StringUtils::writeFile(const std::string& filename, const std::string& content) {
@@ -0,0 +1,225 @@
+#include "Utils/ThreadPool.h"
+
+#include <algorithm>
+
+namespace {
+// Identifies the pool and deque owned by the current thread, if any
+thread_local const ThreadPool* current_pool = nullptr;
+thread_local unsigned current_index = 0;
+}  // namespace
+
+ThreadPool::ThreadPool(unsigned threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (unsigned i = 0; i < threads; i++) {
+        queues.push_back(std::make_unique<WorkQueue>());
+    }
+    for (unsigned i = 0; i < threads; i++) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        stopping = true;
+    }
+    work_available.notify_all();
+
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(Task task) {
+    unsigned index;
+    if (current_pool == this) {
+        index = current_index;
+    } else {
+        index = next_queue.fetch_add(1, std::memory_order_relaxed) % size();
+    }
+
+    // Count the task before it becomes visible so workers never see a
+    // negative backlog
+    {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        queued++;
+        pending++;
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+    work_available.notify_one();
+}
+
+void ThreadPool::wait() {
+    // The waiting thread helps drain the queues instead of idling
+    unsigned self = current_pool == this ? current_index : 0;
+
+    while (true) {
+        Task task;
+        if ((current_pool == this && tryPop(self, task)) || trySteal(self, task)) {
+            runTask(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(state_mutex);
+        if (pending == 0) {
+            break;
+        }
+        work_done.wait(lock, [this] { return pending == 0 || queued > 0; });
+    }
+
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        std::swap(error, first_error);
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void ThreadPool::parallelFor(std::size_t count, std::size_t grain,
+                             const std::function<void(std::size_t, std::size_t)>& fn) {
+    grain = std::max<std::size_t>(1, grain);
+    const std::size_t chunks = (count + grain - 1) / grain;
+    if (chunks == 0) {
+        return;
+    }
+
+    // Chunks are claimed from a counter of this call, by the caller and by
+    // helper tasks. The caller never runs anyone else's task and only waits
+    // for chunks already running, so it finishes independently of other
+    // callers, and even from inside a task while every worker is busy.
+    // Helpers that start after the last chunk was claimed do nothing; they
+    // touch `fn` only after a claim, while the caller is still waiting.
+    struct Call {
+        std::atomic<std::size_t> next{0};
+        std::mutex mutex;
+        std::condition_variable done;
+        std::size_t finished = 0;
+        std::exception_ptr error;
+    };
+    auto call = std::make_shared<Call>();
+    auto work = [call, chunks, grain, count, &fn] {
+        std::size_t chunk;
+        while ((chunk = call->next.fetch_add(1, std::memory_order_relaxed)) < chunks) {
+            std::size_t begin = chunk * grain;
+            std::exception_ptr error;
+            try {
+                fn(begin, std::min(count, begin + grain));
+            } catch (...) {
+                error = std::current_exception();
+            }
+
+            bool last;
+            {
+                std::lock_guard<std::mutex> lock(call->mutex);
+                if (error && !call->error) {
+                    call->error = error;
+                }
+                last = ++call->finished == chunks;
+            }
+            if (last) {
+                call->done.notify_all();
+            }
+        }
+    };
+
+    std::size_t helpers = std::min<std::size_t>(chunks - 1, size());
+    for (std::size_t i = 0; i < helpers; i++) {
+        submit(work);
+    }
+    work();
+
+    std::unique_lock<std::mutex> lock(call->mutex);
+    call->done.wait(lock, [&] { return call->finished == chunks; });
+    if (call->error) {
+        std::rethrow_exception(call->error);
+    }
+}
+
+void ThreadPool::workerLoop(unsigned index) {
+    current_pool = this;
+    current_index = index;
+
+    while (true) {
+        Task task;
+        if (tryPop(index, task) || trySteal(index, task)) {
+            runTask(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(state_mutex);
+        if (stopping) {
+            return;
+        }
+        if (queued > 0) {
+            // A task was counted but not pushed yet; retry shortly
+            lock.unlock();
+            std::this_thread::yield();
+            continue;
+        }
+        work_available.wait(lock, [this] { return stopping || queued > 0; });
+    }
+}
+
+bool ThreadPool::tryPop(unsigned index, Task& task) {
+    WorkQueue& queue = *queues[index];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            return false;
+        }
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+    }
+
+    std::lock_guard<std::mutex> lock(state_mutex);
+    queued--;
+    return true;
+}
+
+bool ThreadPool::trySteal(unsigned index, Task& task) {
+    for (unsigned offset = 1; offset <= size(); offset++) {
+        WorkQueue& victim = *queues[(index + offset) % size()];
+        {
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (victim.tasks.empty()) {
+                continue;
+            }
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+        }
+
+        std::lock_guard<std::mutex> lock(state_mutex);
+        queued--;
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::runTask(Task& task) {
+    std::exception_ptr error;
+    try {
+        task();
+    } catch (...) {
+        error = std::current_exception();
+    }
+
+    bool finished;
+    {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        if (error && !first_error) {
+            first_error = error;
+        }
+        finished = --pending == 0;
+    }
+    if (finished) {
+        work_done.notify_all();
+    }
+}
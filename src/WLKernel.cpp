@@ -0,0 +1,158 @@
+#include "WLKernel.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+const std::uint64_t kSeed = 0xcbf29ce484222325ULL;
+const std::uint64_t kUnsigned = 0x2545f4914f6cdd1dULL;  // seed of blocks without a signature
+const std::uint32_t kSuccessors = 0x53554343u;
+const std::uint32_t kPredecessors = 0x50524544u;
+
+inline std::uint64_t mix(std::uint64_t hash, std::uint64_t value) {
+    hash ^= value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    return hash * 0x100000001b3ULL;
+}
+
+inline std::uint64_t finish(std::uint64_t hash) {
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+}  // namespace
+
+WLKernel::WLKernel(const WLOptions& options) : opts(options) {
+    opts.iterations = std::max(0, opts.iterations);
+    opts.bits = std::max(1, std::min(32, opts.bits));
+}
+
+template <typename Emit>
+void WLKernel::relabel(const CFGBuilder::CFG& cfg, int rounds, Emit emit) const {
+    const std::size_t n = cfg.blocks.size();
+    std::vector<std::uint64_t> current(n), next(n), neighbors;
+
+    // Predecessors in CSR form, like the successors
+    std::vector<std::uint32_t> first(n + 1, 0);
+    std::vector<int> predecessors(cfg.edges.size());
+    for (int successor : cfg.edges) {
+        first[successor + 1]++;
+    }
+    for (std::size_t b = 0; b < n; b++) {
+        first[b + 1] += first[b];
+    }
+    std::vector<std::uint32_t> fill(first.begin(), first.end() - 1);
+    for (const BasicBlock& block : cfg.blocks) {
+        for (int successor : cfg.successorsOf(block)) {
+            predecessors[fill[successor]++] = block.id;
+        }
+    }
+
+    for (std::size_t b = 0; b < n; b++) {
+        const BlockFeatures& features = cfg.blocks[b].features;
+        current[b] = features.semantic_signature != 0 ? features.semantic_signature
+                                                      : mix(kUnsigned, features.control_flow);
+    }
+    emit(0, current);
+
+    // Neighbor labels are sorted so that the new label depends on the
+    // neighborhood, not on the order edges were added in
+    auto mixSorted = [&](std::uint64_t hash) {
+        std::sort(neighbors.begin(), neighbors.end());
+        for (std::uint64_t label : neighbors) {
+            hash = mix(hash, label);
+        }
+        return hash;
+    };
+    for (int round = 1; round <= rounds; round++) {
+        for (std::size_t b = 0; b < n; b++) {
+            std::uint64_t hash = mix(kSeed, current[b]);
+
+            neighbors.clear();
+            for (int successor : cfg.successorsOf(cfg.blocks[b])) {
+                neighbors.push_back(current[successor]);
+            }
+            hash = mixSorted(mix(hash, kSuccessors));
+
+            neighbors.clear();
+            for (std::uint32_t e = first[b]; e < first[b + 1]; e++) {
+                neighbors.push_back(current[predecessors[e]]);
+            }
+            hash = mixSorted(mix(hash, kPredecessors));
+
+            next[b] = finish(hash);
+        }
+        current.swap(next);
+        emit(round, current);
+    }
+}
+
+WLVector WLKernel::vectorize(const CFGBuilder::CFG& cfg) const {
+    WLVector result;
+    std::vector<std::uint32_t> buckets;
+    buckets.reserve(cfg.blocks.size() * (opts.iterations + 1));
+    const int shift = 64 - opts.bits;
+
+    // A label of one round never collides with the same value in another
+    relabel(cfg, opts.iterations, [&](int round, const std::vector<std::uint64_t>& labels) {
+        for (std::uint64_t label : labels) {
+            buckets.push_back(static_cast<std::uint32_t>(finish(mix(label, round)) >> shift));
+        }
+    });
+
+    std::sort(buckets.begin(), buckets.end());
+    double squares = 0.0;
+    for (std::size_t i = 0; i < buckets.size();) {
+        std::size_t j = i;
+        while (j < buckets.size() && buckets[j] == buckets[i]) {
+            j++;
+        }
+        float count = static_cast<float>(j - i);
+        result.features.push_back({buckets[i], count});
+        squares += static_cast<double>(count) * count;
+        i = j;
+    }
+    result.norm = std::sqrt(squares);
+    return result;
+}
+
+std::vector<std::uint64_t> WLKernel::labels(const CFGBuilder::CFG& cfg, int round) const {
+    std::vector<std::uint64_t> result;
+    relabel(cfg, std::max(0, round), [&](int r, const std::vector<std::uint64_t>& labels) {
+        if (r == round) {
+            result = labels;
+        }
+    });
+    return result;
+}
+
+double WLKernel::dot(const WLVector& vector1, const WLVector& vector2) {
+    const std::vector<WLFeature>& a = vector1.features;
+    const std::vector<WLFeature>& b = vector2.features;
+    double sum = 0.0;
+    std::size_t i = 0, j = 0;
+    while (i < a.size() && j < b.size()) {
+        if (a[i].index < b[j].index) {
+            i++;
+        } else if (b[j].index < a[i].index) {
+            j++;
+        } else {
+            sum += static_cast<double>(a[i].weight) * b[j].weight;
+            i++;
+            j++;
+        }
+    }
+    return sum;
+}
+
+double WLKernel::cosine(const WLVector& vector1, const WLVector& vector2) {
+    if (vector1.features.empty() && vector2.features.empty()) {
+        return 1.0;
+    }
+    if (vector1.norm == 0.0 || vector2.norm == 0.0) {
+        return 0.0;
+    }
+    return std::min(1.0, dot(vector1, vector2) / (vector1.norm * vector2.norm));
+}
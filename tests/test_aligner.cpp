@@ -0,0 +1,138 @@
+#include "../include/Aligner.h"
+#include "../include/Normalizer.h"
+#include <iostream>
+#include <cassert>
+#include <string>
+
+std::vector<Token> tokenize(const std::string& code) {
+    Normalizer normalizer;
+    return normalizer.process(code);
+}
+
+std::string statements(const std::string& pattern, int count) {
+    std::string code;
+    for (int i = 0; i < count; i++) {
+        code += pattern;
+    }
+    return code;
+}
+
+const std::string kShared =
+    "for (i = 0; i < n; i++) { total = total + values[i] * weight; if (total > limit) { total = limit; } }";
+
+void test_tiles_find_shared_runs() {
+    Aligner aligner;
+    auto prefix = tokenize(statements("a = b;", 20));
+    auto shared = tokenize(kShared);
+    auto tokens1 = tokenize(statements("a = b;", 20) + kShared + statements("while (c) { c--; }", 5));
+    auto tokens2 = tokenize(statements("x = y * 2 - z;", 10) + kShared);
+
+    auto tiles = aligner.tile(tokens1, tokens2);
+    assert(!tiles.empty());
+
+    // The shared loop comes back as one tile at the right offsets
+    bool found = false;
+    for (const auto& tile : tiles) {
+        assert(tile.length1 == tile.length2);
+        assert(tile.length1 >= 12);
+        if (tile.first1 <= prefix.size() && tile.first1 + tile.length1 >= prefix.size() + shared.size()) {
+            found = true;
+        }
+        for (std::uint32_t k = 0; k < tile.length1; k++) {
+            Token t1 = tokens1[tile.first1 + k], t2 = tokens2[tile.first2 + k];
+            assert(t1.kind == t2.kind);
+            assert(t1.kind == TokenKind::Identifier || t1 == t2);
+        }
+    }
+    assert(found);
+    std::cout << "✓ Shared run tiling test passed (" << tiles.size() << " tiles)" << std::endl;
+}
+
+void test_tiles_do_not_overlap() {
+    Aligner aligner;
+    // Repetitive input: many candidate matches for every window
+    auto tokens1 = tokenize(statements("x = x + 1; y = y * x;", 30));
+    auto tokens2 = tokenize(statements("y = y * x; x = x + 1;", 25));
+    auto tiles = aligner.tile(tokens1, tokens2);
+
+    std::vector<char> used1(tokens1.size(), 0), used2(tokens2.size(), 0);
+    for (const auto& tile : tiles) {
+        for (std::uint32_t k = 0; k < tile.length1; k++) {
+            assert(!used1[tile.first1 + k] && !used2[tile.first2 + k]);
+            used1[tile.first1 + k] = used2[tile.first2 + k] = 1;
+        }
+    }
+    for (std::size_t i = 1; i < tiles.size(); i++) {
+        assert(tiles[i - 1].first1 < tiles[i].first1);
+    }
+    assert(Aligner::coverage(tiles, tokens1.size(), tokens2.size()) > 0.8);
+    std::cout << "✓ Non-overlapping tiles test passed" << std::endl;
+}
+
+void test_unrelated_code() {
+    Aligner aligner;
+    auto tokens1 = tokenize(statements("p = q % r;", 30));
+    auto tokens2 = tokenize(statements("if (z) { w = !w; }", 20));
+    assert(aligner.tile(tokens1, tokens2).empty());
+    assert(aligner.localAlignment(tokens1, tokens2).empty());
+    assert(aligner.tile(tokens1, {}).empty());
+    assert(aligner.localAlignment({}, tokens2).empty());
+    std::cout << "✓ Unrelated code test passed" << std::endl;
+}
+
+void test_local_alignment_with_edits() {
+    Aligner aligner;
+    std::string edited =
+        "for (i = 0; i < n; i++) { total = total + values[i] * 2 * weight; if (total >= limit) { total = limit; } }";
+    auto head = tokenize(statements("a = b;", 10));
+    auto tokens1 = tokenize(statements("a = b;", 10) + kShared + statements("c = d / e;", 10));
+    auto tokens2 = tokenize(statements("while (f) { f--; }", 8) + edited);
+
+    // The edits split the loop into tiles, but one local alignment spans it
+    auto regions = aligner.localAlignment(tokens1, tokens2);
+    assert(regions.size() == 1);
+    const AlignedRegion& region = regions[0];
+    auto shared = tokenize(kShared);
+    assert(region.first1 >= head.size() - 2 && region.first1 <= head.size() + 2);
+    assert(region.length1 + 4 >= shared.size());
+    assert(region.score >= 2 * static_cast<int>(shared.size()) - 20);
+
+    // Same region either way round
+    auto reversed = aligner.localAlignment(tokens2, tokens1);
+    assert(reversed.size() == 1 && reversed[0].score == region.score);
+    assert(reversed[0].first2 == region.first1 && reversed[0].length2 == region.length1);
+    std::cout << "✓ Local alignment test passed (score " << region.score << ")" << std::endl;
+}
+
+void test_line_mapping() {
+    Normalizer normalizer;
+    Aligner aligner;
+    std::string code1 = "{ }\n// note\n" + kShared + "\n";
+    // The same loop split over two lines after three other statements
+    std::size_t split = kShared.find("values");
+    std::string code2 = "x = 1;\ny = 2;\nz = 3;\n" + kShared.substr(0, split) + "\n" + kShared.substr(split) + "\n";
+
+    std::vector<SourceSpan> spans1, spans2;
+    auto tokens1 = normalizer.process(code1, spans1);
+    auto tokens2 = normalizer.process(code2, spans2);
+    auto tiles = aligner.tile(tokens1, tokens2);
+    assert(tiles.size() == 1);
+
+    Aligner::mapLines(tiles, spans1, LineIndex(code1), spans2, LineIndex(code2));
+    assert(tiles[0].line_begin1 == 3 && tiles[0].line_end1 == 3);
+    assert(tiles[0].line_begin2 == 4 && tiles[0].line_end2 == 5);
+    std::cout << "✓ Line mapping test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "Running Aligner tests..." << std::endl;
+
+    test_tiles_find_shared_runs();
+    test_tiles_do_not_overlap();
+    test_unrelated_code();
+    test_local_alignment_with_edits();
+    test_line_mapping();
+
+    std::cout << "All Aligner tests passed!" << std::endl;
+    return 0;
+}
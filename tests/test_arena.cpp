@@ -0,0 +1,89 @@
+#include "../include/Utils/Arena.h"
+#include "../include/CFGBuilder.h"
+#include "../include/Normalizer.h"
+#include "../include/Scorer.h"
+#include <iostream>
+#include <cassert>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+void test_alignment() {
+    Arena arena(1024);
+    for (std::size_t alignment : {1, 2, 4, 8, 16}) {
+        void* p = arena.allocate(3, alignment);
+        assert(reinterpret_cast<std::uintptr_t>(p) % alignment == 0);
+    }
+    std::cout << "✓ Alignment test passed" << std::endl;
+}
+
+void test_reset_reuses_memory() {
+    Arena arena(1024);
+
+    // Outgrow the first chunk several times
+    {
+        std::pmr::vector<int> values(&arena);
+        for (int i = 0; i < 10000; i++) {
+            values.push_back(i);
+        }
+        assert(values[9999] == 9999);
+    }
+    assert(arena.used() > 0);
+
+    // After a reset one chunk holds a whole round of the same work
+    arena.reset();
+    std::size_t capacity = arena.capacity();
+    assert(arena.used() == 0);
+    for (int round = 0; round < 3; round++) {
+        std::pmr::vector<int> values(&arena);
+        for (int i = 0; i < 10000; i++) {
+            values.push_back(i);
+        }
+        arena.reset();
+        assert(arena.capacity() == capacity);
+    }
+
+    // Requests larger than any chunk still succeed
+    void* big = arena.allocate(1 << 20, 8);
+    assert(big != nullptr);
+    std::cout << "✓ Reset reuse test passed (capacity " << capacity << " bytes)" << std::endl;
+}
+
+void test_scorer_with_arena() {
+    Normalizer normalizer;
+    CFGBuilder builder;
+    Arena arena;
+
+    std::string code1 = "int sum = 0; for (int i = 0; i < 10; i++) { sum = sum + i; } return sum;";
+    std::string code2 = "int total = 1; while (total < 100) { total = total * 2; } return total;";
+    auto cfg1 = builder.build(normalizer.process(code1));
+    auto cfg2 = builder.build(normalizer.process(code2));
+
+    Scorer heap_scorer;
+    auto expected = heap_scorer.calculate(cfg1, cfg2);
+
+    Normalizer arena_normalizer;
+    arena_normalizer.setArena(&arena);
+    assert(arena_normalizer.process(code1) == normalizer.process(code1));
+
+    Scorer arena_scorer;
+    arena_scorer.setArena(&arena);
+    for (int round = 0; round < 3; round++) {
+        auto score = arena_scorer.calculate(cfg1, cfg2);
+        assert(score.overall == expected.overall);
+        assert(score.fingerprint == expected.fingerprint);
+        assert(score.matched_blocks == expected.matched_blocks);
+    }
+    std::cout << "✓ Scorer with arena test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "Running Arena tests..." << std::endl;
+
+    test_alignment();
+    test_reset_reuses_memory();
+    test_scorer_with_arena();
+
+    std::cout << "All Arena tests passed!" << std::endl;
+    return 0;
+}
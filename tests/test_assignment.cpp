@@ -0,0 +1,97 @@
+#include "../include/AssignmentSolver.h"
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+double totalWeight(const std::vector<AssignmentEdge>& edges, const std::vector<std::pair<int, int>>& matches) {
+    double total = 0.0;
+    for (const auto& match : matches) {
+        for (const auto& edge : edges) {
+            if (edge.row == match.first && edge.col == match.second) {
+                total += edge.weight;
+                break;
+            }
+        }
+    }
+    return total;
+}
+
+// Exhaustive maximum-weight matching for tiny problems
+double bruteForce(int rows, int cols, const std::vector<AssignmentEdge>& edges, int row, std::vector<bool>& used) {
+    if (row == rows) return 0.0;
+
+    double best = bruteForce(rows, cols, edges, row + 1, used);
+    for (const auto& edge : edges) {
+        if (edge.row != row || used[edge.col]) continue;
+        used[edge.col] = true;
+        best = std::max(best, edge.weight + bruteForce(rows, cols, edges, row + 1, used));
+        used[edge.col] = false;
+    }
+    return best;
+}
+
+void test_optimal_beats_greedy() {
+    // Row 0 grabs column 0 first under greedy and leaves row 1 unmatched
+    std::vector<AssignmentEdge> edges = {{0, 0, 0.9}, {0, 1, 0.8}, {1, 0, 0.85}};
+
+    auto greedy = AssignmentSolver::solve(2, 2, edges, AssignmentSolver::Algorithm::Greedy);
+    auto hungarian = AssignmentSolver::solve(2, 2, edges, AssignmentSolver::Algorithm::Hungarian);
+    auto auction = AssignmentSolver::solve(2, 2, edges, AssignmentSolver::Algorithm::Auction);
+
+    assert(greedy.size() == 1);
+    assert(hungarian.size() == 2);
+    assert(auction.size() == 2);
+    assert(std::fabs(totalWeight(edges, hungarian) - 1.65) < 1e-9);
+    std::cout << "✓ Optimal beats greedy test passed" << std::endl;
+}
+
+void test_random_against_brute_force() {
+    std::srand(42);
+
+    for (int trial = 0; trial < 200; trial++) {
+        int rows = 1 + std::rand() % 6;
+        int cols = 1 + std::rand() % 6;
+
+        std::vector<AssignmentEdge> edges;
+        for (int i = 0; i < rows; i++) {
+            for (int j = 0; j < cols; j++) {
+                if (std::rand() % 2) {
+                    edges.push_back({i, j, 0.5 + (std::rand() % 500) / 1000.0});
+                }
+            }
+        }
+
+        std::vector<bool> used(cols, false);
+        double best = bruteForce(rows, cols, edges, 0, used);
+
+        auto hungarian = AssignmentSolver::solve(rows, cols, edges, AssignmentSolver::Algorithm::Hungarian);
+        auto auction = AssignmentSolver::solve(rows, cols, edges, AssignmentSolver::Algorithm::Auction);
+
+        assert(std::fabs(totalWeight(edges, hungarian) - best) < 1e-9);
+        // Auction is epsilon-optimal: within rows * max_weight / (4 (rows + 1))
+        assert(totalWeight(edges, auction) >= best - 0.25 - 1e-9);
+    }
+    std::cout << "✓ Random brute force test passed" << std::endl;
+}
+
+void test_budget_selection() {
+    AssignmentBudget budget;
+    budget.max_dense_work = 1000.0;
+
+    assert(AssignmentSolver::choose(10, 10, budget) == AssignmentSolver::Algorithm::Hungarian);
+    assert(AssignmentSolver::choose(11, 5, budget) == AssignmentSolver::Algorithm::Auction);
+    std::cout << "✓ Budget selection test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "Running AssignmentSolver tests..." << std::endl;
+
+    test_optimal_beats_greedy();
+    test_random_against_brute_force();
+    test_budget_selection();
+
+    std::cout << "All AssignmentSolver tests passed!" << std::endl;
+    return 0;
+}
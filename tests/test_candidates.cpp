@@ -0,0 +1,157 @@
+#include "../include/CandidateFilter.h"
+#include "../include/CFGBuilder.h"
+#include "../include/Normalizer.h"
+#include <algorithm>
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+CFGBuilder::CFG buildCFG(const std::string& code) {
+    Normalizer normalizer;
+    CFGBuilder builder;
+    return builder.build(normalizer.process(code));
+}
+
+void test_identical_code_is_candidate() {
+    CandidateOptions options;
+    options.threshold = 0.5;
+    CandidateFilter filter(options);
+
+    std::string code1 = "int sum = 0; for (int i = 0; i < 10; i++) { sum = sum + i; } return sum;";
+    std::string code2 = "int total = 0; for (int j = 0; j < 10; j++) { total = total + j; } return total;";
+    std::string code3 = "if (x > 0) { while (y) { y--; } } else { printf(\"none\"); }";
+
+    std::vector<CandidateFilter::Sketch> sketches = {
+        filter.sketch(buildCFG(code1)), filter.sketch(buildCFG(code2)), filter.sketch(buildCFG(code3))};
+
+    // Renamed variables normalize to the same tokens
+    assert(CandidateFilter::estimate(sketches[0], sketches[1]) == 1.0);
+    assert(CandidateFilter::estimate(sketches[0], sketches[2]) < 0.5);
+
+    auto pairs = filter.candidates(sketches);
+    assert(pairs.size() == 1);
+    assert(pairs[0].first == 0 && pairs[0].second == 1);
+    std::cout << "✓ Identical code candidate test passed" << std::endl;
+}
+
+void test_estimate_tracks_overlap() {
+    // Two long statement lists sharing about half of their statements
+    std::string shared, only1, only2;
+    for (int i = 0; i < 200; i++) {
+        shared += "a = b + " + std::to_string(i % 7) + "; c = a * d;\n";
+        only1 += "if (e < f) { g = g - h; }\n";
+        only2 += "while (k) { k = k / 2; m++; }\n";
+    }
+
+    CandidateOptions options;
+    options.threshold = 0.1;
+    CandidateFilter filter(options);
+    auto s1 = filter.sketch(buildCFG(shared + only1));
+    auto s2 = filter.sketch(buildCFG(shared + only2));
+    auto s3 = filter.sketch(buildCFG(only1));
+
+    double related = CandidateFilter::estimate(s1, s2);
+    double unrelated = CandidateFilter::estimate(s2, s3);
+    assert(related > 0.2 && related < 0.9);
+    assert(unrelated < related);
+    std::cout << "✓ Estimate test passed (related " << related << ", unrelated " << unrelated << ")"
+              << std::endl;
+}
+
+void test_band_selection() {
+    // Default recall target keeps a pair at the threshold with >= 95%
+    CandidateOptions options;
+    options.threshold = 0.4;
+    CandidateFilter filter(options);
+    assert(filter.bands() * filter.rows() <= options.num_hashes);
+    assert(filter.keepProbability(0.4) >= 0.95);
+    assert(filter.keepProbability(0.1) < filter.keepProbability(0.4));
+
+    // Asking for more recall never narrows the bands
+    options.recall = 0.999;
+    CandidateFilter strict(options);
+    assert(strict.rows() <= filter.rows());
+    assert(strict.keepProbability(0.4) >= 0.999);
+
+    // Explicit bands override the derived ones
+    options.bands = 16;
+    CandidateFilter fixed(options);
+    assert(fixed.bands() == 16 && fixed.rows() == 8);
+    std::cout << "✓ Band selection test passed (" << filter.bands() << "x" << filter.rows() << ")"
+              << std::endl;
+}
+
+void test_candidates_match_brute_force() {
+    // Clusters of near-copies collide in many bands; every pair must come
+    // out once, sorted, exactly when it shares a band and passes the
+    // estimate
+    CandidateOptions options;
+    options.threshold = 0.6;
+    options.bands = 16;
+    CandidateFilter filter(options);
+
+    std::mt19937 random(11);
+    std::vector<CandidateFilter::Sketch> sketches;
+    for (int cluster = 0; cluster < 6; cluster++) {
+        CandidateFilter::Sketch base(options.num_hashes);
+        for (auto& slot : base) {
+            slot = random();
+        }
+        for (int copy = 0; copy < 8; copy++) {
+            CandidateFilter::Sketch sketch = base;
+            for (auto& slot : sketch) {
+                if (random() % 100 < static_cast<unsigned>(copy * 6)) {
+                    slot = random();
+                }
+            }
+            sketches.push_back(sketch);
+        }
+    }
+
+    std::vector<std::pair<int, int>> expected;
+    for (int i = 0; i < static_cast<int>(sketches.size()); i++) {
+        for (int j = i + 1; j < static_cast<int>(sketches.size()); j++) {
+            bool shared = false;
+            for (int band = 0; band < filter.bands() && !shared; band++) {
+                auto first = sketches[i].begin() + band * filter.rows();
+                shared = std::equal(first, first + filter.rows(), sketches[j].begin() + band * filter.rows());
+            }
+            if (shared && CandidateFilter::estimate(sketches[i], sketches[j]) >= options.threshold) {
+                expected.emplace_back(i, j);
+            }
+        }
+    }
+    assert(!expected.empty());
+    assert(filter.candidates(sketches) == expected);
+    std::cout << "✓ Brute force candidates test passed (" << expected.size() << " pairs)" << std::endl;
+}
+
+void test_empty_code() {
+    CandidateOptions options;
+    options.threshold = 0.5;
+    CandidateFilter filter(options);
+
+    auto empty = filter.sketch(buildCFG(""));
+    auto small = filter.sketch(buildCFG("x = 1;"));
+    assert(empty.size() == static_cast<std::size_t>(options.num_hashes));
+    assert(CandidateFilter::estimate(empty, empty) == 1.0);
+    assert(CandidateFilter::estimate(small, small) == 1.0);
+    std::cout << "✓ Empty code test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "Running CandidateFilter tests..." << std::endl;
+
+    test_identical_code_is_candidate();
+    test_estimate_tracks_overlap();
+    test_band_selection();
+    test_candidates_match_brute_force();
+    test_empty_code();
+
+    std::cout << "All CandidateFilter tests passed!" << std::endl;
+    return 0;
+}
@@ -2,6 +2,8 @@
 #include "../include/Normalizer.h"
 #include <iostream>
 #include <cassert>
+#include <string>
+#include <vector>
 
 void test_simple_cfg() {
     Normalizer normalizer;
@@ -30,8 +32,8 @@ void test_conditional_cfg() {
     // Check for if keyword in one of the blocks
     bool found_if = false;
     for (const auto& block : cfg.blocks) {
-        for (const auto& token : block.tokens) {
-            if (token.type == "keyword" && token.value == "if") {
+        for (const auto& token : cfg.tokensOf(block)) {
+            if (token.kind == TokenKind::Keyword && token.symbol == Sym::If) {
                 found_if = true;
                 break;
             }
@@ -55,8 +57,8 @@ void test_loop_cfg() {
     // Check for while keyword
     bool found_while = false;
     for (const auto& block : cfg.blocks) {
-        for (const auto& token : block.tokens) {
-            if (token.type == "keyword" && token.value == "while") {
+        for (const auto& token : cfg.tokensOf(block)) {
+            if (token.kind == TokenKind::Keyword && token.symbol == Sym::While) {
                 found_while = true;
                 break;
             }
@@ -70,15 +72,138 @@ void test_block_successors() {
     Normalizer normalizer;
     CFGBuilder builder;
     
-    std::string code = "int x = 1; int y = 2;";
+    std::string code = "int x = 1; if (x) { x = 2; } int y = x;";
     auto tokens = normalizer.process(code);
     auto cfg = builder.build(tokens);
     
-    // Check that block map is populated
-    assert(!cfg.block_map.empty());
+    // Blocks cover the token stream in order, ids are indices and every
+    // successor names an existing block
+    assert(!cfg.blocks.empty());
+    std::uint32_t next_token = 0;
+    for (size_t i = 0; i < cfg.blocks.size(); i++) {
+        const BasicBlock& block = cfg.blocks[i];
+        assert(block.id == static_cast<int>(i));
+        assert(block.first_token == next_token);
+        next_token += block.token_count;
+        for (int successor : cfg.successorsOf(block)) {
+            assert(successor >= 0 && successor < static_cast<int>(cfg.blocks.size()));
+        }
+    }
+    assert(next_token == cfg.tokens.size());
+    // The declaration and the condition share a block, which branches to
+    // the then-branch and to the join
+    assert(cfg.blocks.size() == 3);
+    assert(cfg.blocks[0].edge_count == 2);
+    assert(cfg.successorsOf(cfg.blocks[0])[0] == 1 && cfg.successorsOf(cfg.blocks[0])[1] == 2);
+    assert(cfg.blocks[1].edge_count == 1 && cfg.successorsOf(cfg.blocks[1])[0] == 2);
     std::cout << "✓ Block successors test passed" << std::endl;
 }
 
+// Successor lists of every block, for comparing whole graphs
+std::vector<std::vector<int>> successors(const std::string& code) {
+    Normalizer normalizer;
+    CFGBuilder builder;
+    auto cfg = builder.build(normalizer.process(code));
+    std::vector<std::vector<int>> result;
+    for (const auto& block : cfg.blocks) {
+        auto next = cfg.successorsOf(block);
+        result.emplace_back(next.begin(), next.end());
+    }
+    return result;
+}
+
+void test_if_else_join() {
+    auto graph = successors("if (a) b = 1; else if (c) b = 2; else b = 3; done();");
+    // 0: if (a)  1: then  2: else if (c)  3: then  4: else  5: join
+    std::vector<std::vector<int>> expected = {{1, 2}, {5}, {3, 4}, {5}, {5}, {}};
+    assert(graph == expected);
+    std::cout << "✓ If/else join test passed" << std::endl;
+}
+
+void test_loop_back_edges() {
+    auto graph = successors("while (i < n) { if (x) break; if (y) continue; i++; } done();");
+    // 0: head  1: { if (x)  2: break  3: if (y)  4: continue  5: i++; }  6: exit
+    std::vector<std::vector<int>> expected = {{1, 6}, {2, 3}, {6}, {4, 5}, {0}, {0}, {}};
+    assert(graph == expected);
+
+    auto do_while = successors("do { x--; if (x == 3) continue; } while (x > 0); y;");
+    // 0: do { x--; if  1: continue; }  2: while (x > 0);  3: exit
+    std::vector<std::vector<int>> expected_do = {{1, 2}, {2}, {0, 3}, {}};
+    assert(do_while == expected_do);
+
+    auto for_loop = successors("int s = 0; for (int i = 0; i < n; i++) { s += i; } return s;");
+    std::vector<std::vector<int>> expected_for = {{1}, {2, 3}, {1}, {}};
+    assert(for_loop == expected_for);
+    std::cout << "✓ Loop back edge test passed" << std::endl;
+}
+
+void test_switch_cases() {
+    auto graph = successors("switch (k) { case 1: a(); break; case 2: b(); default: c(); } end();");
+    // 0: switch  1: case 1 ... break  2: case 2 (falls through)  3: default  4: exit
+    std::vector<std::vector<int>> expected = {{1, 2, 3}, {4}, {3}, {4}, {}};
+    assert(graph == expected);
+
+    // Without a default the switch can skip every case
+    auto no_default = successors("switch (k) { case 1: a(); } end();");
+    std::vector<std::vector<int>> expected_no_default = {{1, 2}, {2}, {}};
+    assert(no_default == expected_no_default);
+    std::cout << "✓ Switch test passed" << std::endl;
+}
+
+void test_maximal_blocks() {
+    Normalizer normalizer;
+    CFGBuilder builder;
+    // Braces and straight-line statements do not split blocks; a return
+    // ends one, and so does the start of a loop. Code after the function's
+    // return starts over without predecessors.
+    auto cfg = builder.build(normalizer.process(
+        "int f(int a) { int b = a * 2; { b++; } b--; while (b) { b--; } return b; } int g = 1;"));
+    assert(cfg.blocks.size() == 5);
+    assert(cfg.blocks[3].edge_count == 0);
+    assert(cfg.blocks[3].features.control_flow & CF_RETURN);
+    std::cout << "✓ Maximal block test passed" << std::endl;
+}
+
+void test_function_split() {
+    Normalizer normalizer;
+    CFGBuilder builder;
+    std::string code =
+        "#include <vector>\n"
+        "int counter = 0;\n"
+        "int add(int a, int b) { return a + b; }\n"
+        "auto twice = [](int x) { return 2 * x; };\n"
+        "namespace util {\n"
+        "class Box : public Base {\n"
+        "public:\n"
+        "    Box(int v) : value(v) {}\n"
+        "    int get() const { if (value) { return value; } return 0; }\n"
+        "    int value = 0;\n"
+        "};\n"
+        "}\n"
+        "int main() { for (int i = 0; i < 3; i++) { counter += add(i, i); } return counter; }\n";
+    auto tokens = normalizer.process(code);
+    auto functions = builder.buildFunctions(tokens);
+
+    // add, Box::Box, Box::get, main; the lambda is a value
+    assert(functions.size() == 4);
+    auto starts_with = [&](const CFGBuilder::FunctionCFG& function, SymbolId symbol) {
+        return tokens[function.first_token].symbol == symbol;
+    };
+    assert(starts_with(functions[0], Sym::Int));  // the #include is left out
+    assert(!starts_with(functions[1], Sym::Public));  // the access label is left out
+    assert(tokens[functions[3].first_token + functions[3].token_count - 1].symbol == Sym::RBrace);
+    for (const auto& function : functions) {
+        assert(function.cfg.tokens.size() == function.token_count);
+        assert(!function.cfg.blocks.empty());
+    }
+    assert(functions[2].cfg.blocks.size() > 1);  // get() branches
+
+    // Loose statements are one unit
+    auto snippet = builder.buildFunctions(normalizer.process("int x = 1; if (x) { x = 2; }"));
+    assert(snippet.size() == 1 && snippet[0].first_token == 0);
+    std::cout << "✓ Function split test passed" << std::endl;
+}
+
 int main() {
     std::cout << "Running CFGBuilder tests..." << std::endl;
     
@@ -86,6 +211,11 @@ int main() {
     test_conditional_cfg();
     test_loop_cfg();
     test_block_successors();
+    test_if_else_join();
+    test_loop_back_edges();
+    test_switch_cases();
+    test_maximal_blocks();
+    test_function_split();
     
     std::cout << "All CFGBuilder tests passed!" << std::endl;
     return 0;
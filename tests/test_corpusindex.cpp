@@ -0,0 +1,215 @@
+#include "../include/CorpusIndex.h"
+#include "../include/Normalizer.h"
+#include "../include/Scorer.h"
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Small programs of different shapes; variant v renames the variables
+std::string program(int shape, int v) {
+    std::string x = "x" + std::to_string(v), y = "y" + std::to_string(v), i = "i" + std::to_string(v);
+    switch (shape % 5) {
+        case 0:
+            return "int f(int " + x + ") { int " + y + " = 0; for (int " + i + " = 0; " + i + " < " + x +
+                   "; " + i + "++) { " + y + " += " + i + " * " + i + "; } return " + y + "; }\n";
+        case 1:
+            return "int g(int* " + x + ", int n) { for (int " + i + " = 0; " + i + " < n; " + i + "++) { if (" +
+                   x + "[" + i + "] == 0) { return " + i + "; } } return -1; }\n";
+        case 2:
+            return "void h(int " + x + ") { switch (" + x + ") { case 0: a(); break; case 1: b(); break; default: c(); } }\n";
+        case 3:
+            return "int k(int " + x + ") { while (" + x + " > 1) { if (" + x + " % 2 == 0) { " + x + " = " + x +
+                   " / 2; } else { " + x + " = 3 * " + x + " + 1; } } return " + x + "; }\n";
+        default:
+            return "double m(double " + x + ", double " + y + ") { return " + x + " * " + y + " - " + x +
+                   " / " + y + "; }\n";
+    }
+}
+
+CorpusIndex makeIndex(int files) {
+    CorpusIndex index(2);
+    for (int f = 0; f < files; f++) {
+        // Every shape a few times, with the helpers of other shapes around it
+        std::string code = program(f, f) + program(f + 1, f) + program(f, f + 100);
+        assert(index.add("file" + std::to_string(f) + ".cpp", code) == f);
+    }
+    return index;
+}
+
+void test_top_k_matches_brute_force() {
+    CorpusIndex index = makeIndex(25);
+    std::string code = program(3, 7) + program(4, 7) + program(3, 107);  // file 3 renamed
+
+    QueryOptions options;
+    options.top_k = 5;
+    options.screened = 0;
+    QueryStats stats;
+    auto neighbors = index.query(code, options, &stats);
+    assert(neighbors.size() == 5);
+    assert(stats.entries == 25 && stats.scored == 25);
+    for (std::size_t k = 1; k < neighbors.size(); k++) {
+        assert(neighbors[k - 1].score.overall >= neighbors[k].score.overall);
+    }
+
+    // Same ranking as scoring everything in turn
+    Normalizer normalizer;
+    CFGBuilder builder;
+    Scorer scorer;
+    auto cfg = builder.build(normalizer.process(code));
+    std::vector<double> scores;
+    for (std::size_t i = 0; i < index.size(); i++) {
+        scores.push_back(scorer.calculate(cfg, index.entry(static_cast<int>(i)).cfg).overall);
+    }
+    for (const Neighbor& neighbor : neighbors) {
+        assert(std::abs(neighbor.score.overall - scores[neighbor.entry]) < 1e-12);
+        int better = 0;
+        for (double score : scores) {
+            better += score > neighbor.score.overall;
+        }
+        assert(better < 5);
+    }
+    assert(neighbors[0].score.overall > 0.99);
+    assert(neighbors[0].entry % 5 == 3);
+    std::cout << "✓ Top-K test passed (best: " << index.entry(neighbors[0].entry).path << ")" << std::endl;
+}
+
+void test_fingerprint_weight() {
+    // Weighted after the entries are in, then one more entry
+    CorpusIndex index = makeIndex(10);
+    index.setWeights(0.3, 0.5, 0.2);
+    index.add("late.cpp", program(2, 9) + program(3, 9));
+    std::string code = program(2, 7) + program(3, 7);
+
+    QueryOptions options;
+    options.top_k = index.size();
+    options.screened = 0;
+    auto neighbors = index.query(code, options);
+    assert(neighbors.size() == index.size());
+
+    Normalizer normalizer;
+    CFGBuilder builder;
+    Scorer scorer;
+    scorer.setWeights(0.3, 0.5, 0.2);
+    auto cfg = builder.build(normalizer.process(code));
+    for (const Neighbor& neighbor : neighbors) {
+        Scorer::Score exact = scorer.calculate(cfg, index.entry(neighbor.entry).cfg);
+        assert(neighbor.score.overall == exact.overall && neighbor.score.fingerprint == exact.fingerprint);
+    }
+    assert(neighbors[0].entry == 10 && neighbors[0].score.fingerprint > 0.9);
+    std::cout << "✓ Fingerprint weight test passed" << std::endl;
+}
+
+void test_screening() {
+    CorpusIndex index = makeIndex(40);
+    std::string code = program(2, 9) + program(3, 9) + program(2, 109);
+
+    QueryOptions options;
+    options.top_k = 3;
+    options.screened = 8;
+    QueryStats stats;
+    auto neighbors = index.query(code, options, &stats);
+    assert(stats.scored == 8);
+    assert(neighbors.size() == 3);
+
+    // The exact shapes survive screening
+    for (const Neighbor& neighbor : neighbors) {
+        assert(neighbor.entry % 5 == 2);
+        assert(neighbor.score.overall > 0.99);
+        assert(neighbor.screen > 0.5);
+    }
+
+    // Nothing reaches an impossible minimum
+    options.min_score = 1.01;
+    assert(index.query(code, options).empty());
+    std::cout << "✓ Screening test passed" << std::endl;
+}
+
+void test_warm_start() {
+    CorpusIndex index = makeIndex(10);
+    const std::string path = "test_corpusindex.idx";
+    assert(index.save(path));
+
+    CorpusIndex warm(2);
+    assert(warm.open(path));
+    assert(warm.size() == index.size());
+    std::string code = program(1, 3) + program(2, 3) + program(1, 103);
+    auto cold_result = index.query(code);
+    auto warm_result = warm.query(code);
+    assert(cold_result.size() == warm_result.size());
+    for (std::size_t k = 0; k < cold_result.size(); k++) {
+        assert(cold_result[k].entry == warm_result[k].entry);
+        assert(warm.entry(warm_result[k].entry).path == index.entry(cold_result[k].entry).path);
+        assert(std::abs(cold_result[k].score.overall - warm_result[k].score.overall) < 1e-12);
+    }
+
+    // The warm index keeps growing
+    assert(warm.add("late.cpp", code) == 10);
+    auto late = warm.query(code);
+    bool found = false;
+    for (const Neighbor& neighbor : late) {
+        found = found || (neighbor.entry == 10 && neighbor.score.overall > 0.999);
+    }
+    assert(found);
+
+    CorpusIndex missing;
+    assert(!missing.open("does_not_exist.idx"));
+    assert(!missing.error().empty());
+    std::remove(path.c_str());
+    std::cout << "✓ Warm start test passed" << std::endl;
+}
+
+void test_concurrent_queries() {
+    CorpusIndex index = makeIndex(30);
+    QueryOptions options;
+    options.top_k = 3;
+    options.screened = 10;
+
+    std::vector<std::string> codes;
+    std::vector<std::vector<Neighbor>> expected;
+    for (int q = 0; q < 8; q++) {
+        codes.push_back(program(q, q + 50) + program(q + 2, q + 50));
+        expected.push_back(index.query(codes.back(), options));
+    }
+
+    // Queries from several threads share the index's pool and still get
+    // the answers they get one at a time
+    std::vector<std::thread> threads;
+    std::atomic<int> mismatches{0};
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&, t] {
+            for (int round = 0; round < 5; round++) {
+                for (std::size_t q = t % 2; q < codes.size(); q += 2) {
+                    auto neighbors = index.query(codes[q], options);
+                    bool same = neighbors.size() == expected[q].size();
+                    for (std::size_t k = 0; same && k < neighbors.size(); k++) {
+                        same = neighbors[k].entry == expected[q][k].entry &&
+                               neighbors[k].score.overall == expected[q][k].score.overall;
+                    }
+                    mismatches += !same;
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    assert(mismatches == 0);
+    std::cout << "✓ Concurrent queries test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "Running CorpusIndex tests..." << std::endl;
+
+    test_top_k_matches_brute_force();
+    test_screening();
+    test_fingerprint_weight();
+    test_warm_start();
+    test_concurrent_queries();
+
+    std::cout << "All CorpusIndex tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,125 @@
+#include "../include/FingerprintIndex.h"
+#include "../include/Fingerprinter.h"
+#include "../include/Normalizer.h"
+#include "../include/Scorer.h"
+#include <iostream>
+#include <cassert>
+#include <string>
+
+std::vector<Token> tokenize(const std::string& code) {
+    Normalizer normalizer;
+    return normalizer.process(code);
+}
+
+std::string statements(const std::string& pattern, int count) {
+    std::string code;
+    for (int i = 0; i < count; i++) {
+        code += pattern;
+    }
+    return code;
+}
+
+void test_winnowing_density() {
+    Fingerprinter fingerprinter;
+    std::string code;
+    for (int i = 0; i < 100; i++) {
+        code += "x" + std::to_string(i) + " = y" + std::to_string(i) + " * " + std::to_string(i) + ";\n";
+    }
+    auto tokens = tokenize(code);
+    auto fingerprints = fingerprinter.fingerprint(tokens);
+
+    // At least one fingerprint per window, positions increasing
+    std::size_t grams = tokens.size() - 8 + 1;
+    assert(fingerprints.size() >= grams / 4);
+    assert(fingerprints.size() < grams);
+    for (std::size_t i = 1; i < fingerprints.size(); i++) {
+        assert(fingerprints[i].position > fingerprints[i - 1].position);
+        assert(fingerprints[i].position - fingerprints[i - 1].position <= 4);
+    }
+    std::cout << "✓ Winnowing density test passed (" << fingerprints.size() << " of " << grams
+              << " k-grams)" << std::endl;
+}
+
+void test_shared_run_is_found() {
+    Fingerprinter fingerprinter;
+    std::string shared = "for (i = 0; i < n; i++) { total = total + values[i] * weight; }";
+    std::string code1 = statements("a = b;", 20) + shared + statements("if (c) { d--; }", 10);
+    std::string code2 = statements("while (e > f) { e = e / 2; }", 15) + shared;
+
+    auto set1 = Fingerprinter::hashSet(fingerprinter.fingerprint(tokenize(code1)));
+    auto set2 = Fingerprinter::hashSet(fingerprinter.fingerprint(tokenize(code2)));
+    auto unrelated = Fingerprinter::hashSet(fingerprinter.fingerprint(tokenize(statements("p = q % r;", 30))));
+
+    // A run longer than k + window - 1 tokens must share a fingerprint
+    assert(Fingerprinter::sharedCount(set1, set2) > 0);
+    assert(Fingerprinter::sharedCount(set1, unrelated) == 0);
+    assert(Fingerprinter::overlap(set1, set1) == 1.0);
+    std::cout << "✓ Shared run test passed" << std::endl;
+}
+
+void test_reordered_blocks() {
+    Normalizer normalizer;
+    CFGBuilder builder;
+    Scorer scorer;
+
+    std::string part1 = "int a = 0; for (int i = 0; i < 10; i++) { a = a + i * i; }";
+    std::string part2 = "while (a > 100) { a = a / 3; count++; }";
+    std::string part3 = "if (a == 7) { return a - 1; } else { return a + 1; }";
+
+    auto cfg1 = builder.build(normalizer.process(part1 + part2 + part3));
+    auto cfg2 = builder.build(normalizer.process(part3 + part1 + part2));
+    auto score = scorer.calculate(cfg1, cfg2);
+
+    assert(score.fingerprint > 0.5);
+    std::cout << "✓ Reordered blocks test passed (Fingerprint: " << score.fingerprint * 100 << "%)"
+              << std::endl;
+}
+
+void test_fingerprint_weight() {
+    Normalizer normalizer;
+    CFGBuilder builder;
+    Scorer scorer;
+    scorer.setWeights(0.0, 0.0, 1.0);
+
+    auto cfg1 = builder.build(normalizer.process(statements("x = x * 3 + y;", 10)));
+    auto cfg2 = builder.build(normalizer.process(statements("if (z) { w = !w; }", 10)));
+    auto score = scorer.calculate(cfg1, cfg2);
+    assert(score.overall == score.fingerprint);
+    std::cout << "✓ Fingerprint weight test passed" << std::endl;
+}
+
+void test_inverted_index() {
+    Fingerprinter fingerprinter;
+    FingerprintIndex index;
+
+    std::string shared = "for (i = 0; i < n; i++) { total = total + values[i] * weight; }";
+    index.add(fingerprinter.fingerprint(tokenize(statements("a = b;", 20) + shared)));
+    index.add(fingerprinter.fingerprint(tokenize(statements("while (c) { c--; }", 20))));
+    index.add(fingerprinter.fingerprint(tokenize(shared + statements("d = e - f;", 5))));
+    assert(index.size() == 3);
+
+    auto matches = index.query(fingerprinter.fingerprint(tokenize(shared)));
+    assert(matches.size() == 2);
+    assert(matches[0].document == 2 || matches[0].document == 0);
+    for (const auto& match : matches) {
+        assert(match.document != 1);
+        assert(match.shared > 0 && match.overlap > 0.0 && match.overlap <= 1.0);
+    }
+
+    // Hashes present in two documents count as boilerplate with a limit of one
+    assert(index.query(fingerprinter.fingerprint(tokenize(shared)), 1, 1).empty());
+    std::cout << "✓ Inverted index test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "Running Fingerprinter tests..." << std::endl;
+
+    test_winnowing_density();
+    test_shared_run_is_found();
+    test_reordered_blocks();
+    test_fingerprint_weight();
+    test_inverted_index();
+
+    std::cout << "All Fingerprinter tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,138 @@
+#include "../include/CFGBuilder.h"
+#include "../include/HistogramKernel.h"
+#include "../include/Normalizer.h"
+#include "../include/StructuralMatcher.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+const HistogramKernel::Level kLevels[] = {HistogramKernel::Level::Scalar, HistogramKernel::Level::SSE41,
+                                          HistogramKernel::Level::AVX2, HistogramKernel::Level::NEON};
+
+CFGBuilder::CFG buildCFG(const std::string& code) {
+    Normalizer normalizer;
+    CFGBuilder builder;
+    return builder.build(normalizer.process(code));
+}
+
+void test_dispatch() {
+    HistogramKernel::Level best = HistogramKernel::best();
+    assert(HistogramKernel::supported(best));
+    assert(HistogramKernel::supported(HistogramKernel::Level::Scalar));
+    assert(HistogramKernel::active() == best);
+    for (HistogramKernel::Level level : kLevels) {
+        assert(HistogramKernel::use(level) == HistogramKernel::supported(level));
+    }
+    assert(HistogramKernel::use(best));
+    std::cout << "✓ Dispatch test passed (using " << HistogramKernel::name(best) << ")" << std::endl;
+}
+
+void test_levels_agree() {
+    // Sparse small counts like real blocks, plus saturated bins whose
+    // minimums do not fit a signed 16-bit lane
+    std::mt19937 random(7);
+    const std::size_t kRows = 301;
+    std::vector<std::uint16_t> query(kHistogramBins), rows(kRows * kHistogramBins);
+    auto fill = [&](std::uint16_t* histogram) {
+        for (int bin = 0; bin < kHistogramBins; bin++) {
+            std::uint32_t roll = random() % 100;
+            histogram[bin] = roll < 60 ? 0 : roll < 95 ? random() % 8 : roll < 98 ? 65535 : random() % 65536;
+        }
+    };
+    fill(query.data());
+    for (std::size_t k = 0; k < kRows; k++) {
+        fill(rows.data() + k * kHistogramBins);
+    }
+
+    std::vector<std::uint32_t> expected(kRows);
+    for (std::size_t k = 0; k < kRows; k++) {
+        for (int bin = 0; bin < kHistogramBins; bin++) {
+            expected[k] += std::min(query[bin], rows[k * kHistogramBins + bin]);
+        }
+    }
+
+    int tested = 0;
+    for (HistogramKernel::Level level : kLevels) {
+        if (!HistogramKernel::use(level)) {
+            continue;
+        }
+        for (std::size_t count : {std::size_t(0), std::size_t(1), std::size_t(5), kRows}) {
+            std::vector<std::uint32_t> out(count + 1, 12345);
+            HistogramKernel::intersections(query.data(), rows.data(), count, out.data());
+            assert(std::equal(out.begin(), out.begin() + count, expected.begin()));
+            assert(out[count] == 12345);  // nothing written past the end
+        }
+        tested++;
+    }
+    HistogramKernel::use(HistogramKernel::best());
+    std::cout << "✓ Levels agree test passed (" << tested << " implementations)" << std::endl;
+}
+
+void test_matcher_scores_unchanged() {
+    std::vector<CFGBuilder::CFG> cfgs = {
+        buildCFG("int sum = 0; for (int i = 0; i < 10; i++) { sum = sum + i; }"),
+        buildCFG("int total = 0; for (int j = 0; j < 10; j++) { total = total + j; }"),
+        buildCFG("while (n > 1) { if (n % 2 == 0) { n = n / 2; } else { n = 3 * n + 1; } steps++; }"),
+        buildCFG("int m = a; if (b > m) { m = b; } if (c > m) { m = c; } return m;"),
+        buildCFG("switch (k) { case 0: a(); break; case 1: b(); break; default: c(); }"),
+    };
+
+    // Every implementation matches the same blocks with the same scores
+    // as the plain loops
+    StructuralMatcher matcher;
+    HistogramKernel::use(HistogramKernel::Level::Scalar);
+    std::vector<MatchResult> expected;
+    for (const auto& cfg1 : cfgs) {
+        for (const auto& cfg2 : cfgs) {
+            expected.push_back(matcher.compare(cfg1, cfg2));
+        }
+    }
+    for (HistogramKernel::Level level : kLevels) {
+        if (!HistogramKernel::use(level)) {
+            continue;
+        }
+        std::size_t k = 0;
+        for (const auto& cfg1 : cfgs) {
+            for (const auto& cfg2 : cfgs) {
+                MatchResult result = matcher.compare(cfg1, cfg2);
+                assert(result.similarity == expected[k].similarity);
+                assert(result.node_matches == expected[k].node_matches);
+                k++;
+            }
+        }
+    }
+    HistogramKernel::use(HistogramKernel::best());
+    assert(matcher.compare(cfgs[0], cfgs[1]).similarity > 0.9);
+    std::cout << "✓ Matcher scores unchanged test passed" << std::endl;
+}
+
+void test_kernel_speed() {
+    std::vector<std::uint16_t> query(kHistogramBins, 3), rows(4096 * kHistogramBins, 2);
+    std::vector<std::uint32_t> out(4096);
+    auto start = std::chrono::steady_clock::now();
+    const int kRounds = 200;
+    for (int round = 0; round < kRounds; round++) {
+        HistogramKernel::intersections(query.data(), rows.data(), 4096, out.data());
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    assert(out[4095] == 2u * kHistogramBins);
+    std::cout << "✓ Kernel speed test passed (" << seconds * 1e9 / (kRounds * 4096.0) << " ns per row)"
+              << std::endl;
+}
+
+int main() {
+    std::cout << "Running HistogramKernel tests..." << std::endl;
+
+    test_dispatch();
+    test_levels_agree();
+    test_matcher_scores_unchanged();
+    test_kernel_speed();
+
+    std::cout << "All HistogramKernel tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,131 @@
+#include "../include/CFGBuilder.h"
+#include "../include/Normalizer.h"
+#include "../include/Scorer.h"
+#include "../include/Utils/Json.h"
+#include "../include/Utils/Metrics.h"
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+const std::string kCode =
+    "int sum(int n) { int s = 0; for (int i = 0; i < n; i++) { if (i % 2) { s += i; } } return s; }\n"
+    "int twice(int x) { return x * 2; }\n";
+
+// One file through the pipeline and one pair scored
+void analyze() {
+    Normalizer normalizer;
+    CFGBuilder builder;
+    Scorer scorer;
+    auto cfg = builder.build(normalizer.process(kCode));
+    builder.buildFunctions(cfg.tokens);
+    scorer.calculate(cfg, cfg);
+}
+
+void test_counts() {
+    Metrics::reset();
+    analyze();
+    Metrics::Totals totals = Metrics::totals();
+
+    if (!Metrics::enabled()) {
+        for (int c = 0; c < Metrics::kCounterCount; c++) {
+            assert(totals.counters[c] == 0);
+        }
+        std::cout << "✓ Count test passed (instrumentation compiled out)" << std::endl;
+        return;
+    }
+
+    Normalizer normalizer;
+    CFGBuilder builder;
+    auto cfg = builder.build(normalizer.process(kCode));
+    assert(totals.counters[Metrics::Files] == 1);
+    assert(totals.counters[Metrics::Tokens] == cfg.tokens.size());
+    assert(totals.counters[Metrics::Functions] == 2);
+    // The file's CFG plus one per function
+    assert(totals.stage_calls[Metrics::BuildCFG] == 3);
+    assert(totals.counters[Metrics::PairsScored] == 1);
+    assert(totals.stage_calls[Metrics::Score] == 1 && totals.stage_calls[Metrics::Match] == 1);
+    assert(totals.counters[Metrics::BlockComparisons] == cfg.blocks.size());
+    assert(totals.counters[Metrics::Allocations] > 0 && totals.counters[Metrics::AllocatedBytes] > 0);
+    assert(totals.stage_nanoseconds[Metrics::Score] >= totals.stage_nanoseconds[Metrics::Match]);
+    std::cout << "✓ Count test passed (" << totals.counters[Metrics::Allocations] << " allocations)" << std::endl;
+}
+
+void test_threads() {
+    Metrics::reset();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back(analyze);
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    // Threads that exited still count
+    Metrics::Totals totals = Metrics::totals();
+    assert(totals.counters[Metrics::PairsScored] == (Metrics::enabled() ? 4u : 0u));
+
+    Metrics::reset();
+    assert(Metrics::totals().counters[Metrics::PairsScored] == 0);
+    std::cout << "✓ Thread test passed" << std::endl;
+}
+
+void test_formats() {
+    Metrics::reset();
+    analyze();
+
+    // The JSON report reads back; nested objects stay opaque to this reader
+    std::string json = Metrics::json();
+    assert(json.find(std::string("\"enabled\":") + (Metrics::enabled() ? "true" : "false")) != std::string::npos);
+    assert(json.find("\"score\":{\"seconds\":") != std::string::npos);
+    assert(json.find("\"pairs_scored\":" + std::string(Metrics::enabled() ? "1" : "0")) != std::string::npos);
+    Json::Object object;
+    std::string error;
+    assert(!Json::parseObject(json, object, error));  // nested
+
+    std::string text = Metrics::prometheus();
+    assert(text.find("# TYPE similarity_stage_seconds_total counter\n") != std::string::npos);
+    assert(text.find("similarity_stage_calls_total{stage=\"normalize\"} ") != std::string::npos);
+    assert(text.find("similarity_tokens_total ") != std::string::npos);
+    assert(text.back() == '\n');
+    std::cout << "✓ Format test passed" << std::endl;
+}
+
+void test_allocation_forms() {
+    // Over-aligned and nothrow allocations are counted like plain ones,
+    // and each goes back through its matching delete
+    struct alignas(64) Line {
+        char bytes[64];
+    };
+    Metrics::reset();
+    Line* line = new Line();
+    assert(reinterpret_cast<std::uintptr_t>(line) % 64 == 0);
+    delete line;
+    Line* lines = new Line[3];
+    assert(reinterpret_cast<std::uintptr_t>(lines) % 64 == 0);
+    delete[] lines;
+    int* value = new (std::nothrow) int(7);
+    assert(value && *value == 7);
+    delete value;
+    int* values = new (std::nothrow) int[5];
+    delete[] values;
+
+    Metrics::Totals totals = Metrics::totals();
+    assert(totals.counters[Metrics::Allocations] == (Metrics::enabled() ? 4u : 0u));
+    assert(totals.counters[Metrics::AllocatedBytes] >= (Metrics::enabled() ? 4 * 64u + 4 + 20 : 0u));
+    std::cout << "✓ Allocation forms test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "Running Metrics tests..." << std::endl;
+
+    test_counts();
+    test_threads();
+    test_formats();
+    test_allocation_forms();
+
+    std::cout << "All Metrics tests passed!" << std::endl;
+    return 0;
+}
@@ -1,5 +1,7 @@
 #include "../include/Normalizer.h"
+#include "../include/Utils/LineIndex.h"
 #include <iostream>
+#include <sstream>
 #include <cassert>
 
 void test_tokenization() {
@@ -14,9 +16,9 @@ void test_tokenization() {
     // Check for expected keywords
     bool found_int = false, found_if = false, found_return = false;
     for (const auto& token : tokens) {
-        if (token.type == "keyword" && token.value == "int") found_int = true;
-        if (token.type == "keyword" && token.value == "if") found_if = true;
-        if (token.type == "keyword" && token.value == "return") found_return = true;
+        if (token.kind == TokenKind::Keyword && token.symbol == Sym::Int) found_int = true;
+        if (token.kind == TokenKind::Keyword && token.symbol == Sym::If) found_if = true;
+        if (token.kind == TokenKind::Keyword && token.symbol == Sym::Return) found_return = true;
     }
     
     assert(found_int && found_if && found_return);
@@ -32,8 +34,8 @@ void test_variable_normalization() {
     // Check that variables are normalized
     bool found_var1 = false, found_var2 = false;
     for (const auto& token : tokens) {
-        if (token.type == "identifier" && token.value == "VAR_1") found_var1 = true;
-        if (token.type == "identifier" && token.value == "VAR_2") found_var2 = true;
+        if (token.kind == TokenKind::Identifier && SymbolTable::spelling(token.symbol) == "VAR_1") found_var1 = true;
+        if (token.kind == TokenKind::Identifier && SymbolTable::spelling(token.symbol) == "VAR_2") found_var2 = true;
     }
     
     assert(found_var1 && found_var2);
@@ -48,19 +50,128 @@ void test_comment_removal() {
     
     // Check that comments are removed (no comment tokens should exist)
     for (const auto& token : tokens) {
-        assert(token.value.find("//") == std::string::npos);
-        assert(token.value.find("/*") == std::string::npos);
+        assert(SymbolTable::spelling(token.symbol).find("//") == std::string::npos);
+        assert(SymbolTable::spelling(token.symbol).find("/*") == std::string::npos);
     }
     
     std::cout << "✓ Comment removal test passed" << std::endl;
 }
 
+void test_multichar_operators() {
+    Normalizer normalizer;
+    std::string code = "x += 1; if (a == b && p->q) { i++; } std::cout << x;";
+    
+    auto tokens = normalizer.process(code);
+    
+    bool found_plus_assign = false, found_equal = false, found_and = false;
+    bool found_arrow = false, found_increment = false, found_scope = false, found_shift = false;
+    for (const auto& token : tokens) {
+        if (token.symbol == Sym::PlusAssign) found_plus_assign = true;
+        if (token.symbol == Sym::Equal) found_equal = true;
+        if (token.symbol == Sym::AndAnd) found_and = true;
+        if (token.symbol == Sym::Arrow) found_arrow = true;
+        if (token.symbol == Sym::PlusPlus) found_increment = true;
+        if (token.symbol == Sym::ColonColon) found_scope = true;
+        if (token.symbol == Sym::ShiftLeft) found_shift = true;
+    }
+    
+    assert(found_plus_assign && found_equal && found_and && found_arrow);
+    assert(found_increment && found_scope && found_shift);
+    std::cout << "✓ Multi-character operator test passed" << std::endl;
+}
+
+void test_literal_stripping() {
+    Normalizer normalizer;
+    std::string code = "s = \"a // b /* c\"; c = '\\''; r = R\"x(\")\")x\"; n = 1'000;";
+    
+    auto tokens = normalizer.process(code);
+    
+    // s = LIT ; c = LIT ; r = LIT ; n = VAR ;
+    assert(tokens.size() == 16);
+    assert(tokens[2].kind == TokenKind::Literal && tokens[2].symbol == Sym::StringLiteral);
+    assert(tokens[6].kind == TokenKind::Literal && tokens[6].symbol == Sym::CharLiteral);
+    assert(tokens[10].kind == TokenKind::Literal && tokens[10].symbol == Sym::StringLiteral);
+    assert(tokens[14].kind == TokenKind::Identifier);
+    std::cout << "✓ Literal stripping test passed" << std::endl;
+}
+
+void test_streaming_matches_single_pass() {
+    Normalizer normalizer;
+    std::string code = "int total = 0; /* block\n comment */ for (int i = 0; i <<= 3; i++) {\n"
+                       "  total += i; // trailing\n  s = \"str \\\" ing\"; r = R\"d(x)\")d\"; }\n"
+                       "long_identifier_name->member >>= 2; x...; c = 'q';";
+    
+    auto expected = normalizer.process(code);
+    
+    for (std::size_t chunk = 1; chunk <= 9; chunk++) {
+        std::istringstream input(code);
+        auto streamed = normalizer.process(input, chunk);
+        assert(streamed == expected);
+    }
+    std::cout << "✓ Streaming test passed" << std::endl;
+}
+
+void test_source_spans() {
+    Normalizer normalizer;
+    std::string code = "int total = 0; /* block\n comment */ for (int i = 0; i <<= 3; i++) {\n"
+                       "  total += i; // trailing\n  s = \"str \\\" ing\"; r = R\"d(x)\")d\"; }\n"
+                       "long_identifier_name->member >>= 2; c = 'q'; u = \"open\n";
+
+    std::vector<SourceSpan> spans;
+    auto tokens = normalizer.process(code, spans);
+    assert(tokens == normalizer.process(code));
+    assert(spans.size() == tokens.size());
+
+    // Spans are the exact lexemes, literals included
+    auto text = [&](std::size_t i) { return code.substr(spans[i].offset, spans[i].length); };
+    assert(text(0) == "int" && text(1) == "total" && text(4) == ";");
+    std::vector<std::string> lexemes;
+    for (std::size_t i = 0; i < tokens.size(); i++) {
+        lexemes.push_back(text(i));
+    }
+    auto find = [&](const std::string& lexeme) {
+        for (std::size_t i = 0; i < lexemes.size(); i++) {
+            if (lexemes[i] == lexeme) return i;
+        }
+        return lexemes.size();
+    };
+    assert(find("<<=") < lexemes.size() && find(">>=") < lexemes.size());
+    assert(find("\"str \\\" ing\"") < lexemes.size());
+    assert(find("R\"d(x)\")d\"") < lexemes.size());
+    assert(find("'q'") < lexemes.size());
+    assert(find("\"open") < lexemes.size());  // unterminated, ends at the newline
+    assert(find("long_identifier_name") < lexemes.size());
+
+    // Lines and columns
+    LineIndex lines(code);
+    assert(lines.lineCount() == 6);  // the final newline starts an empty line
+    std::size_t loop = find("for");
+    assert(lines.line(spans[loop].offset) == 2 && lines.column(spans[loop].offset) == 13);
+    assert(lines.line(spans[find("long_identifier_name")].offset) == 5);
+
+    // Chunked input gives the same spans
+    for (std::size_t chunk = 1; chunk <= 9; chunk++) {
+        std::istringstream input(code);
+        std::vector<SourceSpan> streamed;
+        assert(normalizer.process(input, streamed, chunk) == tokens);
+        assert(streamed.size() == spans.size());
+        for (std::size_t i = 0; i < spans.size(); i++) {
+            assert(streamed[i].offset == spans[i].offset && streamed[i].length == spans[i].length);
+        }
+    }
+    std::cout << "✓ Source span test passed" << std::endl;
+}
+
 int main() {
     std::cout << "Running Normalizer tests..." << std::endl;
     
     test_tokenization();
     test_variable_normalization();
     test_comment_removal();
+    test_multichar_operators();
+    test_literal_stripping();
+    test_streaming_matches_single_pass();
+    test_source_spans();
     
     std::cout << "All Normalizer tests passed!" << std::endl;
     return 0;
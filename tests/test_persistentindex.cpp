@@ -0,0 +1,146 @@
+#include "../include/Corpus.h"
+#include "../include/CorpusIndex.h"
+#include "../include/PersistentIndex.h"
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// Record layout of PersistentIndex.cpp, for damaging files on purpose
+const std::size_t kBlockCountAt = 24;   // Header::block_count
+const std::size_t kFilesOffsetAt = 64;  // Header::files_offset
+const std::size_t kBlocksOffsetAt = 72;
+const std::size_t kFileRecordSize = 48;
+const std::size_t kFirstBlockAt = 16;  // FileRecord::first_block
+const std::size_t kBlockRecordSize = 4 * 8 + 6 * 4 + 2 * kHistogramBins;
+const std::size_t kFirstEdgeAt = 16;  // BlockRecord::first_edge
+
+const std::string kLoop =
+    "int sum(int n) { int s = 0; for (int i = 0; i < n; i++) { if (i % 2) { s += i; } } return s; }\n";
+const std::string kBranch = "int sign(int x) { if (x > 0) { return 1; } else if (x < 0) { return -1; } return 0; }\n";
+
+std::vector<char> readFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+void writeFile(const std::string& path, const std::vector<char>& bytes) {
+    std::ofstream(path, std::ios::binary).write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+std::uint64_t get(const std::vector<char>& bytes, std::size_t at) {
+    std::uint64_t value;
+    std::memcpy(&value, bytes.data() + at, sizeof(value));
+    return value;
+}
+
+void put(std::vector<char>& bytes, std::size_t at, std::uint64_t value) {
+    std::memcpy(bytes.data() + at, &value, sizeof(value));
+}
+
+std::vector<char> writeIndex(const std::string& path) {
+    CorpusIndex index(1);
+    index.add("loop.cpp", kLoop);
+    index.add("branch.cpp", kBranch);
+    assert(index.save(path));
+    return readFile(path);
+}
+
+void test_round_trip() {
+    const std::string path = "test_persistent.idx";
+    writeIndex(path);
+    PersistentIndex stored;
+    assert(stored.open(path));
+    assert(stored.size() == 2 && stored.find("branch.cpp") == 1);
+
+    CorpusIndex index(1);
+    int id = index.add("branch.cpp", kBranch);
+    const CFGBuilder::CFG& expected = index.entry(id).cfg;
+    CFGBuilder::CFG loaded = stored.loadCFG(1);
+    assert(loaded.blocks.size() == expected.blocks.size());
+    assert(loaded.edges == expected.edges);
+    std::remove(path.c_str());
+    std::cout << "✓ Round trip test passed" << std::endl;
+}
+
+void test_damaged_edges_rejected() {
+    const std::string path = "test_persistent_damaged.idx";
+    std::vector<char> bytes = writeIndex(path);
+
+    // A later block of the second file pointing before the file's edges
+    std::size_t file = get(bytes, kFilesOffsetAt) + kFileRecordSize;
+    std::uint64_t first_block = get(bytes, file + kFirstBlockAt);
+    std::size_t blocks = get(bytes, kBlocksOffsetAt);
+    std::size_t block = blocks + (first_block + 1) * kBlockRecordSize;
+    assert(get(bytes, blocks + first_block * kBlockRecordSize + kFirstEdgeAt) > 0);
+    put(bytes, block + kFirstEdgeAt, 0);
+    writeFile(path, bytes);
+
+    PersistentIndex stored;
+    assert(!stored.open(path));
+    assert(stored.error() == "index file is damaged");
+    std::remove(path.c_str());
+    std::cout << "✓ Damaged edges test passed" << std::endl;
+}
+
+void test_wrapping_ranges_rejected() {
+    const std::string path = "test_persistent_wrapping.idx";
+    std::vector<char> bytes = writeIndex(path);
+
+    // first_block + block_count wraps around to a small number
+    std::size_t file = get(bytes, kFilesOffsetAt);
+    assert(get(bytes, kBlockCountAt) > 1);
+    put(bytes, file + kFirstBlockAt, ~static_cast<std::uint64_t>(0));
+    writeFile(path, bytes);
+
+    PersistentIndex stored;
+    assert(!stored.open(path));
+    std::remove(path.c_str());
+    std::cout << "✓ Wrapping ranges test passed" << std::endl;
+}
+
+void test_reordered_files_reuse_pairs() {
+    const std::string path = "test_persistent_reorder.idx";
+    std::vector<std::string> files = {"test_reorder_a.cpp", "test_reorder_b.cpp", "test_reorder_c.cpp"};
+    for (std::size_t f = 0; f < files.size(); f++) {
+        std::ofstream(files[f]) << (f == 2 ? kBranch : kLoop) << "// file " << f << "\n";
+    }
+
+    Corpus corpus;
+    corpus.load(files, 1);
+    auto pairs = corpus.scoreAllPairs(1, 0.0);
+    std::string error;
+    assert(PersistentIndex::write(path, corpus, pairs, 0.0, error));
+
+    // The same files listed backwards take every pair from the index
+    PersistentIndex previous;
+    assert(previous.open(path));
+    Corpus reordered;
+    reordered.load({files[2], files[1], files[0]}, 1, &previous);
+    auto reused = reordered.scoreAllPairs(1, 0.0, &previous);
+    assert(reordered.stats().pairs_reused == 3 && reordered.stats().pairs_scored == 0);
+    assert(reused.size() == pairs.size() && reused[0].score.overall == pairs[0].score.overall);
+
+    std::remove(path.c_str());
+    for (const std::string& file : files) {
+        std::remove(file.c_str());
+    }
+    std::cout << "✓ Reordered files test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "Running PersistentIndex tests..." << std::endl;
+
+    test_round_trip();
+    test_damaged_edges_rejected();
+    test_wrapping_ranges_rejected();
+    test_reordered_files_reuse_pairs();
+
+    std::cout << "All PersistentIndex tests passed!" << std::endl;
+    return 0;
+}
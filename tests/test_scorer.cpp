@@ -1,9 +1,13 @@
 #include "../include/Scorer.h"
 #include "../include/CFGBuilder.h"
+#include "../include/Fingerprinter.h"
 #include "../include/Normalizer.h"
 #include <iostream>
 #include <cassert>
 #include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
 
 void test_identical_code() {
     Normalizer normalizer;
@@ -68,6 +72,33 @@ void test_empty_code() {
     std::cout << "✓ Empty code test passed" << std::endl;
 }
 
+void test_unrelated_files() {
+    // One shared statement block must not carry two unrelated files
+    Normalizer normalizer;
+    CFGBuilder builder;
+    Scorer scorer;
+
+    std::string code1 =
+        "int sum(int n) {\n    int s = 0;\n    for (int i = 0; i < n; i++) {\n"
+        "        if (i % 2 == 0) s += i; else s -= i;\n    }\n    return s;\n}\n"
+        "int main() {\n    int x = 10;\n    while (x > 0) { x--; if (x == 3) break; }\n"
+        "    std::cout << sum(x) << \"hi\" << std::endl;\n    return 0;\n}\n";
+    std::string code2 =
+        "struct P { int a; };\n"
+        "double avg(const std::vector<double>& v) { double t = 0; for (double d : v) t += d; "
+        "return v.empty() ? 0 : t / v.size(); }\n";
+
+    auto cfg1 = builder.build(normalizer.process(code1));
+    auto cfg2 = builder.build(normalizer.process(code2));
+    auto score = scorer.calculate(cfg1, cfg2);
+
+    // Below the "moderate similarity" verdict
+    assert(score.matched_blocks < score.total_blocks);
+    assert(score.overall < 0.5);
+    assert(score.semantic < 0.5);
+    std::cout << "✓ Unrelated files test passed (" << score.overall * 100 << "%)" << std::endl;
+}
+
 void test_weight_setting() {
     Scorer scorer;
     
@@ -102,14 +133,218 @@ void test_score_bounds() {
     std::cout << "✓ Score bounds test passed" << std::endl;
 }
 
+void test_function_matrix() {
+    Normalizer normalizer;
+    CFGBuilder builder;
+    Scorer scorer;
+
+    std::string sum = "int sum(int n) { int s = 0; for (int i = 0; i < n; i++) { s += i; } return s; }\n";
+    std::string find =
+        "int find(int* v, int n, int x) { for (int i = 0; i < n; i++) { if (v[i] == x) { return i; } } return -1; }\n";
+    std::string fact = "long fact(int n) { if (n <= 1) { return 1; } return n * fact(n - 1); }\n";
+    std::string other = "void log(int level) { switch (level) { case 0: a(); break; default: b(); } }\n";
+
+    // Same functions in another order, renamed, plus one unrelated function
+    auto functions1 = builder.buildFunctions(normalizer.process(sum + find + fact));
+    auto functions2 = builder.buildFunctions(normalizer.process(other + fact + sum + find));
+    assert(functions1.size() == 3 && functions2.size() == 4);
+
+    auto result = scorer.calculateFunctions(functions1, functions2);
+    assert(result.rows == 3 && result.cols == 4);
+    assert(result.matrix.size() == 12);
+    assert(result.matches.size() == 3);
+
+    // sum -> 2, find -> 3, fact -> 1
+    int expected[] = {2, 3, 1};
+    for (const auto& match : result.matches) {
+        assert(match.function2 == expected[match.function1]);
+        assert(match.similarity > 0.9);
+    }
+
+    // The unmatched function weighs on the aggregate
+    assert(result.score.overall < 1.0 && result.score.overall > 0.6);
+    auto self = scorer.calculateFunctions(functions1, functions1);
+    assert(self.score.overall > 0.99);
+    std::cout << "✓ Function matrix test passed (Score: " << result.score.overall * 100 << "%)" << std::endl;
+}
+
+void test_function_screening() {
+    Normalizer normalizer;
+    CFGBuilder builder;
+    Scorer full, screened;
+    full.setFunctionScreening(0);
+    screened.setFunctionScreening(1);
+
+    std::string sum = "int sum(int n) { int s = 0; for (int i = 0; i < n; i++) { s += i; } return s; }\n";
+    std::string fact = "long fact(int n) { if (n <= 1) { return 1; } return n * fact(n - 1); }\n";
+    std::string other = "void log(int level) { switch (level) { case 0: a(); break; default: b(); } }\n";
+    auto functions1 = builder.buildFunctions(normalizer.process(sum + fact + other));
+    auto functions2 = builder.buildFunctions(normalizer.process(other + fact + sum));
+
+    auto all = full.calculateFunctions(functions1, functions2);
+    auto some = screened.calculateFunctions(functions1, functions2);
+
+    // Same pairing and aggregate, fewer pairs scored
+    assert(all.matches.size() == some.matches.size());
+    for (std::size_t k = 0; k < all.matches.size(); k++) {
+        assert(all.matches[k].function2 == some.matches[k].function2);
+    }
+    assert(std::abs(all.score.overall - some.score.overall) < 1e-9);
+    int scored = 0;
+    for (double value : some.matrix) {
+        scored += value > 0.0;
+    }
+    assert(scored < static_cast<int>(all.matrix.size()));
+    std::cout << "✓ Function screening test passed (" << scored << " of " << all.matrix.size()
+              << " pairs scored)" << std::endl;
+}
+
+void test_threshold_scoring() {
+    Normalizer normalizer;
+    CFGBuilder builder;
+    std::vector<std::string> codes = {
+        "int sum = 0; for (int i = 0; i < 10; i++) { sum = sum + i; }",
+        "int total = 0; for (int j = 0; j < 10; j++) { total = total + j; }",
+        "int sum = 0; sum = sum + 5;",
+        "if (x > 0) { return x; } else { return 0; }",
+        "while (n > 1) { if (n % 2 == 0) { n = n / 2; } else { n = 3 * n + 1; } steps++; }",
+        "switch (k) { case 0: a(); break; case 1: b(); break; default: c(); }",
+        "int m = a; if (b > m) { m = b; } if (c > m) { m = c; } return m;",
+        "",
+    };
+    std::vector<CFGBuilder::CFG> cfgs;
+    for (const auto& code : codes) {
+        cfgs.push_back(builder.build(normalizer.process(code)));
+    }
+
+    Fingerprinter fingerprinter;
+    std::vector<std::vector<std::uint64_t>> fingerprints;
+    for (const auto& cfg : cfgs) {
+        fingerprints.push_back(Fingerprinter::hashSet(fingerprinter.fingerprint(cfg)));
+    }
+
+    for (double fingerprint : {0.0, 0.2}) {
+        Scorer scorer;
+        scorer.setWeights(0.4, 0.6 - fingerprint, fingerprint);
+        for (double threshold : {0.3, 0.6, 0.9}) {
+            int below = 0;
+            for (std::size_t i = 0; i < cfgs.size(); i++) {
+                for (std::size_t j = 0; j < cfgs.size(); j++) {
+                    const auto& cfg1 = cfgs[i];
+                    const auto& cfg2 = cfgs[j];
+                    Scorer::Score exact = scorer.calculate(cfg1, cfg2);
+                    Scorer::Score result;
+                    bool reached = scorer.calculateAbove(cfg1, cfg2, threshold, result);
+
+                    // Hash sets computed beforehand give the same result
+                    Scorer::Score hashed;
+                    assert(scorer.calculateAbove(cfg1, cfg2, fingerprints[i], fingerprints[j], threshold,
+                                                 hashed) == reached);
+                    assert(hashed.overall == result.overall && hashed.fingerprint == result.fingerprint);
+
+                    // Exact score when reached, a valid bound below the
+                    // threshold otherwise. Unweighted fingerprints are
+                    // not computed, except for two empty files.
+                    assert(reached == (exact.overall >= threshold));
+                    if (reached) {
+                        bool computed = fingerprint > 0.0 || (cfg1.blocks.empty() && cfg2.blocks.empty());
+                        double fingerprint_overlap = computed ? exact.fingerprint : 0.0;
+                        assert(result.overall == exact.overall && result.structural == exact.structural &&
+                               result.semantic == exact.semantic && result.fingerprint == fingerprint_overlap &&
+                               result.matched_blocks == exact.matched_blocks);
+                    } else {
+                        assert(result.overall < threshold && result.overall >= exact.overall - 1e-9);
+                        below++;
+                    }
+                }
+            }
+            assert(below > 0);
+        }
+    }
+    std::cout << "✓ Threshold scoring test passed" << std::endl;
+}
+
+void test_batch_scoring() {
+    Normalizer normalizer;
+    CFGBuilder builder;
+    std::vector<std::string> codes = {
+        "int total = 0; for (int j = 0; j < 10; j++) { total = total + j; }",
+        "int sum = 0; sum = sum + 5;",
+        "if (x > 0) { return x; } else { return 0; }",
+        "while (n > 1) { if (n % 2 == 0) { n = n / 2; } else { n = 3 * n + 1; } steps++; }",
+        "int m = a; if (b > m) { m = b; } if (c > m) { m = c; } return m;",
+        "",
+    };
+    std::vector<CFGBuilder::CFG> cfgs;
+    for (const auto& code : codes) {
+        cfgs.push_back(builder.build(normalizer.process(code)));
+    }
+    auto query = builder.build(normalizer.process("int sum = 0; for (int i = 0; i < 10; i++) { sum = sum + i; }"));
+
+    // More candidates than one chunk of blocks holds
+    std::vector<const CFGBuilder::CFG*> candidates;
+    for (int k = 0; k < 150; k++) {
+        candidates.push_back(&cfgs[k % cfgs.size()]);
+    }
+
+    Fingerprinter fingerprinter;
+    std::vector<std::vector<std::uint64_t>> hash_sets;
+    for (const auto& cfg : cfgs) {
+        hash_sets.push_back(Fingerprinter::hashSet(fingerprinter.fingerprint(cfg)));
+    }
+    std::vector<Span<std::uint64_t>> fingerprints;
+    for (std::size_t k = 0; k < candidates.size(); k++) {
+        fingerprints.push_back(hash_sets[k % cfgs.size()]);
+    }
+
+    for (double fingerprint : {0.0, 0.2}) {
+        Scorer scorer;
+        scorer.setWeights(0.4, 0.6 - fingerprint, fingerprint);
+        for (double threshold : {0.0, 0.6}) {
+            for (bool given : {false, true}) {
+                std::vector<std::size_t> reported;
+                auto check = [&](std::size_t k, const Scorer::Score& score) {
+                    Scorer::Score exact = scorer.calculate(query, *candidates[k]);
+                    double fingerprint_overlap = fingerprint > 0.0 ? exact.fingerprint : 0.0;
+                    assert(score.overall == exact.overall && score.structural == exact.structural &&
+                           score.semantic == exact.semantic && score.fingerprint == fingerprint_overlap &&
+                           score.matched_blocks == exact.matched_blocks);
+                    reported.push_back(k);
+                };
+                if (given) {
+                    scorer.calculateBatch(query, candidates, threshold, check, fingerprints);
+                } else {
+                    scorer.calculateBatch(query, candidates, threshold, check);
+                }
+
+                // Every candidate that reaches the threshold, in order
+                std::vector<std::size_t> expected;
+                for (std::size_t k = 0; k < candidates.size(); k++) {
+                    if (scorer.calculate(query, *candidates[k]).overall >= threshold) {
+                        expected.push_back(k);
+                    }
+                }
+                assert(reported == expected);
+                assert(threshold > 0.0 || reported.size() == candidates.size());
+            }
+        }
+    }
+    std::cout << "✓ Batch scoring test passed" << std::endl;
+}
+
 int main() {
     std::cout << "Running Scorer tests..." << std::endl;
     
     test_identical_code();
     test_different_code();
     test_empty_code();
+    test_unrelated_files();
     test_weight_setting();
     test_score_bounds();
+    test_function_matrix();
+    test_function_screening();
+    test_threshold_scoring();
+    test_batch_scoring();
     
     std::cout << "All Scorer tests passed!" << std::endl;
     return 0;
@@ -4,6 +4,15 @@
 #include <iostream>
 #include <cassert>
 
+// A standalone block over `tokens`, signed the way CFGBuilder signs blocks
+BasicBlock makeBlock(int id, const std::vector<Token>& tokens) {
+    BasicBlock block;
+    block.id = id;
+    block.token_count = static_cast<std::uint32_t>(tokens.size());
+    CFGBuilder::computeFeatures(block, tokens);
+    return block;
+}
+
 void test_identical_blocks() {
     SemanticHasher hasher;
     Normalizer normalizer;
@@ -15,8 +24,8 @@ void test_identical_blocks() {
     auto tokens1 = normalizer.process(code1);
     auto tokens2 = normalizer.process(code2);
     
-    BasicBlock block1 = {1, tokens1, {}};
-    BasicBlock block2 = {2, tokens2, {}};
+    BasicBlock block1 = makeBlock(1, tokens1);
+    BasicBlock block2 = makeBlock(2, tokens2);
     
     std::string hash1 = hasher.hashBlock(block1);
     std::string hash2 = hasher.hashBlock(block2);
@@ -36,8 +45,8 @@ void test_different_operations() {
     auto tokens1 = normalizer.process(code1);
     auto tokens2 = normalizer.process(code2);
     
-    BasicBlock block1 = {1, tokens1, {}};
-    BasicBlock block2 = {2, tokens2, {}};
+    BasicBlock block1 = makeBlock(1, tokens1);
+    BasicBlock block2 = makeBlock(2, tokens2);
     
     double similarity = hasher.compareBlocks(block1, block2);
     
@@ -56,8 +65,8 @@ void test_completely_different() {
     auto tokens1 = normalizer.process(code1);
     auto tokens2 = normalizer.process(code2);
     
-    BasicBlock block1 = {1, tokens1, {}};
-    BasicBlock block2 = {2, tokens2, {}};
+    BasicBlock block1 = makeBlock(1, tokens1);
+    BasicBlock block2 = makeBlock(2, tokens2);
     
     double similarity = hasher.compareBlocks(block1, block2);
     
@@ -69,8 +78,8 @@ void test_completely_different() {
 void test_empty_blocks() {
     SemanticHasher hasher;
     
-    BasicBlock empty1 = {1, {}, {}};
-    BasicBlock empty2 = {2, {}, {}};
+    BasicBlock empty1 = makeBlock(1, {});
+    BasicBlock empty2 = makeBlock(2, {});
     
     std::string hash1 = hasher.hashBlock(empty1);
     std::string hash2 = hasher.hashBlock(empty2);
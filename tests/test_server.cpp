@@ -0,0 +1,277 @@
+#include "../include/CorpusIndex.h"
+#include "../include/Server.h"
+#include "../include/Utils/Json.h"
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+const std::string kSum = "int sum(int n) { int s = 0; for (int i = 0; i < n; i++) { s += i; } return s; }\n";
+const std::string kFind =
+    "int find(int* v, int n, int x) { for (int i = 0; i < n; i++) { if (v[i] == x) { return i; } } return -1; }\n";
+const std::string kLog = "void log(int level) { switch (level) { case 0: a(); break; default: b(); } }\n";
+
+std::string request(const std::string& op, const std::vector<std::pair<std::string, std::string>>& strings,
+                    const std::string& extra = "") {
+    std::string line = "{\"op\":" + Json::quote(op);
+    for (const auto& member : strings) {
+        line += "," + Json::quote(member.first) + ":" + Json::quote(member.second);
+    }
+    return line + extra + "}";
+}
+
+Json::Object reply(const std::string& text) {
+    Json::Object object;
+    std::string error;
+    bool parsed = Json::parseObject(text, object, error);
+    assert(parsed);
+    return object;
+}
+
+void test_json() {
+    Json::Object object;
+    std::string error;
+    assert(Json::parseObject(R"( {"a":"x\nyé\"","b":-1.5e3,"c":true,"d":null} )", object, error));
+    assert(object["a"] == "x\ny\xc3\xa9\"");
+    assert(object["b"] == "-1.5e3" && object["c"] == "true" && object["d"] == "null");
+    assert(Json::parseObject("{}", object, error) && object.empty());
+
+    assert(!Json::parseObject(R"({"a":[1]})", object, error));
+    assert(!Json::parseObject(R"({"a":1} x)", object, error));
+    assert(!Json::parseObject(R"({"a":"open)", object, error));
+    assert(!Json::parseObject(R"({"a":1e})", object, error));
+
+    // Round trip through quote()
+    std::string text = "tab\t quote\" slash\\ bell\x07";
+    assert(Json::parseObject("{\"t\":" + Json::quote(text) + "}", object, error) && object["t"] == text);
+    assert(Json::number(0.25) == "0.25" && Json::number(1.0 / 0.0) == "null");
+    std::cout << "✓ JSON test passed" << std::endl;
+}
+
+void test_requests() {
+    CorpusIndex index(2);
+    index.add("sum.cpp", kSum);
+    index.add("log.cpp", kLog);
+    Server server(index);
+
+    auto ping = reply(server.handle(R"({"op":"ping"})"));
+    assert(ping["ok"] == "true" && ping["entries"] == "2");
+
+    auto compare = reply(server.handle(request("compare", {{"code1", kSum}, {"code2", kSum}})));
+    assert(compare["ok"] == "true" && std::stod(compare["overall"]) > 0.99);
+
+    auto added = reply(server.handle(request("add", {{"path", "find.cpp"}, {"code", kFind}})));
+    assert(added["ok"] == "true" && added["id"] == "2" && index.size() == 3);
+
+    // Results are an array, which this reader does not take apart
+    std::string found = server.handle(request("query", {{"code", kFind}}, ",\"top\":1"));
+    assert(found.find("\"ok\":true") != std::string::npos);
+    assert(found.find("\"path\":\"find.cpp\"") != std::string::npos);
+    assert(found.find("sum.cpp") == std::string::npos);
+
+    // Huge counts are clamped; infinite or NaN numbers are refused
+    found = server.handle(request("query", {{"code", kFind}}, ",\"top\":1e300,\"screen\":-1e300"));
+    assert(found.find("\"ok\":true") != std::string::npos && found.find("sum.cpp") != std::string::npos);
+    assert(reply(server.handle(request("query", {{"code", kFind}}, ",\"top\":1e999")))["ok"] == "false");
+    assert(reply(server.handle(request("query", {{"code", kFind}, {"screen", "nan"}})))["ok"] == "false");
+    assert(reply(server.handle(request("query", {{"code", kFind}, {"min_score", "-inf"}})))["ok"] == "false");
+
+    assert(reply(server.handle("not json"))["ok"] == "false");
+    assert(reply(server.handle(R"({"op":"fly"})"))["ok"] == "false");
+    assert(reply(server.handle(R"({"op":"compare","code1":"x"})"))["ok"] == "false");
+    assert(reply(server.handle(R"({"op":"add","path":"missing_file.cpp"})"))["ok"] == "false");
+    std::cout << "✓ Request test passed" << std::endl;
+}
+
+int connectTo(const std::string& path) {
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    std::snprintf(address.sun_path, sizeof(address.sun_path), "%s", path.c_str());
+    for (int attempt = 0; attempt < 100; attempt++) {
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) {
+            return fd;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    assert(false);
+    return -1;
+}
+
+std::string roundTrip(int fd, const std::string& line) {
+    std::string data = line + "\n";
+    assert(::send(fd, data.data(), data.size(), 0) == static_cast<ssize_t>(data.size()));
+    std::string response;
+    char c;
+    while (::recv(fd, &c, 1, 0) == 1 && c != '\n') {
+        response += c;
+    }
+    return response;
+}
+
+void test_socket() {
+    CorpusIndex index(2);
+    index.add("sum.cpp", kSum);
+    ServerOptions options;
+    options.socket_path = "test_server.sock";
+    options.threads = 4;
+    Server server(index, options);
+    assert(server.listen());
+    std::thread runner([&] { server.run(); });
+
+    // Clients at once, each with several requests on its connection
+    std::vector<std::thread> clients;
+    for (int c = 0; c < 4; c++) {
+        clients.emplace_back([&, c] {
+            int fd = connectTo(options.socket_path);
+            for (int r = 0; r < 5; r++) {
+                auto compare = reply(roundTrip(fd, request("compare", {{"code1", kSum}, {"code2", kFind}})));
+                assert(compare["ok"] == "true");
+                std::string found = roundTrip(fd, request("query", {{"code", kSum}}));
+                assert(found.find("\"path\":\"sum.cpp\"") != std::string::npos);
+            }
+            auto added = reply(roundTrip(fd, request("add", {{"path", "f" + std::to_string(c)}, {"code", kLog}})));
+            assert(added["ok"] == "true");
+            ::close(fd);
+        });
+    }
+    for (std::thread& client : clients) {
+        client.join();
+    }
+    assert(index.size() == 5);
+
+    int fd = connectTo(options.socket_path);
+    assert(reply(roundTrip(fd, R"({"op":"shutdown"})"))["ok"] == "true");
+    ::close(fd);
+    runner.join();
+    std::cout << "✓ Socket test passed" << std::endl;
+}
+
+// Many renamed copies of the small programs, for requests that take a while
+std::string largeProgram(int copies) {
+    std::string code;
+    for (int c = 0; c < copies; c++) {
+        std::string suffix = std::to_string(c);
+        for (const std::string& function : {kSum, kFind, kLog}) {
+            std::string renamed = function;
+            renamed.insert(renamed.find('('), suffix);
+            code += renamed;
+        }
+    }
+    return code;
+}
+
+void test_slow_connection() {
+    CorpusIndex index(2);
+    for (int f = 0; f < 12; f++) {
+        index.add("large" + std::to_string(f) + ".cpp", largeProgram(120 + f));
+    }
+    index.add("sum.cpp", kSum);
+    ServerOptions options;
+    options.socket_path = "test_server_slow.sock";
+    options.threads = 4;
+    Server server(index, options);
+    assert(server.listen());
+    std::thread runner([&] { server.run(); });
+
+    // One connection scores the large files against each other while
+    // another asks small questions; those must not wait for it
+    using Clock = std::chrono::steady_clock;
+    auto seconds = [](Clock::time_point start, Clock::time_point end) {
+        return std::chrono::duration<double>(end - start).count();
+    };
+    Clock::time_point slow_start = Clock::now(), slow_end;
+    std::thread slow([&] {
+        int fd = connectTo(options.socket_path);
+        std::string found = roundTrip(fd, request("query", {{"code", largeProgram(125)}}, ",\"screen\":12"));
+        slow_end = Clock::now();
+        assert(found.find("\"ok\":true") != std::string::npos);
+        ::close(fd);
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    Clock::time_point fast_start = Clock::now();
+    int fd = connectTo(options.socket_path);
+    for (int r = 0; r < 5; r++) {
+        auto compare = reply(roundTrip(fd, request("compare", {{"code1", kSum}, {"code2", kFind}})));
+        assert(compare["ok"] == "true");
+        std::string found = roundTrip(fd, request("query", {{"code", kSum}}, ",\"top\":1,\"screen\":1"));
+        assert(found.find("\"path\":\"sum.cpp\"") != std::string::npos);
+    }
+    double fast = seconds(fast_start, Clock::now());
+    ::close(fd);
+    slow.join();
+    double slowest = seconds(slow_start, slow_end);
+    assert(fast < 0.25 * slowest);
+
+    fd = connectTo(options.socket_path);
+    assert(reply(roundTrip(fd, R"({"op":"shutdown"})"))["ok"] == "true");
+    ::close(fd);
+    runner.join();
+    std::cout << "✓ Slow connection test passed (" << fast * 1e3 << " ms beside a " << slowest * 1e3
+              << " ms request)" << std::endl;
+}
+
+void test_idle_connections() {
+    CorpusIndex index(1);
+    index.add("sum.cpp", kSum);
+    ServerOptions options;
+    options.socket_path = "test_server_idle.sock";
+    options.threads = 1;
+    Server server(index, options);
+    assert(server.listen());
+    std::thread runner([&] { server.run(); });
+
+    // More open connections than workers, all silent or halfway through a
+    // request; none of them may hold up a new client
+    std::vector<int> idle;
+    for (int c = 0; c < 4; c++) {
+        idle.push_back(connectTo(options.socket_path));
+    }
+    std::string partial = R"({"op":"pi)";
+    assert(::send(idle[0], partial.data(), partial.size(), 0) == static_cast<ssize_t>(partial.size()));
+
+    int fd = connectTo(options.socket_path);
+    timeval timeout = {2, 0};  // fail instead of hanging
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    auto start = std::chrono::steady_clock::now();
+    assert(reply(roundTrip(fd, R"({"op":"ping"})"))["ok"] == "true");
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    assert(elapsed < 1.0);
+
+    // The idle ones still work, the partial request included
+    ::setsockopt(idle[0], SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    assert(reply(roundTrip(idle[0], R"(ng"})"))["ok"] == "true");
+    ::setsockopt(idle[3], SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    assert(reply(roundTrip(idle[3], R"({"op":"ping"})"))["ok"] == "true");
+
+    assert(reply(roundTrip(fd, R"({"op":"shutdown"})"))["ok"] == "true");
+    ::close(fd);
+    runner.join();
+    for (int other : idle) {
+        ::close(other);
+    }
+    std::cout << "✓ Idle connections test passed (" << elapsed * 1e3 << " ms ping beside " << idle.size()
+              << " idle connections)" << std::endl;
+}
+
+int main() {
+    std::cout << "Running Server tests..." << std::endl;
+
+    test_json();
+    test_requests();
+    test_socket();
+    test_slow_connection();
+    test_idle_connections();
+
+    std::cout << "All Server tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,107 @@
+#include "../include/Utils/StringUtils.h"
+#include <iostream>
+#include <algorithm>
+#include <cassert>
+#include <random>
+#include <string>
+#include <vector>
+
+template <typename Sequence>
+int naiveDistance(const Sequence& a, const Sequence& b) {
+    std::vector<std::vector<int>> dp(a.size() + 1, std::vector<int>(b.size() + 1));
+    for (size_t i = 0; i <= a.size(); i++) dp[i][0] = static_cast<int>(i);
+    for (size_t j = 0; j <= b.size(); j++) dp[0][j] = static_cast<int>(j);
+    for (size_t i = 1; i <= a.size(); i++) {
+        for (size_t j = 1; j <= b.size(); j++) {
+            int cost = a[i - 1] == b[j - 1] ? 0 : 1;
+            dp[i][j] = std::min({dp[i - 1][j] + 1, dp[i][j - 1] + 1, dp[i - 1][j - 1] + cost});
+        }
+    }
+    return dp[a.size()][b.size()];
+}
+
+std::string randomString(std::mt19937& rng, size_t length, int alphabet) {
+    std::string s;
+    for (size_t i = 0; i < length; i++) {
+        s += static_cast<char>('a' + rng() % alphabet);
+    }
+    return s;
+}
+
+// A copy of `s` with a few random edits, so distances stay small
+std::string mutate(std::mt19937& rng, std::string s, int edits) {
+    for (int e = 0; e < edits; e++) {
+        size_t at = s.empty() ? 0 : rng() % s.size();
+        switch (rng() % 3) {
+            case 0: s.insert(s.begin() + at, 'z'); break;
+            case 1: if (!s.empty()) s.erase(s.begin() + at); break;
+            default: if (!s.empty()) s[at] = 'y'; break;
+        }
+    }
+    return s;
+}
+
+void test_basic_distances() {
+    assert(StringUtils::calculateLevenshteinDistance("", "") == 0);
+    assert(StringUtils::calculateLevenshteinDistance("abc", "") == 3);
+    assert(StringUtils::calculateLevenshteinDistance("", "abcd") == 4);
+    assert(StringUtils::calculateLevenshteinDistance("kitten", "sitting") == 3);
+    assert(StringUtils::calculateLevenshteinDistance("flaw", "lawn") == 2);
+    assert(StringUtils::calculateLevenshteinDistance("same", "same") == 0);
+    std::cout << "✓ Basic distance test passed" << std::endl;
+}
+
+void test_word_boundaries() {
+    std::mt19937 rng(7);
+    const size_t lengths[] = {0, 1, 2, 63, 64, 65, 127, 128, 129, 200};
+    for (size_t m : lengths) {
+        for (size_t n : lengths) {
+            for (int alphabet : {2, 4, 26}) {
+                std::string a = randomString(rng, m, alphabet);
+                std::string b = randomString(rng, n, alphabet);
+                assert(StringUtils::calculateLevenshteinDistance(a, b) == naiveDistance(a, b));
+            }
+        }
+    }
+    std::cout << "✓ Word boundary test passed" << std::endl;
+}
+
+void test_token_sequences() {
+    std::mt19937 rng(11);
+    for (int round = 0; round < 50; round++) {
+        std::vector<std::uint32_t> a(rng() % 150), b(rng() % 150);
+        for (auto& symbol : a) symbol = 1024 + rng() % 6;  // ids beyond a byte
+        for (auto& symbol : b) symbol = 1024 + rng() % 8;
+        assert(StringUtils::calculateLevenshteinDistance(a, b) == naiveDistance(a, b));
+    }
+    std::cout << "✓ Token sequence test passed" << std::endl;
+}
+
+void test_bounded_distance() {
+    std::mt19937 rng(13);
+    for (int round = 0; round < 200; round++) {
+        std::string a = randomString(rng, rng() % 300, 4);
+        std::string b = round % 2 ? mutate(rng, a, rng() % 12) : randomString(rng, rng() % 300, 4);
+        int exact = naiveDistance(a, b);
+        for (int bound : {0, 1, 3, 8, 20, 100, 400}) {
+            int bounded = StringUtils::calculateLevenshteinDistance(a, b, bound);
+            assert(bounded == std::min(exact, bound + 1));
+        }
+
+        std::vector<std::uint32_t> ta(a.begin(), a.end()), tb(b.begin(), b.end());
+        assert(StringUtils::calculateLevenshteinDistance(ta, tb, 5) == std::min(exact, 6));
+    }
+    std::cout << "✓ Bounded distance test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "Running StringUtils tests..." << std::endl;
+
+    test_basic_distances();
+    test_word_boundaries();
+    test_token_sequences();
+    test_bounded_distance();
+
+    std::cout << "All StringUtils tests passed!" << std::endl;
+    return 0;
+}
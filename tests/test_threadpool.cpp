@@ -0,0 +1,109 @@
+#include "../include/Utils/ThreadPool.h"
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+double milliseconds(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+void test_parallel_for_covers_range() {
+    ThreadPool pool(4);
+    std::vector<int> hits(1000, 0);
+    pool.parallelFor(hits.size(), 7, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) {
+            hits[i]++;
+        }
+    });
+    for (int hit : hits) {
+        assert(hit == 1);
+    }
+    pool.parallelFor(0, 4, [](std::size_t, std::size_t) { assert(false); });
+    std::cout << "✓ parallelFor covers range test passed" << std::endl;
+}
+
+void test_nested_parallel_for() {
+    // Tasks that run parallelFor themselves, with every worker busy
+    ThreadPool pool(2);
+    std::atomic<int> total{0};
+    for (int t = 0; t < 4; t++) {
+        pool.submit([&] {
+            pool.parallelFor(4, 1, [&](std::size_t, std::size_t) {
+                pool.parallelFor(3, 1, [&](std::size_t, std::size_t) { total++; });
+            });
+        });
+    }
+    pool.wait();
+    assert(total == 4 * 4 * 3);
+    std::cout << "✓ Nested parallelFor test passed" << std::endl;
+}
+
+void test_concurrent_callers() {
+    ThreadPool pool(2);
+    std::atomic<bool> slow_started{false};
+    std::thread slow([&] {
+        try {
+            pool.parallelFor(1, 1, [&](std::size_t, std::size_t) {
+                slow_started = true;
+                std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+                throw std::runtime_error("slow caller failed");
+            });
+            assert(false);
+        } catch (const std::runtime_error&) {
+        }
+    });
+    while (!slow_started) {
+        std::this_thread::yield();
+    }
+
+    // A cheap call finishes without waiting for the slow one, and never
+    // sees its exception
+    auto start = Clock::now();
+    std::atomic<int> chunks{0};
+    pool.parallelFor(4, 1, [&](std::size_t, std::size_t) { chunks++; });
+    double elapsed = milliseconds(start);
+    assert(chunks == 4);
+    assert(elapsed < 500);
+
+    slow.join();
+    std::cout << "✓ Concurrent callers test passed (" << elapsed << " ms while another call ran)" << std::endl;
+}
+
+void test_exception_propagates() {
+    ThreadPool pool(3);
+    bool caught = false;
+    try {
+        pool.parallelFor(10, 1, [](std::size_t begin, std::size_t) {
+            if (begin == 5) {
+                throw std::runtime_error("chunk failed");
+            }
+        });
+    } catch (const std::runtime_error&) {
+        caught = true;
+    }
+    assert(caught);
+
+    // The pool stays usable
+    std::atomic<int> count{0};
+    pool.parallelFor(10, 3, [&](std::size_t begin, std::size_t end) { count += static_cast<int>(end - begin); });
+    assert(count == 10);
+    std::cout << "✓ Exception propagation test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "Running ThreadPool tests..." << std::endl;
+
+    test_parallel_for_covers_range();
+    test_nested_parallel_for();
+    test_concurrent_callers();
+    test_exception_propagates();
+
+    std::cout << "All ThreadPool tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,142 @@
+#include "../include/CFGBuilder.h"
+#include "../include/Normalizer.h"
+#include "../include/WLKernel.h"
+#include "../include/Utils/GraphUtils.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <string>
+
+CFGBuilder::CFG buildCFG(const std::string& code) {
+    Normalizer normalizer;
+    CFGBuilder builder;
+    return builder.build(normalizer.process(code));
+}
+
+const std::string kLoop =
+    "int total = 0;\n"
+    "for (int i = 0; i < n; i++) {\n"
+    "    if (v[i] > 0) { total += v[i]; } else { total -= 1; }\n"
+    "}\n"
+    "return total;\n";
+
+void test_renamed_code_is_identical() {
+    WLKernel kernel;
+    std::string renamed =
+        "int acc = 0;\n"
+        "for (int k = 0; k < count; k++) {\n"
+        "    if (data[k] > 0) { acc += data[k]; } else { acc -= 1; }\n"
+        "}\n"
+        "return acc;\n";
+    WLVector vector1 = kernel.vectorize(buildCFG(kLoop));
+    WLVector vector2 = kernel.vectorize(buildCFG(renamed));
+    assert(!vector1.features.empty());
+    assert(WLKernel::cosine(vector1, vector1) > 0.999);
+    assert(WLKernel::cosine(vector1, vector2) > 0.999);
+
+    // Features are sorted and distinct
+    for (std::size_t i = 1; i < vector1.features.size(); i++) {
+        assert(vector1.features[i].index > vector1.features[i - 1].index);
+    }
+    std::cout << "✓ Renamed code test passed (" << vector1.features.size() << " features)" << std::endl;
+}
+
+void test_structure_changes_score() {
+    WLKernel kernel;
+    // Same statements, but the branch moved out of the loop
+    std::string hoisted =
+        "int total = 0;\n"
+        "if (v[i] > 0) { total += v[i]; } else { total -= 1; }\n"
+        "for (int i = 0; i < n; i++) {\n"
+        "}\n"
+        "return total;\n";
+    std::string unrelated =
+        "switch (mode) { case 0: a(); break; case 1: b(); break; default: c(); }\n"
+        "while (x) { x = next(x); }\n";
+    WLVector loop = kernel.vectorize(buildCFG(kLoop));
+    double moved = WLKernel::cosine(loop, kernel.vectorize(buildCFG(hoisted)));
+    double other = WLKernel::cosine(loop, kernel.vectorize(buildCFG(unrelated)));
+    assert(moved < 0.999);
+    assert(other < moved);
+    assert(other >= 0.0);
+
+    // Round 0 only sees block contents, so the moved branch matches there
+    WLKernel seeds(WLOptions{0, 20});
+    assert(WLKernel::cosine(seeds.vectorize(buildCFG(kLoop)), seeds.vectorize(buildCFG(hoisted))) >
+           moved);
+    std::cout << "✓ Structure test passed (moved: " << moved << ", unrelated: " << other << ")" << std::endl;
+}
+
+void test_relabeling() {
+    WLKernel kernel;
+    auto cfg = buildCFG(kLoop);
+    auto seeds = kernel.labels(cfg, 0);
+    auto round1 = kernel.labels(cfg, 1);
+    assert(seeds.size() == cfg.blocks.size() && round1.size() == cfg.blocks.size());
+    for (std::size_t b = 0; b < cfg.blocks.size(); b++) {
+        assert(seeds[b] == cfg.blocks[b].features.semantic_signature);
+    }
+
+    // Relabeling never merges blocks with different labels
+    auto distinct = [](std::vector<std::uint64_t> labels) {
+        std::sort(labels.begin(), labels.end());
+        return std::unique(labels.begin(), labels.end()) - labels.begin();
+    };
+    assert(distinct(round1) >= distinct(seeds));
+
+    // Empty CFGs
+    CFGBuilder::CFG empty;
+    assert(kernel.vectorize(empty).features.empty());
+    assert(WLKernel::cosine(kernel.vectorize(empty), kernel.vectorize(empty)) == 1.0);
+    assert(WLKernel::cosine(kernel.vectorize(empty), kernel.vectorize(cfg)) == 0.0);
+    std::cout << "✓ Relabeling test passed" << std::endl;
+}
+
+void test_label_similarity() {
+    // Same sizes, different labels
+    assert(GraphAlgorithms::calculateSimilarity({1, 2, 3}, {4, 5, 6}) == 0.0);
+    assert(GraphAlgorithms::calculateSimilarity({1, 2, 2}, {2, 1, 2}) == 1.0);
+    assert(GraphAlgorithms::calculateSimilarity({1, 2}, {1, 2, 3, 4}) == 0.5);
+    assert(GraphAlgorithms::calculateSimilarity({}, {}) == 1.0);
+
+    WLKernel kernel;
+    auto cfg = buildCFG(kLoop);
+    auto labels = kernel.labels(cfg, 2);
+    std::vector<int> folded(labels.begin(), labels.end());
+    assert(GraphAlgorithms::calculateSimilarity(folded, folded) == 1.0);
+    std::cout << "✓ Label similarity test passed" << std::endl;
+}
+
+void test_screening_speed() {
+    WLKernel kernel;
+    std::string code;
+    for (int i = 0; i < 20; i++) {
+        code += kLoop;
+    }
+    WLVector vector1 = kernel.vectorize(buildCFG(code));
+    WLVector vector2 = kernel.vectorize(buildCFG(code + kLoop));
+
+    const int pairs = 10000;
+    double sum = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < pairs; i++) {
+        sum += WLKernel::cosine(vector1, vector2);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    assert(sum / pairs > 0.9);
+    std::cout << "✓ Screening speed test passed (" << seconds * 1e6 / pairs << " us per pair)" << std::endl;
+}
+
+int main() {
+    std::cout << "Running WLKernel tests..." << std::endl;
+
+    test_renamed_code_is_identical();
+    test_structure_changes_score();
+    test_relabeling();
+    test_label_similarity();
+    test_screening_speed();
+
+    std::cout << "All WLKernel tests passed!" << std::endl;
+    return 0;
+}